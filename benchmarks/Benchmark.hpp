@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Minimal benchmark runner, see Main.cpp. Not built with the solution by default, build AvokiiBenchmarks explicitly (Release).
+//
+// A benchmark reports its own measurements and returns false if one of its checks failed:
+//   AV_BENCHMARK( JobSystem_Scaling ) { ...; Benchmarks::Report( "1 worker", ms, "ms" ); return Benchmarks::Check( ok, "sum" ); }
+namespace Avokii::Benchmarks
+{
+	using BenchmarkFunc_T = bool (*)();
+
+	struct BenchmarkEntry
+	{
+		std::string_view name;
+		BenchmarkFunc_T func;
+	};
+
+	inline std::vector<BenchmarkEntry>& rGetBenchmarks()
+	{
+		static std::vector<BenchmarkEntry> benchmarks;
+		return benchmarks;
+	}
+
+	struct Registrar
+	{
+		Registrar( std::string_view name, BenchmarkFunc_T func ) { rGetBenchmarks().push_back( { name, func } ); }
+	};
+
+	// Best of `repeats` runs of `func`, in nanoseconds per iteration when one run does `iterations` of something
+	template<class Func>
+	double Measure( Func&& func, size_t iterations = 1, int repeats = 5 )
+	{
+		using Clock_T = std::chrono::steady_clock;
+
+		func(); // warm up
+
+		double best_ns = 1.0e300;
+		for (int i = 0; i < repeats; ++i)
+		{
+			const auto start = Clock_T::now();
+			func();
+			best_ns = std::min( best_ns, std::chrono::duration<double, std::nano>( Clock_T::now() - start ).count() );
+		}
+		return best_ns / static_cast<double>( std::max<size_t>( iterations, 1 ) );
+	}
+
+	// Powers of two up to one worker per core, leaving one for the main thread
+	inline std::vector<uint32_t> GetWorkerCounts()
+	{
+		const uint32_t hardware_threads = std::max( std::thread::hardware_concurrency(), 2u );
+		std::vector<uint32_t> counts;
+		for (uint32_t n = 1; n < hardware_threads - 1; n *= 2)
+			counts.push_back( n );
+		counts.push_back( hardware_threads - 1 );
+		return counts;
+	}
+
+	inline void Report( std::string_view what, double value, std::string_view unit )
+	{
+		std::printf( "  %-48.*s %12.3f %.*s\n", static_cast<int>( what.size() ), what.data(), value, static_cast<int>( unit.size() ), unit.data() );
+	}
+
+	inline bool Check( bool condition, std::string_view what )
+	{
+		if (!condition)
+			std::printf( "  CHECK FAILED: %.*s\n", static_cast<int>( what.size() ), what.data() );
+		return condition;
+	}
+}
+
+#define AV_BENCHMARK( name ) \
+	static bool Benchmark_##name(); \
+	static const ::Avokii::Benchmarks::Registrar BenchmarkRegistrar_##name{ #name, &Benchmark_##name }; \
+	static bool Benchmark_##name()
@@ -0,0 +1,94 @@
+#include "Benchmark.hpp"
+
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Avokii/Containers/FlatHashMap.hpp"
+#include "Avokii/Resources/ResourceId.hpp"
+
+namespace
+{
+	using namespace Avokii;
+
+	// 1k to 1M keys, growing by four
+	constexpr size_t MinKeys = 1 << 10;
+	constexpr size_t MaxKeys = 1 << 20;
+
+	struct MapResults
+	{
+		uint64_t found_sum = 0;
+		size_t n_missed = 0;
+		size_t size_after_erase = 0;
+	};
+
+	// Inserts `keys`, finds each of them, looks up `missing` (none of which are in the map), then erases every other key
+	template<class Map_T>
+	MapResults RunMap( const std::string& name, std::span<const ResourceId> keys, std::span<const ResourceId> missing )
+	{
+		MapResults results;
+		Map_T map;
+
+		Benchmarks::Report( name + " insert", Benchmarks::Measure( [&]()
+			{
+				map = Map_T{};
+				for (size_t i = 0; i < keys.size(); ++i)
+					map.try_emplace( keys[i], static_cast<uint32_t>( i ) );
+			}, keys.size() ), "ns" );
+
+		Benchmarks::Report( name + " find", Benchmarks::Measure( [&]()
+			{
+				results.found_sum = 0;
+				for (const auto& key : keys)
+				{
+					if (const auto it = map.find( key ); it != map.end())
+						results.found_sum += it->second;
+				}
+			}, keys.size() ), "ns" );
+
+		Benchmarks::Report( name + " miss", Benchmarks::Measure( [&]()
+			{
+				results.n_missed = 0;
+				for (const auto& key : missing)
+					results.n_missed += (map.find( key ) == map.end());
+			}, missing.size() ), "ns" );
+
+		for (size_t i = 0; i < keys.size(); i += 2)
+			map.erase( keys[i] );
+		results.size_after_erase = map.size();
+		return results;
+	}
+}
+
+// FlatHashMap against std::unordered_map with the same hash on ResourceId keys, the resource caches' access pattern,
+// from maps that fit in cache to ones that don't
+AV_BENCHMARK( FlatHashMap_ResourceIds )
+{
+	// ids are 32 bit hashes, a million names collide now and then, so those are skipped
+	std::vector<ResourceId> ids;
+	ids.reserve( MaxKeys * 2 );
+	std::unordered_set<ResourceId, FlatHash<ResourceId>> seen;
+	for (size_t i = 0; ids.size() < MaxKeys * 2; ++i)
+	{
+		const ResourceId id = ToResourceId( "bench/assets/sprite_" + std::to_string( i ) + ".png" );
+		if (seen.insert( id ).second)
+			ids.push_back( id );
+	}
+	const std::vector<ResourceId> keys( ids.begin(), ids.begin() + MaxKeys ), missing( ids.begin() + MaxKeys, ids.end() );
+
+	bool ok = true;
+	for (size_t n_keys = MinKeys; n_keys <= MaxKeys; n_keys *= 4)
+	{
+		const std::span<const ResourceId> some_keys( keys.data(), n_keys ), some_missing( missing.data(), n_keys );
+		const std::string label = std::to_string( n_keys ) + " keys";
+		const MapResults flat = RunMap<FlatHashMap<ResourceId, uint32_t>>( "FlatHashMap, " + label, some_keys, some_missing );
+		const MapResults unordered = RunMap<std::unordered_map<ResourceId, uint32_t, FlatHash<ResourceId>>>( "std::unordered_map, " + label, some_keys, some_missing );
+
+		const uint64_t expected_sum = static_cast<uint64_t>( n_keys ) * (n_keys - 1) / 2;
+		ok &= Benchmarks::Check( (flat.found_sum == expected_sum) && (unordered.found_sum == expected_sum), label + ": every key was found with its value" );
+		ok &= Benchmarks::Check( (flat.n_missed == n_keys) && (unordered.n_missed == n_keys), label + ": no missing key was found" );
+		ok &= Benchmarks::Check( (flat.size_after_erase == n_keys / 2) && (unordered.size_after_erase == n_keys / 2), label + ": erasing removed half the keys" );
+	}
+	return ok;
+}
@@ -0,0 +1,79 @@
+#include "HeadlessCore.hpp"
+
+#include "Avokii/AbstractGame.hpp"
+#include "Avokii/Graphics/Texture.hpp"
+#include "Avokii/Resources/ResourceManager.hpp"
+
+namespace
+{
+	using namespace Avokii;
+
+	class BenchmarkGame final
+		: public AbstractGame
+	{
+	protected:
+		void Init() override {}
+		void OnGameEnd() override {}
+		void OnFixedUpdate( const PreciseTimestep& ) override {}
+		void OnVariableUpdate( const PreciseTimestep& ) override {}
+		void OnRender( const PreciseTimestep& ) override {}
+	};
+}
+
+namespace Avokii::Benchmarks
+{
+	HeadlessCore::HeadlessCore( unsigned job_workers )
+	{
+		CoreProperties props;
+		props.jobWorkers = job_workers;
+		props.maxPlugins = CoreAPIs::User;
+		props.resourceInitaliserFunc = []( ResourceManager& manager )
+		{
+			manager.Init<Graphics::Texture>();
+			manager.Init<Graphics::SpriteSheet>();
+			manager.Init<Graphics::Sprite>();
+		};
+		props.pluginFactory = []( Core&, APIType type ) -> std::unique_ptr<API::BaseAPI>
+		{
+			if (type != CoreAPIs::Video)
+				return nullptr;
+
+			// the command log would be most of the cost of a draw
+			return std::make_unique<Plugins::VideoNull>( Plugins::VideoNullDefinition{ .record_commands = false } );
+		};
+
+		mpCore = std::make_unique<Core>( std::move( props ), std::make_unique<BenchmarkGame>() );
+		mpCore->Init();
+	}
+
+	HeadlessCore::~HeadlessCore() = default;
+
+	ResourceHandle<Graphics::SpriteSheet> HeadlessCore::MakeSpriteSheet( StringView asset_id, uint32_t n_sprites )
+	{
+		auto& manager = rGetResources();
+
+		const String texture_id = String{ asset_id } + ".png";
+		std::vector<BaseResourceCache::NewResource> textures{ { texture_id, rGetVideo().CreateTexture( Graphics::TextureDefinition{ .size = { 256, 256 } } ) } };
+		manager.AddResources<Graphics::Texture>( textures );
+
+		auto sheet = std::make_shared<Graphics::SpriteSheet>( manager );
+		sheet->SetTextureId( texture_id );
+		for (uint32_t i = 0; i < n_sprites; ++i)
+		{
+			// a 16x16 grid of cells, repeated past 256 sprites
+			const float u = static_cast<float>( i % 16 ) / 16.f;
+			const float v = static_cast<float>( (i / 16) % 16 ) / 16.f;
+			sheet->AddSprite( String{ asset_id } + "/" + std::to_string( i ), Graphics::SpriteSheetEntry{
+				.pivot = { 8.f, 0.f },
+				.uvs = { Point2D<float>{ u, v }, Size<float>{ 1.f / 16.f, 1.f / 16.f } },
+				.size = { 16.f, 16.f },
+				} );
+		}
+
+		const String sheet_id{ asset_id };
+		std::vector<BaseResourceCache::NewResource> sheets{ { sheet_id, sheet } };
+		manager.AddResources<Graphics::SpriteSheet>( sheets );
+		sheet->LoadSprites();
+		return sheet;
+	}
+}
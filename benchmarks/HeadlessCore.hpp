@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+
+#include "Avokii/Core.hpp"
+#include "Avokii/Graphics/Resources/SpriteSheet.hpp"
+#include "Avokii/Plugins/Null/VideoNull.hpp"
+#include "Avokii/Resources/ResourceHandle.hpp"
+
+namespace Avokii::Benchmarks
+{
+	// An initialised Core with only the VideoNull plugin and the texture and sprite caches, never dispatched.
+	// For benchmarking code that needs the engine's resources or video API without a window.
+	class HeadlessCore final
+	{
+	public:
+		explicit HeadlessCore( unsigned job_workers = 0 );
+		~HeadlessCore();
+
+		[[nodiscard]] Core& rGetCore() noexcept { return *mpCore; }
+		[[nodiscard]] ResourceManager& rGetResources() noexcept { return mpCore->GetResourceManager(); }
+		[[nodiscard]] JobSystem& rGetJobs() noexcept { return mpCore->rGetJobSystem(); }
+		[[nodiscard]] Plugins::VideoNull& rGetVideo() noexcept { return *mpCore->rGetAPI<Plugins::VideoNull>(); }
+
+		// A sheet of `n_sprites` 16x16 sprites named "<asset_id>/<index>" on a blank 256x256 RGBA8 texture of its own,
+		// added to the caches along with its sprites
+		ResourceHandle<Graphics::SpriteSheet> MakeSpriteSheet( StringView asset_id, uint32_t n_sprites );
+
+	private:
+		std::unique_ptr<Core> mpCore;
+	};
+}
@@ -0,0 +1,184 @@
+#include "Benchmark.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "Avokii/Jobs/JobSystem.hpp"
+
+namespace
+{
+	using namespace Avokii;
+
+	uint64_t Fibonacci( JobSystem& jobs, int n )
+	{
+		if (n < 16)
+		{
+			uint64_t a = 0, b = 1;
+			for (int i = 0; i < n; ++i)
+				a = std::exchange( b, a + b );
+			return a;
+		}
+
+		uint64_t left = 0;
+		JobCounter counter;
+		jobs.Run( [&]() { left = Fibonacci( jobs, n - 1 ); }, &counter );
+		const uint64_t right = Fibonacci( jobs, n - 2 );
+		jobs.Wait( counter );
+		return left + right;
+	}
+
+	// Busy rather than sleeping, like real frame work
+	void SpinFor( std::chrono::microseconds duration )
+	{
+		const auto end = std::chrono::steady_clock::now() + duration;
+		while (std::chrono::steady_clock::now() < end) {}
+	}
+}
+
+// ParallelFor over a compute bound loop, fork-join recursion and bare job overhead at each worker count
+AV_BENCHMARK( JobSystem_Scaling )
+{
+	bool ok = true;
+	std::vector<float> values( 1 << 22 );
+	double single_worker_ms = 0.0;
+
+	for (const uint32_t n_workers : Benchmarks::GetWorkerCounts())
+	{
+		JobSystem jobs( n_workers );
+		const auto label = [&]( const char* what ) { return std::to_string( n_workers ) + " workers, " + what; };
+
+		const double parallel_for_ms = Benchmarks::Measure( [&]()
+			{
+				jobs.ParallelFor( values.size(), 16 * 1024, [&]( size_t begin, size_t end )
+					{
+						for (size_t i = begin; i < end; ++i)
+							values[i] = std::sqrt( static_cast<float>( i ) * 1.0001f + 0.5f );
+					} );
+			} ) / 1.0e6;
+		if (n_workers == 1)
+			single_worker_ms = parallel_for_ms;
+		Benchmarks::Report( label( "ParallelFor 4M sqrt" ), parallel_for_ms, "ms" );
+		Benchmarks::Report( label( "ParallelFor speedup" ), single_worker_ms / parallel_for_ms, "x" );
+
+		uint64_t fibonacci = 0;
+		Benchmarks::Report( label( "fork-join fibonacci(30)" ), Benchmarks::Measure( [&]() { fibonacci = Fibonacci( jobs, 30 ); } ) / 1.0e6, "ms" );
+		ok &= Benchmarks::Check( fibonacci == 832040, "fibonacci(30)" );
+
+		constexpr size_t NumEmptyJobs = 100000;
+		Benchmarks::Report( label( "empty job" ), Benchmarks::Measure( [&]()
+			{
+				JobCounter counter;
+				for (size_t i = 0; i < NumEmptyJobs; ++i)
+					jobs.Run( []() {}, &counter );
+				jobs.Wait( counter );
+			}, NumEmptyJobs ), "ns" );
+	}
+
+	return ok;
+}
+
+// A throwing job still finishes its counter and the exception comes out of Wait()
+AV_BENCHMARK( JobSystem_Exceptions )
+{
+	JobSystem jobs( 2 );
+	bool ok = true;
+
+	for (int round = 0; round < 100; ++round)
+	{
+		std::atomic<int> n_ran{ 0 };
+		JobCounter counter;
+		for (int i = 0; i < 50; ++i)
+		{
+			jobs.Run( [&, i]()
+				{
+					++n_ran;
+					if (i % 7 == 3)
+						throw std::runtime_error( "job failed" );
+				}, &counter );
+		}
+
+		bool caught = false;
+		try
+		{
+			jobs.Wait( counter );
+		}
+		catch (const std::runtime_error&)
+		{
+			caught = true;
+		}
+		ok &= Benchmarks::Check( caught && (n_ran == 50), "exception rethrown from Wait() after every job ran" );
+
+		JobCounter reused;
+		jobs.Run( []() {}, &reused );
+		jobs.Wait( reused );
+	}
+
+	return ok;
+}
+
+// Frame time and input latency of Core's pipelined rendering model: the simulation of the next frame runs on a worker while
+// the main thread renders, with a ParallelFor inside rendering as the sprite batcher's parallel recording does
+AV_BENCHMARK( JobSystem_PipelinedFrame )
+{
+	using namespace std::chrono_literals;
+	constexpr auto SimulationTime = 4ms;
+	constexpr auto RenderTime = 2ms; // on the main thread, then 2ms more across the workers
+	constexpr int NumFrames = 60;
+
+	JobSystem jobs( 3 );
+	std::atomic<int> n_simulated_on_main{ 0 };
+	const auto simulate = [&]()
+	{
+		if (jobs.IsMainThread())
+			++n_simulated_on_main;
+		SpinFor( SimulationTime );
+	};
+	const auto render = [&]()
+	{
+		SpinFor( RenderTime );
+		jobs.ParallelFor( 16, 1, []( size_t, size_t ) { SpinFor( 125us ); } );
+	};
+
+	const double serial_ms = Benchmarks::Measure( [&]()
+		{
+			for (int frame = 0; frame < NumFrames; ++frame)
+			{
+				simulate();
+				render();
+			}
+		}, NumFrames ) / 1.0e6;
+
+	const auto measure_pipelined = [&]( auto&& queue_simulation )
+	{
+		n_simulated_on_main = 0;
+		const double ms = Benchmarks::Measure( [&]()
+			{
+				for (int frame = 0; frame < NumFrames; ++frame)
+				{
+					JobCounter simulation;
+					queue_simulation( simulation );
+					render();
+					jobs.Wait( simulation );
+				}
+			}, NumFrames ) / 1.0e6;
+		return ms;
+	};
+	const double run_ms = measure_pipelined( [&]( JobCounter& counter ) { jobs.Run( simulate, &counter ); } );
+	const int run_on_main = n_simulated_on_main;
+	const double worker_ms = measure_pipelined( [&]( JobCounter& counter ) { jobs.RunOnWorker( simulate, &counter ); } );
+	const int worker_on_main = n_simulated_on_main;
+
+	// input is read at the start of a frame, serial frames show it at their end, pipelined frames a frame later
+	Benchmarks::Report( "serial frame", serial_ms, "ms" );
+	Benchmarks::Report( "serial input latency", serial_ms, "ms" );
+	Benchmarks::Report( "pipelined with Run() frame", run_ms, "ms" );
+	Benchmarks::Report( "pipelined with Run() simulations on main", static_cast<double>( run_on_main ), "" );
+	Benchmarks::Report( "pipelined with RunOnWorker() frame", worker_ms, "ms" );
+	Benchmarks::Report( "pipelined with RunOnWorker() input latency", worker_ms * 2.0, "ms" );
+
+	return Benchmarks::Check( worker_on_main == 0, "RunOnWorker() never runs on the main thread" );
+}
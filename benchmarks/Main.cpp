@@ -0,0 +1,45 @@
+#include "Benchmark.hpp"
+
+#include <cstring>
+
+#include "Avokii/Logging.hpp"
+
+// AvokiiBenchmarks [filter...]
+// Runs every benchmark whose name contains one of the filters, or all of them. Exits with 1 if any check failed.
+int main( int argc, char** argv )
+{
+	using namespace Avokii;
+
+	// warnings and up to the console, the engine logs at info level from inside timed loops
+	Logger::Initialise( "logs" );
+	for (const auto& [channel, name] : { std::pair{ LoggingChannels::Application, "Application" }, std::pair{ LoggingChannels::Resource, "Resource" },
+		std::pair{ LoggingChannels::Assertion, "Assertion" }, std::pair{ LoggingChannels::OpenGL, "OpenGL" } })
+	{
+		Logger::GetInstance().AddSink( channel, Logger::Sink{ .name = name, .window_output_pattern = "[%n] %v", .level = Logger::Level::Warning } );
+	}
+
+	auto benchmarks = Benchmarks::rGetBenchmarks();
+	std::sort( std::begin( benchmarks ), std::end( benchmarks ), []( const auto& a, const auto& b ) { return a.name < b.name; } );
+
+	int n_run = 0;
+	int n_failed = 0;
+	for (const auto& benchmark : benchmarks)
+	{
+		bool selected = (argc <= 1);
+		for (int i = 1; i < argc; ++i)
+			selected = selected || (benchmark.name.find( argv[i] ) != std::string_view::npos);
+		if (!selected)
+			continue;
+
+		std::printf( "%.*s\n", static_cast<int>( benchmark.name.size() ), benchmark.name.data() );
+		++n_run;
+		if (!benchmark.func())
+		{
+			std::printf( "  FAILED\n" );
+			++n_failed;
+		}
+	}
+
+	std::printf( "%d benchmarks run, %d failed\n", n_run, n_failed );
+	return (n_failed == 0) ? 0 : 1;
+}
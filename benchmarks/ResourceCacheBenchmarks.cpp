@@ -0,0 +1,202 @@
+#include "Benchmark.hpp"
+#include "HeadlessCore.hpp"
+
+#include <atomic>
+#include <string>
+
+#include "Avokii/Graphics/Texture.hpp"
+#include "Avokii/Jobs/JobSystem.hpp"
+#include "Avokii/Resources/ResourceManager.hpp"
+
+namespace
+{
+	using namespace Avokii;
+
+	constexpr uint32_t NumSheets = 16;
+	constexpr uint32_t SpritesPerSheet = 256;
+
+	// The ids of NumSheets * SpritesPerSheet sprites in the core's sprite cache
+	std::vector<ResourceId> MakeSprites( Benchmarks::HeadlessCore& core )
+	{
+		std::vector<ResourceId> ids;
+		ids.reserve( NumSheets * SpritesPerSheet );
+		for (uint32_t i = 0; i < NumSheets; ++i)
+		{
+			const auto sheet = core.MakeSpriteSheet( "bench/cache" + std::to_string( i ), SpritesPerSheet );
+			for (uint32_t sprite_idx = 0; sprite_idx < SpritesPerSheet; ++sprite_idx)
+				ids.push_back( ToResourceId( sheet->GetSpriteAssetId( sprite_idx ) ) );
+		}
+		return ids;
+	}
+}
+
+// Sprite lookups from every worker at once, which the cache's shards should let scale with the worker count
+AV_BENCHMARK( ResourceCache_ConcurrentGet )
+{
+	bool ok = true;
+
+	constexpr size_t NumLookups = 1 << 20;
+	for (const uint32_t n_workers : Benchmarks::GetWorkerCounts())
+	{
+		// a core per worker count, a second job system would take the main thread from the core's
+		Benchmarks::HeadlessCore core( n_workers );
+		const auto& resources = core.rGetResources();
+		const std::vector<ResourceId> ids = MakeSprites( core );
+		auto& jobs = core.rGetJobs();
+		std::atomic<size_t> n_found{ 0 };
+
+		const auto lookup_all = [&]()
+		{
+			n_found = 0;
+			jobs.ParallelFor( NumLookups, 4096, [&]( size_t begin, size_t end )
+				{
+					size_t found = 0;
+					for (size_t i = begin; i < end; ++i)
+						found += (resources.Get<Graphics::Sprite>( ids[(i * 7919) % ids.size()] ) != nullptr);
+					n_found += found;
+				} );
+		};
+
+		const std::string label = std::to_string( n_workers ) + " workers";
+		Benchmarks::Report( label + ", Get<Sprite>", Benchmarks::Measure( lookup_all, NumLookups ), "ns" );
+		ok &= Benchmarks::Check( n_found == NumLookups, label + ": every sprite was found" );
+	}
+
+	return ok;
+}
+
+// Lookups mixed with adding new sprites from 8 threads, as while streaming in a level, through a sharded and an unsharded cache
+AV_BENCHMARK( ResourceCache_ConcurrentGetAndAdd )
+{
+	bool ok = true;
+
+	constexpr size_t NumOperations = 1 << 18;
+	constexpr size_t AddEvery = 10; // one in ten operations adds a sprite
+	constexpr size_t NumAdds = (NumOperations + AddEvery - 1) / AddEvery;
+	constexpr int NumRuns = 6; // Measure()'s warm up and repeats, each adding ids of its own
+
+	// the main thread works through ParallelFor() too, 7 workers make 8 threads
+	Benchmarks::HeadlessCore core( 7 );
+	auto& jobs = core.rGetJobs();
+	const auto sheet = core.MakeSpriteSheet( "bench/mixed", SpritesPerSheet );
+
+	std::vector<String> added_asset_ids;
+	added_asset_ids.reserve( NumRuns * NumAdds );
+	for (size_t i = 0; i < NumRuns * NumAdds; ++i)
+		added_asset_ids.push_back( "bench/mixed/added" + std::to_string( i ) );
+
+	for (const size_t n_shards : { BaseResourceCache::MaxShardCount, size_t{ 1 } })
+	{
+		ResourceCache<Graphics::Sprite> cache( core.rGetResources(), n_shards );
+		std::vector<BaseResourceCache::NewResource> seed;
+		std::vector<ResourceId> ids;
+		for (uint32_t sprite_idx = 0; sprite_idx < SpritesPerSheet; ++sprite_idx)
+		{
+			seed.push_back( BaseResourceCache::NewResource{ sheet->GetSpriteAssetId( sprite_idx ), std::make_shared<Graphics::Sprite>( sheet, sprite_idx ) } );
+			ids.push_back( ToResourceId( sheet->GetSpriteAssetId( sprite_idx ) ) );
+		}
+		cache.AddResources( seed );
+
+		std::atomic<size_t> n_found{ 0 };
+		std::atomic<size_t> n_added{ 0 };
+		size_t run = 0;
+		const auto get_and_add = [&]()
+		{
+			const size_t first_add = (run++) * NumAdds;
+			n_found = 0;
+			n_added = 0;
+			jobs.ParallelFor( NumOperations, 4096, [&]( size_t begin, size_t end )
+				{
+					size_t found = 0, added = 0;
+					for (size_t i = begin; i < end; ++i)
+					{
+						if (i % AddEvery == 0)
+						{
+							BaseResourceCache::NewResource resource{ added_asset_ids[first_add + i / AddEvery], std::make_shared<Graphics::Sprite>( sheet, static_cast<uint32_t>( i % SpritesPerSheet ) ) };
+							added += cache.AddResources( std::span( &resource, 1 ) );
+						}
+						else
+							found += (cache.Get( ids[(i * 7919) % ids.size()] ) != nullptr);
+					}
+					n_found += found;
+					n_added += added;
+				} );
+		};
+
+		const std::string label = (n_shards == 1) ? "1 shard" : std::to_string( n_shards ) + " shards";
+		const double ns = Benchmarks::Measure( get_and_add, NumOperations );
+		Benchmarks::Report( label + ", 8 threads, 10% adds", ns, "ns" );
+		Benchmarks::Report( label + ", 8 threads, 10% adds throughput", 1.0e3 / ns, "Mops/s" );
+		ok &= Benchmarks::Check( n_found == NumOperations - NumAdds, label + ": every sprite was found" );
+		ok &= Benchmarks::Check( n_added == NumAdds, label + ": every new sprite was added" );
+		ok &= Benchmarks::Check( cache.GetShardCount() == n_shards, label + ": the cache has the shards asked for" );
+	}
+
+	return ok;
+}
+
+// ResourceManager::Get<R>(), which finds the cache by asset type, against holding on to the cache
+AV_BENCHMARK( ResourceManager_Get )
+{
+	Benchmarks::HeadlessCore core;
+	const auto& resources = core.rGetResources();
+	const auto& cache = resources.GetCache<Graphics::Sprite>();
+	const std::vector<ResourceId> ids = MakeSprites( core );
+
+	std::vector<const Graphics::Sprite*> through_manager( ids.size() ), through_cache( ids.size() );
+	Benchmarks::Report( "ResourceManager::Get<Sprite>", Benchmarks::Measure( [&]()
+		{
+			for (size_t i = 0; i < ids.size(); ++i)
+				through_manager[i] = resources.Get<Graphics::Sprite>( ids[i] ).get();
+		}, ids.size() ), "ns" );
+	Benchmarks::Report( "ResourceCache<Sprite>::Get", Benchmarks::Measure( [&]()
+		{
+			for (size_t i = 0; i < ids.size(); ++i)
+				through_cache[i] = cache.Get( ids[i] ).get();
+		}, ids.size() ), "ns" );
+
+	bool ok = true;
+	ok &= Benchmarks::Check( through_manager == through_cache, "the manager and the cache return the same sprites" );
+	ok &= Benchmarks::Check( std::find( std::begin( through_cache ), std::end( through_cache ), nullptr ) == std::end( through_cache ), "every sprite was found" );
+	return ok;
+}
+
+// Byte budgets reclaim sheets and their textures while the sheets' sprites are cached, but not a sheet whose sprite is in use
+AV_BENCHMARK( ResourceCache_Budgets )
+{
+	Benchmarks::HeadlessCore core;
+	auto& resources = core.rGetResources();
+	bool ok = true;
+
+	constexpr uint32_t NumBudgetSheets = 4;
+	std::vector<String> sheet_ids;
+	for (uint32_t i = 0; i < NumBudgetSheets; ++i)
+	{
+		sheet_ids.push_back( "bench/budget" + std::to_string( i ) );
+		const auto sheet = core.MakeSpriteSheet( sheet_ids.back(), SpritesPerSheet );
+		ok &= Benchmarks::Check( sheet->GetTexture() != nullptr, "the sheet's texture is cached" );
+	}
+
+	const size_t texture_bytes = resources.GetUsage<Graphics::Texture>().GetTotal() / NumBudgetSheets;
+	ok &= Benchmarks::Check( resources.GetUsage<Graphics::Sprite>().GetTotal() > 0, "sprites count towards their cache's usage" );
+
+	// the sheets don't keep their textures cached
+	resources.SetByteBudget<Graphics::Texture>( texture_bytes );
+	resources.NextGeneration();
+	Benchmarks::Report( "texture bytes over a one texture budget", static_cast<double>( resources.GetUsage<Graphics::Texture>().GetTotal() ), "B" );
+	ok &= Benchmarks::Check( resources.GetUsage<Graphics::Texture>().GetTotal() <= texture_bytes, "the texture budget is met with the sprites cached" );
+
+	// sheets go along with their cached sprites, unless one of those is in use
+	const auto held = resources.Get<Graphics::Sprite>( ToResourceId( sheet_ids[0] + "/0" ) );
+	resources.SetByteBudget<Graphics::SpriteSheet>( 1 );
+	resources.NextGeneration();
+	ok &= Benchmarks::Check( resources.Get<Graphics::SpriteSheet>( ToResourceId( sheet_ids[0] ) ) != nullptr, "the sheet of a sprite in use stays cached" );
+	ok &= Benchmarks::Check( resources.Get<Graphics::Sprite>( ToResourceId( sheet_ids[0] + "/1" ) ) != nullptr, "so do its sprites" );
+	for (uint32_t i = 1; i < NumBudgetSheets; ++i)
+	{
+		ok &= Benchmarks::Check( resources.Get<Graphics::SpriteSheet>( ToResourceId( sheet_ids[i] ) ) == nullptr, "unused sheets are evicted" );
+		ok &= Benchmarks::Check( resources.Get<Graphics::Sprite>( ToResourceId( sheet_ids[i] + "/1" ) ) == nullptr, "along with their sprites" );
+	}
+
+	return ok;
+}
@@ -0,0 +1,243 @@
+#include "Benchmark.hpp"
+#include "HeadlessCore.hpp"
+
+#include <string>
+
+#include "Avokii/Graphics/Camera.hpp"
+#include "Avokii/Graphics/Rendering/SpriteBatcher.hpp"
+#include "Avokii/Resources/ResourceManager.hpp"
+
+namespace
+{
+	using namespace Avokii;
+	using Graphics::SpriteBatcher;
+
+	constexpr uint32_t NumSheets = 4;
+	constexpr uint32_t SpritesPerSheet = 256;
+	constexpr size_t NumSprites = 100000;
+
+	struct SpriteScene
+	{
+		std::vector<ResourceHandle<Graphics::Sprite>> sprites;
+		std::vector<Vec3f> locations;
+	};
+
+	// sprites alternate between the sheets so immediate submission has to juggle textures
+	SpriteScene MakeScene( Benchmarks::HeadlessCore& core )
+	{
+		std::vector<ResourceHandle<Graphics::SpriteSheet>> sheets;
+		for (uint32_t i = 0; i < NumSheets; ++i)
+			sheets.push_back( core.MakeSpriteSheet( "bench/sheet" + std::to_string( i ), SpritesPerSheet ) );
+
+		SpriteScene scene;
+		scene.sprites.reserve( NumSprites );
+		scene.locations.reserve( NumSprites );
+		for (size_t i = 0; i < NumSprites; ++i)
+		{
+			const auto& sheet = sheets[i % NumSheets];
+			const auto sprite_id = ToResourceId( sheet->GetSpriteAssetId( static_cast<uint32_t>( (i / NumSheets) % SpritesPerSheet ) ) );
+			scene.sprites.push_back( core.rGetResources().Get<Graphics::Sprite>( sprite_id ) );
+			scene.locations.push_back( Vec3f{ static_cast<float>( i % 512 ) * 4.f, 0.f, static_cast<float>( i / 512 ) * 4.f } );
+		}
+		return scene;
+	}
+
+	const char* GetModeName( SpriteBatcher::Mode mode )
+	{
+		return (mode == SpriteBatcher::Mode::Quads) ? "quads" : "instanced";
+	}
+
+	const char* GetSubmissionName( SpriteBatcher::Submission submission )
+	{
+		switch (submission)
+		{
+		case SpriteBatcher::Submission::Immediate: return "immediate";
+		case SpriteBatcher::Submission::Deferred: return "deferred";
+		case SpriteBatcher::Submission::DeferredBackToFront: return "back to front";
+		}
+		return "?";
+	}
+}
+
+// Draws a scene through every batcher mode on the null video backend, checking the batcher's counters against what the device saw
+AV_BENCHMARK( SpriteBatcher_VideoNull )
+{
+	Benchmarks::HeadlessCore core;
+	auto& video = core.rGetVideo();
+	const SpriteScene scene = MakeScene( core );
+	const Graphics::FreelookCamera camera;
+	bool ok = true;
+
+	for (const auto mode : { SpriteBatcher::Mode::Quads, SpriteBatcher::Mode::Instanced })
+	{
+		SpriteBatcher batcher( video, mode );
+		// everything is submitted, culling has its own costs and would make the counts depend on the camera
+		batcher.SetFrustumCulling( false );
+
+		for (const auto submission : { SpriteBatcher::Submission::Immediate, SpriteBatcher::Submission::Deferred, SpriteBatcher::Submission::DeferredBackToFront })
+		{
+			const auto draw_frame = [&]()
+			{
+				video.BeginRender();
+				batcher.Begin( camera, Mat4f{ 1.f }, submission );
+				for (size_t i = 0; i < NumSprites; ++i)
+					batcher.DrawStandingSprite( scene.sprites[i], scene.locations[i] );
+				batcher.EndScene();
+				video.EndRender();
+			};
+
+			const std::string label = std::string( GetModeName( mode ) ) + ", " + GetSubmissionName( submission );
+			Benchmarks::Report( label + " 100k sprites", Benchmarks::Measure( draw_frame ) / 1.0e6, "ms" );
+
+			batcher.ClearStats();
+			video.ResetStatistics();
+			draw_frame();
+
+			const auto& stats = batcher.GetStatistics();
+			const auto& device = video.GetStatistics();
+			Benchmarks::Report( label + " draw calls", stats.nDrawCalls, "" );
+			ok &= Benchmarks::Check( stats.nQuads == NumSprites, label + ": every sprite was written" );
+			ok &= Benchmarks::Check( stats.nDrawCalls == device.nDrawCalls, label + ": draw calls match the device" );
+			if (mode == SpriteBatcher::Mode::Quads)
+				ok &= Benchmarks::Check( device.nIndices == NumSprites * 6, label + ": six indices per sprite" );
+			else
+				ok &= Benchmarks::Check( device.nInstances == NumSprites, label + ": one instance per sprite" );
+			if (submission != SpriteBatcher::Submission::Immediate)
+				ok &= Benchmarks::Check( stats.nDrawCalls <= stats.nUnsortedDrawCalls, label + ": sorting doesn't add draw calls" );
+		}
+	}
+
+	return ok;
+}
+
+// Recording through writers on the job system against recording on the main thread, over 1 to 8 workers
+AV_BENCHMARK( SpriteBatcher_RecordParallel )
+{
+	bool ok = true;
+	double serial_ms = 0.0;
+
+	for (const uint32_t n_workers : { 1u, 2u, 4u, 8u })
+	{
+		// a core per worker count, a second job system would take the main thread from the core's
+		Benchmarks::HeadlessCore core( n_workers );
+		auto& video = core.rGetVideo();
+		const SpriteScene scene = MakeScene( core );
+		const Graphics::FreelookCamera camera;
+
+		SpriteBatcher batcher( video, SpriteBatcher::Mode::Instanced );
+		batcher.SetFrustumCulling( false );
+
+		const auto draw_serial = [&]()
+		{
+			batcher.Begin( camera );
+			for (size_t i = 0; i < NumSprites; ++i)
+				batcher.DrawStandingSprite( scene.sprites[i], scene.locations[i] );
+			batcher.EndScene();
+		};
+		const auto draw_parallel = [&]()
+		{
+			batcher.Begin( camera );
+			batcher.RecordParallel( core.rGetJobs(), NumSprites, 8192, [&]( SpriteBatcher::Writer& writer, size_t begin, size_t end )
+				{
+					writer.Reserve( static_cast<uint32_t>( end - begin ) );
+					for (size_t i = begin; i < end; ++i)
+						writer.DrawStandingSprite( scene.sprites[i], scene.locations[i] );
+				} );
+			batcher.EndScene();
+		};
+
+		// the main thread doesn't depend on the worker count, measured once
+		if (serial_ms == 0.0)
+		{
+			serial_ms = Benchmarks::Measure( draw_serial ) / 1.0e6;
+			Benchmarks::Report( "main thread 100k sprites", serial_ms, "ms" );
+		}
+
+		const std::string workers = std::to_string( n_workers ) + ( n_workers == 1 ? " worker" : " workers" );
+		const double parallel_ms = Benchmarks::Measure( draw_parallel ) / 1.0e6;
+		Benchmarks::Report( "writers, " + workers, parallel_ms, "ms" );
+		Benchmarks::Report( "writers, " + workers + " speedup", serial_ms / parallel_ms, "x" );
+
+		batcher.ClearStats();
+		video.ResetStatistics();
+		draw_serial();
+		const auto serial_stats = batcher.GetStatistics();
+		const auto serial_bytes = video.GetStatistics().nBufferBytes;
+
+		batcher.ClearStats();
+		video.ResetStatistics();
+		draw_parallel();
+		const auto& parallel_stats = batcher.GetStatistics();
+		ok &= Benchmarks::Check( parallel_stats.nQuads == serial_stats.nQuads, workers + ": writers wrote every sprite" );
+		ok &= Benchmarks::Check( parallel_stats.nDrawCalls == serial_stats.nDrawCalls, workers + ": writers batch the same" );
+		ok &= Benchmarks::Check( video.GetStatistics().nBufferBytes == serial_bytes, workers + ": writers upload the same amount" );
+	}
+
+	return ok;
+}
+
+// Bulk DrawStandingSprites() against a DrawStandingSprite() call per sprite, both writing the same sprites of one sheet
+AV_BENCHMARK( SpriteBatcher_StandingSprites )
+{
+	Benchmarks::HeadlessCore core;
+	auto& video = core.rGetVideo();
+	const auto sheet = core.MakeSpriteSheet( "bench/bulk", SpritesPerSheet );
+	const Graphics::FreelookCamera camera;
+	bool ok = true;
+
+	std::vector<SpriteBatcher::StandingSprite> standing( NumSprites );
+	std::vector<ResourceHandle<Graphics::Sprite>> sprites( NumSprites );
+	for (size_t i = 0; i < NumSprites; ++i)
+	{
+		const auto sprite_idx = static_cast<uint32_t>( i % SpritesPerSheet );
+		standing[i] = SpriteBatcher::StandingSprite{
+			.location = Vec3f{ static_cast<float>( i % 512 ) * 4.f, 0.f, static_cast<float>( i / 512 ) * 4.f },
+			.sprite_idx = sprite_idx,
+			.colour = ColourRGBA{ 0xFFFFFFFF },
+		};
+		sprites[i] = core.rGetResources().Get<Graphics::Sprite>( ToResourceId( sheet->GetSpriteAssetId( sprite_idx ) ) );
+	}
+
+	for (const auto mode : { SpriteBatcher::Mode::Quads, SpriteBatcher::Mode::Instanced })
+	{
+		SpriteBatcher batcher( video, mode );
+		batcher.SetFrustumCulling( false );
+
+		const auto draw_each = [&]()
+		{
+			video.BeginRender();
+			batcher.Begin( camera );
+			for (size_t i = 0; i < NumSprites; ++i)
+				batcher.DrawStandingSprite( sprites[i], standing[i].location );
+			batcher.EndScene();
+			video.EndRender();
+		};
+		const auto draw_bulk = [&]()
+		{
+			video.BeginRender();
+			batcher.Begin( camera );
+			batcher.DrawStandingSprites( sheet, standing );
+			batcher.EndScene();
+			video.EndRender();
+		};
+
+		const std::string label = GetModeName( mode );
+		Benchmarks::Report( label + ", DrawStandingSprite", Benchmarks::Measure( draw_each, NumSprites ), "ns/sprite" );
+		Benchmarks::Report( label + ", DrawStandingSprites", Benchmarks::Measure( draw_bulk, NumSprites ), "ns/sprite" );
+
+		batcher.ClearStats();
+		video.ResetStatistics();
+		draw_each();
+		const auto each_stats = batcher.GetStatistics();
+		const auto each_bytes = video.GetStatistics().nBufferBytes;
+
+		batcher.ClearStats();
+		video.ResetStatistics();
+		draw_bulk();
+		ok &= Benchmarks::Check( batcher.GetStatistics().nQuads == each_stats.nQuads, label + ": bulk wrote every sprite" );
+		ok &= Benchmarks::Check( batcher.GetStatistics().nDrawCalls == each_stats.nDrawCalls, label + ": bulk batches the same" );
+		ok &= Benchmarks::Check( video.GetStatistics().nBufferBytes == each_bytes, label + ": bulk uploads the same amount" );
+	}
+
+	return ok;
+}
@@ -18,6 +18,15 @@
 #	define AVOKII_RENDERER_IMPLEMENTATION_OPENGL
 #endif
 
+// AV_PROFILE_* scopes, see Avokii/Profiling/Profiler.hpp. Off in release unless defined by the project.
+#ifndef AV_ENABLE_PROFILING
+#	ifdef _DEBUG
+#		define AV_ENABLE_PROFILING 1
+#	else
+#		define AV_ENABLE_PROFILING 0
+#	endif
+#endif
+
 #define AV_EXPAND_MACRO(x) x
 #define AV_STRINGIFY_MACRO(x) #x
 
@@ -21,6 +21,7 @@ namespace Avokii
 		private:
 			virtual void Init() = 0;
 			virtual void Shutdown() = 0;
+			// On a job worker when CoreProperties::pipelinedRendering is set, alongside rendering
 			virtual void OnFixedUpdate( const PreciseTimestep&, StepType ) {}
 			virtual void OnVariableUpdate( const PreciseTimestep&, StepType ) {}
 			virtual void OnRender( const PreciseTimestep&, StepType ) {}
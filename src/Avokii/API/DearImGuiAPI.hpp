@@ -24,6 +24,10 @@ namespace Avokii
 			virtual void SetEnabled( const bool enable ) = 0;
 			virtual bool GetEnabled() const noexcept = 0;
 
+			// Frame profiler window, see Profiler
+			virtual void SetProfilerVisible( const bool visible ) = 0;
+			virtual bool GetProfilerVisible() const noexcept = 0;
+
 			virtual bool WantsToCaptureKeyboard() const noexcept = 0;
 			virtual bool WantsToCaptureMouse() const noexcept = 0;
 
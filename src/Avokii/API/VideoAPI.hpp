@@ -13,6 +13,8 @@ namespace Avokii
 		class Texture;
 		struct TextureDefinition;
 		struct TextureLoadProperties;
+		class TextureArray;
+		struct TextureArrayDefinition;
 		class Shader;
 		class FrameBuffer;
 		struct FrameBufferSpecification;
@@ -52,7 +54,8 @@ namespace Avokii
 
 			virtual const Graphics::DeviceCapabilities& GetDeviceCapabilities() const = 0;
 
-			virtual void DrawIndexed( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t index_count = 0 ) = 0;
+			virtual void DrawIndexed( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t index_count = 0, uint32_t base_vertex = 0 ) = 0;
+			virtual void DrawInstanced( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t vertex_count, uint32_t instance_count, uint32_t base_instance = 0 ) = 0;
 
 			[[nodiscard]] virtual std::shared_ptr<Graphics::VertexBuffer> CreateVertexBuffer( const Graphics::VertexBufferDefinition& definition ) const = 0;
 			[[nodiscard]] virtual std::shared_ptr<Graphics::IndexBuffer> CreateIndexBuffer( const Graphics::IndexBufferDefinition& definition ) const = 0;
@@ -63,10 +66,16 @@ namespace Avokii
 			[[nodiscard]] virtual std::shared_ptr<Graphics::Texture> CreateTexture( const Graphics::TextureDefinition& props ) const = 0;
 			[[nodiscard]] virtual std::shared_ptr<Graphics::Texture> CreateTexture( const Filepath& filepath, const Graphics::TextureLoadProperties& props ) const = 0;
 			[[nodiscard]] inline std::shared_ptr<Graphics::Texture> CreateTexture( StringView filepath, const Graphics::TextureLoadProperties& props ) const { return CreateTexture( Filepath{ filepath }, props ); }
+			[[nodiscard]] virtual std::shared_ptr<Graphics::TextureArray> CreateTextureArray( const Graphics::TextureArrayDefinition& definition ) const = 0;
 			[[nodiscard]] virtual std::shared_ptr<Graphics::VertexArray> CreateVertexArray( const Graphics::VertexArrayDefinition& definition ) const = 0;
 
 			virtual StringView GetShaderLanguage() const = 0;
 
+			// GPU timings for the profiler, reported to Profiler::RecordGpuEvent() once the results are available.
+			// Scopes can't nest, `name` must outlive the profiler. Use AV_PROFILE_GPU_BEGIN/END rather than calling these directly.
+			virtual void BeginGpuScope( const char* name ) { (void)name; }
+			virtual void EndGpuScope() {}
+
 			virtual void* GetImplementationPointer( StringView id ) { (void)id; return nullptr; }
 		};
 	}
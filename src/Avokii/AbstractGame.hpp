@@ -6,6 +6,7 @@
 namespace Avokii
 {
 	class Core;
+	class JobSystem;
 	class ResourceManager;
 
 	class AbstractGame
@@ -28,6 +29,9 @@ namespace Avokii
 		virtual void OnFixedUpdate( const PreciseTimestep& ts ) = 0;
 		virtual void OnVariableUpdate( const PreciseTimestep& ts ) = 0;
 		virtual void OnRender( const PreciseTimestep& ts ) = 0;
+		// Called between the updates and rendering with neither running, publish what OnRender() needs (see RenderHandoff).
+		// With pipelined rendering the next frame's updates run on a worker while OnRender() draws this one.
+		virtual void OnRenderHandoff() {}
 
 		Core& rGetCore() noexcept { AV_ASSERT( mpCore != nullptr ); return *mpCore; }
 		const Core& GetCore() const noexcept { AV_ASSERT( mpCore != nullptr ); return *mpCore; }
@@ -35,9 +39,13 @@ namespace Avokii
 		ResourceManager& rGetResourceManager() noexcept { AV_ASSERT( mpResourceManager != nullptr ); return *mpResourceManager; }
 		const ResourceManager& GetResourceManager() const noexcept { AV_ASSERT( mpResourceManager != nullptr ); return *mpResourceManager; }
 
+		// For fanning work out across cores, see JobSystem
+		JobSystem& rGetJobSystem() noexcept { AV_ASSERT( mpJobSystem != nullptr ); return *mpJobSystem; }
+
 	private:
 		Core* mpCore = nullptr;
 		ResourceManager* mpResourceManager = nullptr;
+		JobSystem* mpJobSystem = nullptr;
 		std::optional<int> mApplicationExitCode = std::nullopt;
 	};
 }
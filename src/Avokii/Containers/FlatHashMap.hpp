@@ -0,0 +1,428 @@
+#pragma once
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#if defined( _M_X64 ) || defined( __SSE2__ )
+#define AV_FLATHASHMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Avokii
+{
+	// Default hash for FlatHashMap, keys that carry a precomputed hash (HashedString and so ResourceId) use it directly.
+	// The result is mixed as the map takes its probe position and tag from different bits.
+	template<typename Key>
+	struct FlatHash
+	{
+		size_t operator()( const Key& key ) const noexcept
+		{
+			if constexpr (requires { { key.value() } -> std::convertible_to<uint64_t>; })
+				return Mix( static_cast<uint64_t>(key.value()) );
+			else if constexpr (std::is_integral_v<Key> || std::is_enum_v<Key>)
+				return Mix( static_cast<uint64_t>(key) );
+			else
+				return Mix( static_cast<uint64_t>(std::hash<Key>{}(key)) );
+		}
+
+		static constexpr size_t Mix( uint64_t value ) noexcept
+		{
+			value *= 0x9E3779B97F4A7C15ull;
+			return static_cast<size_t>(value ^ (value >> 32));
+		}
+	};
+
+	namespace av_detail_
+	{
+		using FlatCtrl_T = int8_t;
+
+		inline constexpr FlatCtrl_T FlatEmpty = -128;
+		inline constexpr FlatCtrl_T FlatDeleted = -2;
+		inline constexpr size_t FlatGroupWidth = 16;
+
+		// 16 control bytes, the match functions return a bit per byte
+		struct FlatGroup
+		{
+#ifdef AV_FLATHASHMAP_SSE2
+			__m128i ctrl;
+
+			explicit FlatGroup( const FlatCtrl_T* p ) noexcept : ctrl{ _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) ) } {}
+
+			uint32_t Match( const FlatCtrl_T tag ) const noexcept { return static_cast<uint32_t>(_mm_movemask_epi8( _mm_cmpeq_epi8( _mm_set1_epi8( tag ), ctrl ) )); }
+			// empty and deleted are the only negative control bytes
+			uint32_t MatchEmptyOrDeleted() const noexcept { return static_cast<uint32_t>(_mm_movemask_epi8( ctrl )); }
+#else
+			FlatCtrl_T ctrl[FlatGroupWidth];
+
+			explicit FlatGroup( const FlatCtrl_T* p ) noexcept { std::memcpy( ctrl, p, FlatGroupWidth ); }
+
+			uint32_t Match( const FlatCtrl_T tag ) const noexcept
+			{
+				uint32_t mask = 0;
+				for (uint32_t i = 0; i < FlatGroupWidth; ++i)
+					mask |= static_cast<uint32_t>(ctrl[i] == tag) << i;
+				return mask;
+			}
+
+			uint32_t MatchEmptyOrDeleted() const noexcept
+			{
+				uint32_t mask = 0;
+				for (uint32_t i = 0; i < FlatGroupWidth; ++i)
+					mask |= static_cast<uint32_t>(ctrl[i] < 0) << i;
+				return mask;
+			}
+#endif
+			uint32_t MatchEmpty() const noexcept { return Match( FlatEmpty ); }
+		};
+	}
+
+	/// <summary>
+	/// Open addressing hash map in the style of SwissTable.
+	///
+	/// A control byte per slot holds 7 bits of the hash or marks the slot empty or deleted. Lookups compare a group of 16
+	/// control bytes at once and only look at slots whose bits match, entries live in one flat array with no allocation each.
+	/// Inserting can move entries when the map grows, which invalidates iterators and references. Erasing moves nothing.
+	/// </summary>
+	template<typename Key, typename Value, typename Hash = FlatHash<Key>, typename KeyEqual = std::equal_to<Key>>
+	class FlatHashMap
+	{
+	public:
+		using key_type = Key;
+		using mapped_type = Value;
+		using value_type = std::pair<const Key, Value>;
+		using size_type = size_t;
+
+	private:
+		using Ctrl_T = av_detail_::FlatCtrl_T;
+		using Group = av_detail_::FlatGroup;
+		static constexpr size_t GroupWidth = av_detail_::FlatGroupWidth;
+
+		template<bool IsConst>
+		class Iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = FlatHashMap::value_type;
+			using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+			using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+
+			Iterator() = default;
+			Iterator( const Ctrl_T* ctrl, const Ctrl_T* ctrl_end, pointer slot ) noexcept
+				: mpCtrl{ ctrl }, mpCtrlEnd{ ctrl_end }, mpSlot{ slot }
+			{
+				SkipEmpty();
+			}
+
+			// iterator to const_iterator
+			template<bool OtherConst> requires(IsConst && !OtherConst)
+			Iterator( const Iterator<OtherConst>& other ) noexcept
+				: mpCtrl{ other.mpCtrl }, mpCtrlEnd{ other.mpCtrlEnd }, mpSlot{ other.mpSlot }
+			{}
+
+			reference operator*() const noexcept { return *mpSlot; }
+			pointer operator->() const noexcept { return mpSlot; }
+
+			Iterator& operator++() noexcept
+			{
+				++mpCtrl;
+				++mpSlot;
+				SkipEmpty();
+				return *this;
+			}
+
+			Iterator operator++( int ) noexcept
+			{
+				auto copy = *this;
+				++*this;
+				return copy;
+			}
+
+			friend bool operator==( const Iterator& a, const Iterator& b ) noexcept { return a.mpCtrl == b.mpCtrl; }
+
+		private:
+			void SkipEmpty() noexcept
+			{
+				while ((mpCtrl != mpCtrlEnd) && (*mpCtrl < 0))
+				{
+					++mpCtrl;
+					++mpSlot;
+				}
+			}
+
+			friend class FlatHashMap;
+			template<bool> friend class Iterator;
+
+			const Ctrl_T* mpCtrl = nullptr;
+			const Ctrl_T* mpCtrlEnd = nullptr;
+			pointer mpSlot = nullptr;
+		};
+
+	public:
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
+		FlatHashMap() = default;
+		explicit FlatHashMap( size_t n_expected ) { reserve( n_expected ); }
+		~FlatHashMap() { Destroy(); }
+
+		FlatHashMap( FlatHashMap&& other ) noexcept { Swap( other ); }
+		FlatHashMap& operator=( FlatHashMap&& other ) noexcept
+		{
+			if (this != &other)
+			{
+				Destroy();
+				Swap( other );
+			}
+			return *this;
+		}
+		FlatHashMap( const FlatHashMap& ) = delete;
+		FlatHashMap& operator=( const FlatHashMap& ) = delete;
+
+		[[nodiscard]] iterator begin() noexcept { return iterator{ mpCtrl, mpCtrl + mCapacity, mpSlots }; }
+		[[nodiscard]] iterator end() noexcept { return iterator{ mpCtrl + mCapacity, mpCtrl + mCapacity, mpSlots + mCapacity }; }
+		[[nodiscard]] const_iterator begin() const noexcept { return const_iterator{ mpCtrl, mpCtrl + mCapacity, mpSlots }; }
+		[[nodiscard]] const_iterator end() const noexcept { return const_iterator{ mpCtrl + mCapacity, mpCtrl + mCapacity, mpSlots + mCapacity }; }
+
+		[[nodiscard]] size_t size() const noexcept { return mSize; }
+		[[nodiscard]] bool empty() const noexcept { return mSize == 0; }
+		[[nodiscard]] size_t capacity() const noexcept { return mCapacity; }
+
+		[[nodiscard]] iterator find( const Key& key ) noexcept { return MakeIterator( FindIndex( key ) ); }
+		[[nodiscard]] const_iterator find( const Key& key ) const noexcept { return MakeIterator( FindIndex( key ) ); }
+		[[nodiscard]] bool contains( const Key& key ) const noexcept { return FindIndex( key ) != mCapacity; }
+
+		template<typename... Args>
+		std::pair<iterator, bool> try_emplace( const Key& key, Args&&... args )
+		{
+			const size_t hash = Hash{}(key);
+			if (const size_t found = FindIndex( key, hash ); found != mCapacity)
+				return { MakeIterator( found ), false };
+
+			const size_t idx = PrepareInsert( hash );
+			std::construct_at( mpSlots + idx, std::piecewise_construct, std::forward_as_tuple( key ), std::forward_as_tuple( std::forward<Args>( args )... ) );
+			CommitInsert( idx, hash );
+			return { MakeIterator( idx ), true };
+		}
+
+		Value& operator[]( const Key& key ) { return try_emplace( key ).first->second; }
+
+		// Returns the iterator following the erased entry
+		iterator erase( const_iterator it ) noexcept
+		{
+			// the slot is now deleted, so an iterator made from it skips ahead to the next entry
+			const size_t idx = static_cast<size_t>(it.mpCtrl - mpCtrl);
+			EraseIndex( idx );
+			return MakeIterator( idx );
+		}
+
+		iterator erase( iterator it ) noexcept { return erase( const_iterator{ it } ); }
+
+		size_t erase( const Key& key ) noexcept
+		{
+			const size_t idx = FindIndex( key );
+			if (idx == mCapacity)
+				return 0;
+
+			EraseIndex( idx );
+			return 1;
+		}
+
+		void clear() noexcept
+		{
+			if (mCapacity == 0)
+				return;
+
+			DestroySlots();
+			std::memset( mpCtrl, av_detail_::FlatEmpty, mCapacity + GroupWidth );
+			mSize = 0;
+			mGrowthLeft = GetMaxLoad( mCapacity );
+		}
+
+		// Grows so that `n` entries fit without moving any
+		void reserve( size_t n )
+		{
+			size_t capacity = GroupWidth;
+			while (GetMaxLoad( capacity ) < n)
+				capacity *= 2;
+
+			if (capacity > mCapacity)
+				Rehash( capacity );
+		}
+
+	private:
+		// 7/8 of the slots can be used before growing
+		static constexpr size_t GetMaxLoad( size_t capacity ) noexcept { return capacity - capacity / 8; }
+
+		static constexpr size_t H1( size_t hash ) noexcept { return hash >> 7; }
+		static constexpr Ctrl_T H2( size_t hash ) noexcept { return static_cast<Ctrl_T>(hash & 0x7F); }
+
+		iterator MakeIterator( size_t idx ) noexcept { return iterator{ mpCtrl + idx, mpCtrl + mCapacity, mpSlots + idx }; }
+		const_iterator MakeIterator( size_t idx ) const noexcept { return const_iterator{ mpCtrl + idx, mpCtrl + mCapacity, mpSlots + idx }; }
+
+		size_t FindIndex( const Key& key ) const noexcept { return FindIndex( key, Hash{}(key) ); }
+
+		// mCapacity if not found
+		size_t FindIndex( const Key& key, const size_t hash ) const noexcept
+		{
+			if (mCapacity == 0)
+				return mCapacity;
+
+			const size_t mask = mCapacity - 1;
+			size_t position = H1( hash ) & mask;
+			for (size_t step = GroupWidth; ; step += GroupWidth)
+			{
+				const Group group{ mpCtrl + position };
+				for (uint32_t matches = group.Match( H2( hash ) ); matches != 0; matches &= matches - 1)
+				{
+					const size_t idx = (position + static_cast<size_t>(std::countr_zero( matches ))) & mask;
+					if (KeyEqual{}(mpSlots[idx].first, key))
+						return idx;
+				}
+
+				if (group.MatchEmpty() != 0)
+					return mCapacity;
+
+				position = (position + step) & mask;
+			}
+		}
+
+		// First empty or deleted slot along the probe sequence
+		size_t FindInsertIndex( const size_t hash ) const noexcept
+		{
+			const size_t mask = mCapacity - 1;
+			size_t position = H1( hash ) & mask;
+			for (size_t step = GroupWidth; ; step += GroupWidth)
+			{
+				if (const uint32_t free = Group{ mpCtrl + position }.MatchEmptyOrDeleted(); free != 0)
+					return (position + static_cast<size_t>(std::countr_zero( free ))) & mask;
+
+				position = (position + step) & mask;
+			}
+		}
+
+		// Slot for a new entry, growing first if needed
+		size_t PrepareInsert( const size_t hash )
+		{
+			if (mCapacity == 0)
+				Rehash( GroupWidth );
+
+			const size_t idx = FindInsertIndex( hash );
+			if ((mGrowthLeft == 0) && (mpCtrl[idx] == av_detail_::FlatEmpty))
+			{
+				// mostly deleted slots, clean up in place rather than growing
+				Rehash( (mSize * 32 <= mCapacity * 25) ? mCapacity : mCapacity * 2 );
+				return FindInsertIndex( hash );
+			}
+
+			return idx;
+		}
+
+		// Once the entry is constructed, so a throwing constructor leaves the map as it was
+		void CommitInsert( const size_t idx, const size_t hash ) noexcept
+		{
+			mGrowthLeft -= (mpCtrl[idx] == av_detail_::FlatEmpty) ? 1 : 0;
+			SetCtrl( idx, H2( hash ) );
+			++mSize;
+		}
+
+		void EraseIndex( const size_t idx ) noexcept
+		{
+			std::destroy_at( mpSlots + idx );
+			SetCtrl( idx, av_detail_::FlatDeleted );
+			--mSize;
+		}
+
+		// the first group's control bytes are repeated after the last slot, so a group can be loaded from any position
+		void SetCtrl( const size_t idx, const Ctrl_T value ) noexcept
+		{
+			mpCtrl[idx] = value;
+			if (idx < GroupWidth)
+				mpCtrl[mCapacity + idx] = value;
+		}
+
+		void Rehash( const size_t new_capacity )
+		{
+			AV_ASSERT( std::has_single_bit( new_capacity ) && (new_capacity >= GroupWidth) && (GetMaxLoad( new_capacity ) >= mSize) );
+
+			auto* old_ctrl = mpCtrl;
+			auto* old_slots = mpSlots;
+			const size_t old_capacity = mCapacity;
+
+			mpCtrl = new Ctrl_T[new_capacity + GroupWidth];
+			mpSlots = std::allocator<value_type>{}.allocate( new_capacity );
+			mCapacity = new_capacity;
+			std::memset( mpCtrl, av_detail_::FlatEmpty, mCapacity + GroupWidth );
+
+			for (size_t i = 0; i < old_capacity; ++i)
+			{
+				if (old_ctrl[i] < 0)
+					continue;
+
+				const size_t hash = Hash{}(old_slots[i].first);
+				const size_t idx = FindInsertIndex( hash );
+				SetCtrl( idx, H2( hash ) );
+				std::construct_at( mpSlots + idx, std::move( old_slots[i] ) );
+				std::destroy_at( old_slots + i );
+			}
+
+			mGrowthLeft = GetMaxLoad( mCapacity ) - mSize;
+
+			if (old_capacity > 0)
+			{
+				delete[] old_ctrl;
+				std::allocator<value_type>{}.deallocate( old_slots, old_capacity );
+			}
+		}
+
+		void DestroySlots() noexcept
+		{
+			if constexpr (!std::is_trivially_destructible_v<value_type>)
+			{
+				for (size_t i = 0; i < mCapacity; ++i)
+				{
+					if (mpCtrl[i] >= 0)
+						std::destroy_at( mpSlots + i );
+				}
+			}
+		}
+
+		void Destroy() noexcept
+		{
+			if (mCapacity == 0)
+				return;
+
+			DestroySlots();
+			delete[] mpCtrl;
+			std::allocator<value_type>{}.deallocate( mpSlots, mCapacity );
+			mpCtrl = nullptr;
+			mpSlots = nullptr;
+			mCapacity = 0;
+			mSize = 0;
+			mGrowthLeft = 0;
+		}
+
+		void Swap( FlatHashMap& other ) noexcept
+		{
+			std::swap( mpCtrl, other.mpCtrl );
+			std::swap( mpSlots, other.mpSlots );
+			std::swap( mCapacity, other.mCapacity );
+			std::swap( mSize, other.mSize );
+			std::swap( mGrowthLeft, other.mGrowthLeft );
+		}
+
+	private:
+		Ctrl_T* mpCtrl = nullptr;
+		value_type* mpSlots = nullptr;
+		size_t mCapacity = 0; // a power of two, or 0 before anything is inserted
+		size_t mSize = 0;
+		size_t mGrowthLeft = 0;
+	};
+}
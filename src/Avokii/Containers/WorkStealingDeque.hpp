@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+namespace Avokii
+{
+	// Fixed size Chase-Lev deque of pointers
+	//
+	// The owning thread pushes and pops at the bottom, any other thread steals from the top.
+	// Lock-free, the only contention is on the last item when a pop and a steal race for it.
+	// Based on "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al. 2013), without growing.
+	template<class T, size_t Capacity>
+		requires std::is_pointer_v<T> && (std::has_single_bit( Capacity ))
+	class WorkStealingDeque final
+	{
+	public:
+		WorkStealingDeque() = default;
+		WorkStealingDeque( const WorkStealingDeque& ) = delete;
+		WorkStealingDeque& operator=( const WorkStealingDeque& ) = delete;
+
+		// Owner only, fails when full
+		bool Push( T item ) noexcept
+		{
+			const int64_t bottom = mBottom.load( std::memory_order_relaxed );
+			const int64_t top = mTop.load( std::memory_order_acquire );
+			if (bottom - top >= static_cast<int64_t>( Capacity ))
+				return false;
+
+			mItems[bottom & Mask].store( item, std::memory_order_relaxed );
+			// pairs with the acquire of mBottom in Steal(), publishing the item
+			mBottom.store( bottom + 1, std::memory_order_release );
+			return true;
+		}
+
+		// Owner only, newest first. nullptr when empty.
+		T Pop() noexcept
+		{
+			const int64_t bottom = mBottom.load( std::memory_order_relaxed ) - 1;
+			mBottom.store( bottom, std::memory_order_relaxed );
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			int64_t top = mTop.load( std::memory_order_relaxed );
+
+			if (top > bottom)
+			{
+				mBottom.store( bottom + 1, std::memory_order_relaxed );
+				return nullptr;
+			}
+
+			T item = mItems[bottom & Mask].load( std::memory_order_relaxed );
+			if (top == bottom)
+			{
+				// last item, a thief may be taking it too
+				if (!mTop.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ))
+					item = nullptr;
+				mBottom.store( bottom + 1, std::memory_order_relaxed );
+			}
+
+			return item;
+		}
+
+		// Any thread, oldest first. nullptr when empty or another thread got there first.
+		T Steal() noexcept
+		{
+			int64_t top = mTop.load( std::memory_order_acquire );
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			const int64_t bottom = mBottom.load( std::memory_order_acquire );
+			if (top >= bottom)
+				return nullptr;
+
+			T item = mItems[top & Mask].load( std::memory_order_relaxed );
+			if (!mTop.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ))
+				return nullptr;
+
+			return item;
+		}
+
+		// Approximate when other threads are using the deque
+		[[nodiscard]] bool IsEmpty() const noexcept { return mBottom.load( std::memory_order_relaxed ) <= mTop.load( std::memory_order_relaxed ); }
+
+	private:
+		static constexpr int64_t Mask = static_cast<int64_t>( Capacity ) - 1;
+
+		// kept apart so the owner and thieves don't share a cache line
+		alignas(64) std::atomic<int64_t> mTop{ 0 };
+		alignas(64) std::atomic<int64_t> mBottom{ 0 };
+		alignas(64) std::array<std::atomic<T>, Capacity> mItems{};
+	};
+}
@@ -2,6 +2,8 @@
 
 #include <assert.h>
 
+#include "Input/InputRecording.hpp"
+#include "Jobs/JobSystem.hpp"
 #include "Resources/ResourceManager.hpp"
 #include "AbstractGame.hpp"
 
@@ -15,14 +17,33 @@
 
 #include "Containers/ContainerOperations.hpp"
 
+#include "Profiling/Profiler.hpp"
+
 using namespace Avokii::ContainerOps;
 
 namespace Avokii
 {
+	namespace
+	{
+		double ToSeconds( std::chrono::nanoseconds duration ) noexcept
+		{
+			return std::chrono::duration<double>( duration ).count();
+		}
+	}
+
 	Core::Core( CoreProperties&& props, std::unique_ptr<AbstractGame> game )
 		: mpGame( std::move( game ) )
 		, mResourceInitaliserFunc{ props.resourceInitaliserFunc }
+		, mResourceManifest{ props.resourceManifest }
+		, mInputRecordingPath{ props.inputRecording }
+		, mInputReplayPath{ props.inputReplay }
 		, mTargetFps{ std::max( 0, props.fps ) }
+		, mJobWorkers{ props.jobWorkers }
+		, mPipelinedRendering{ props.pipelinedRendering }
+		, mLockstep{ props.lockstep || !props.inputReplay.empty() }
+		, mLockstepFrames{ props.lockstepFrames }
+		, mFixedTimestep{ (props.fps > 0) ? props.fps : 60.0, props.fixedStepPolicy }
+		, mFramePacer{ (props.maxRenderFps != 0.0) ? std::max( props.maxRenderFps, 0.0 ) : ((props.fps > 0) ? props.fps : 60.0) }
 	{
 		AV_ASSERT( props.IsValid() );
 		if (!props.IsValid())
@@ -52,12 +73,22 @@ namespace Avokii
 	{
 		assert( !mIsInitialised );
 
+		mpJobSystem = std::make_unique<JobSystem>( mJobWorkers );
 		InitResources();
 		InitAPIs();
+		if (mPipelinedRendering && rGetAPI<API::DearImGuiAPI>())
+		{
+			// ImGui's frame starts and ends around the game's update and is drawn in OnRender(), which would run concurrently
+			AV_LOG_WARN( LoggingChannels::Application, "Pipelined rendering isn't supported with the Dear ImGui plugin, rendering serially" );
+			mPipelinedRendering = false;
+		}
+		PreloadResources();
+		InitInputRecording();
 		InitRNG();
 
 		mpGame->mpCore = this;
 		mpGame->mpResourceManager = mpResourceManager.get();
+		mpGame->mpJobSystem = mpJobSystem.get();
 		mpGame->Init();
 
 		mIsInitialised = true;
@@ -65,63 +96,73 @@ namespace Avokii
 
 	int Core::Dispatch()
 	{
+		if (mLockstep)
+			return DispatchLockstep();
+
 		using Clock_T = std::chrono::steady_clock;
 
-		int64_t num_steps = 0;
 		const Clock_T::time_point start_time = Clock_T::now();
-		Clock_T::time_point target_time;
-		Clock_T::time_point last_time;
-		target_time = last_time = start_time;
+		Clock_T::time_point last_time = start_time;
 
-		if (mTargetFps <= 0)
+		while (mIsRunning)
 		{
-			while (mIsRunning)
-			{
-				const auto current_time = Clock_T::now();
-				const double current_time_seconds = std::chrono::duration_cast<std::chrono::milliseconds>(current_time.time_since_epoch()).count() / 1000.0;
-				constexpr double FixedDeltaTimeSeconds = 1.0 / 60.0;
-
-				const auto timestep = PreciseTimestep( current_time_seconds, FixedDeltaTimeSeconds );
-				DoFixedUpdate( timestep );
-				DoVariableUpdate( timestep );
-				rGetRequiredAPI<API::SystemAPI>().Sleep( static_cast<unsigned long>(FixedDeltaTimeSeconds * 1000) );
-			}
+			AV_PROFILE_NEW_FRAME();
+
+			const Clock_T::time_point current_time = Clock_T::now();
+
+			// without a fixed update rate every frame runs a single step
+			const auto fixed = (mTargetFps > 0) ? mFixedTimestep.Advance( current_time - last_time ) : mFixedTimestep.AdvanceSteps( 1 );
+
+			// Variable update
+			constexpr auto MaxDeltaTime = std::chrono::milliseconds( 100 );
+			const auto delta_time = std::min<Clock_T::duration>( current_time - last_time, MaxDeltaTime );
+			DoFrame( fixed, PreciseTimestep( ToSeconds( current_time - start_time ), ToSeconds( delta_time ), fixed.first_step + fixed.n_steps, fixed.alpha ) );
+
+			last_time = current_time;
+			mFramePacer.WaitForNextFrame();
 		}
-		else
-		{
-			while (mIsRunning)
-			{
-				Clock_T::time_point current_time = Clock_T::now();
-				const double current_time_seconds = std::chrono::duration_cast<std::chrono::milliseconds>(current_time.time_since_epoch()).count() / 1000.0;
 
-				// Time for a fixed update?
-				if (current_time >= target_time)
-				{
-					constexpr int MaxFixedStepsPerFrame = 5;
-					const double fixed_timestep_seconds = 1.0 / mTargetFps;
-
-					// Perform a given number of steps this frame
-					const int steps_needed = static_cast<int>(std::chrono::duration<float>( current_time - target_time ).count() * mTargetFps);
-					for (int i = 0; i < std::min( steps_needed, MaxFixedStepsPerFrame ); i++)
-						DoFixedUpdate( PreciseTimestep( current_time_seconds, fixed_timestep_seconds ) );
-
-					num_steps += steps_needed;
-					target_time = start_time + std::chrono::microseconds( (num_steps * 1000000ll) / mTargetFps );
-				}
-				else
-				{
-					std::this_thread::yield();
-				}
+		return 0;
+	}
+
+	int Core::DispatchLockstep()
+	{
+		using Clock_T = std::chrono::steady_clock;
+
+		const Clock_T::time_point start_time = Clock_T::now();
+		const uint64_t first_step = mFixedTimestep.GetNextStep();
+		std::chrono::nanoseconds time{ 0 };
+		uint64_t num_frames = 0;
+
+		while (mIsRunning && ((mLockstepFrames == 0) || (num_frames < mLockstepFrames)))
+		{
+			AV_PROFILE_NEW_FRAME();
 
-				// Variable update
-				constexpr double MaxDeltaTimeSeconds = 0.1;
-				const double seconds_since_last_frame = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - last_time).count() / 1000.0;
-				DoVariableUpdate( PreciseTimestep( current_time_seconds, std::min( seconds_since_last_frame, MaxDeltaTimeSeconds ) ) );
+			// a replay repeats the recorded frames' steps and deltas
+			FixedTimestep::Frame fixed;
+			std::chrono::nanoseconds delta_time = mFixedTimestep.GetStepLength();
+			if (mpInputReplay)
+			{
+				const auto replay_frame = mpInputReplay->NextFrame();
+				if (!replay_frame)
+					break;
 
-				last_time = current_time;
+				fixed = mFixedTimestep.AdvanceSteps( replay_frame->n_steps );
+				delta_time = replay_frame->delta;
 			}
+			else
+				fixed = mFixedTimestep.AdvanceSteps( 1 );
+
+			time += delta_time;
+			DoFrame( fixed, PreciseTimestep( ToSeconds( time ), ToSeconds( delta_time ), fixed.first_step + fixed.n_steps ) );
+			++num_frames;
 		}
 
+		const double elapsed_seconds = std::max( ToSeconds( Clock_T::now() - start_time ), 1.0e-9 );
+		const uint64_t num_steps = mFixedTimestep.GetNextStep() - first_step;
+		AV_LOG_INFO( LoggingChannels::Application, "Lock-step ran {} frames and {} fixed steps in {:.3f}s: {:.0f} frames/s, {:.0f} steps/s",
+			num_frames, num_steps, elapsed_seconds, num_frames / elapsed_seconds, num_steps / elapsed_seconds );
+
 		return 0;
 	}
 
@@ -136,11 +177,51 @@ namespace Avokii
 			mResourceInitaliserFunc( *mpResourceManager );
 	}
 
+	void Core::PreloadResources()
+	{
+		if (mResourceManifest.empty())
+			return;
+
+		AV_PROFILE_SCOPE( "Preload resources" );
+
+		ResourceManifest manifest;
+		if (!manifest.LoadFromFile( mResourceManifest ))
+			throw std::runtime_error( "Failed to load the resource manifest" );
+
+		// textures are finalised on the video API so this waits until the plugins are up
+		mpResourceManager->Preload( manifest );
+		mpResourceManager->WaitForAsyncLoads();
+	}
+
+	void Core::InitInputRecording()
+	{
+		if (!mInputReplayPath.empty())
+		{
+			mpInputReplay = std::make_unique<Input::InputReplay>();
+			if (!mpInputReplay->LoadFromFile( mInputReplayPath ))
+				throw std::runtime_error( "Failed to load the input replay" );
+
+			if (mpInputReplay->GetStepLength() != mFixedTimestep.GetStepLength())
+				AV_LOG_WARN( LoggingChannels::Application, "Input replay was recorded with {}ns fixed steps but is running with {}ns ones, it won't play out the same",
+					mpInputReplay->GetStepLength().count(), mFixedTimestep.GetStepLength().count() );
+		}
+
+		if (!mInputRecordingPath.empty())
+		{
+			mpInputRecorder = std::make_unique<Input::InputRecorder>( mInputRecordingPath, mFixedTimestep.GetStepLength() );
+			if (!mpInputRecorder->IsOpen())
+				throw std::runtime_error( "Failed to open the input recording" );
+		}
+	}
+
 	void Core::InitRNG()
 	{
 		time_t current_time = time( nullptr );
 		clock_t current_clock = clock();
 		int seed = static_cast<int>(current_time) ^ static_cast<int>(current_clock) ^ 0xb67b820e;
+		// lock-step runs have to play out the same every time
+		if (mLockstep)
+			seed = 0xb67b820e;
 		srand( seed );
 	}
 
@@ -148,7 +229,21 @@ namespace Avokii
 	{
 		AV_ASSERT( mIsInitialised );
 
+		const auto frame_stats = mFramePacer.GetStats();
+		AV_LOG_INFO( LoggingChannels::Application, "Last {} frames: mean {:.2f}ms, p50 {:.2f}ms, p95 {:.2f}ms, p99 {:.2f}ms, max {:.2f}ms, jitter {:.0f}us mean / {:.0f}us max, CPU {:.0f}%",
+			frame_stats.n_frames, frame_stats.mean_frame_ms, frame_stats.p50_frame_ms, frame_stats.p95_frame_ms, frame_stats.p99_frame_ms, frame_stats.max_frame_ms,
+			frame_stats.mean_jitter_us, frame_stats.max_jitter_us, frame_stats.cpu_utilisation * 100.0 );
+
+		const auto step_stats = mFixedTimestep.GetStats();
+		AV_LOG_INFO( LoggingChannels::Application, "{} fixed steps, {} dropped over {} capped frames, step cost mean {:.3f}ms, p99 {:.3f}ms, max {:.3f}ms",
+			step_stats.n_steps, step_stats.n_dropped_steps, step_stats.n_capped_frames, step_stats.mean_step_ms, step_stats.p99_step_ms, step_stats.max_step_ms );
+
+		if (mpInputRecorder)
+			mpInputRecorder->Finish();
+
 		mpGame->OnGameEnd();
+		// jobs can reference the game, finish them first
+		mpJobSystem.reset();
 		mpGame.reset();
 
 		ShutdownAPIs();
@@ -157,9 +252,79 @@ namespace Avokii
 		mIsInitialised = false;
 	}
 
+	void Core::DoFrame( const FixedTimestep::Frame& fixed, const PreciseTimestep& variable_ts )
+	{
+		if (mPipelinedRendering)
+		{
+			DoPipelinedFrame( fixed, variable_ts );
+			return;
+		}
+
+		for (int i = 0; i < fixed.n_steps; i++)
+			DoFixedUpdate( mFixedTimestep.GetStep( fixed.first_step + i ) );
+
+		DoVariableUpdate( variable_ts );
+	}
+
+	void Core::DoPipelinedFrame( const FixedTimestep::Frame& fixed, const PreciseTimestep& variable_ts )
+	{
+		AV_ASSERT( variable_ts.delta >= 0 );
+
+		// events and resources stay on the main thread, mIsRunning isn't written again until the simulation has finished
+		BeginVariableUpdate( variable_ts );
+
+		// on a worker, a wait while rendering (e.g. a ParallelFor) mustn't pick up the whole simulation on the main thread
+		JobCounter simulation;
+		if (mIsRunning)
+		{
+			mpJobSystem->RunOnWorker( [&]()
+				{
+					AV_PROFILE_SCOPE( "Simulation" );
+					for (int i = 0; i < fixed.n_steps; i++)
+						DoFixedUpdate( mFixedTimestep.GetStep( fixed.first_step + i ) );
+
+					mpGame->OnVariableUpdate( variable_ts );
+				}, &simulation );
+		}
+
+		// draws what the previous frame's updates handed off
+		try
+		{
+			DoRender( variable_ts );
+		}
+		catch (...)
+		{
+			// the simulation job references this frame, it has to finish before unwinding
+			try
+			{
+				mpJobSystem->Wait( simulation );
+			}
+			catch (const std::exception& e)
+			{
+				AV_LOG_ERROR( LoggingChannels::Application, "Simulation also threw while rendering failed: {}", e.what() );
+			}
+			catch (...)
+			{
+				AV_LOG_ERROR( LoggingChannels::Application, "Simulation also threw while rendering failed" );
+			}
+			throw;
+		}
+
+		{
+			AV_PROFILE_SCOPE( "Wait for simulation" );
+			mpJobSystem->Wait( simulation );
+		}
+
+		EndVariableUpdate( variable_ts );
+		if (mIsRunning)
+			mpGame->OnRenderHandoff();
+	}
+
 	void Core::DoFixedUpdate( const PreciseTimestep& ts )
 	{
+		AV_PROFILE_SCOPE( "Fixed update" );
 		assert( ts.delta > 0 );
+		const auto step_start = FixedTimestep::Clock_T::now();
 
 		for (auto& plugin : mActiveApis)
 			plugin->OnFixedUpdate( ts, StepType::PreGameStep );
@@ -169,12 +334,36 @@ namespace Avokii
 
 		for (auto& plugin : mActiveApis)
 			plugin->OnFixedUpdate( ts, StepType::PostGameStep );
+
+		mFixedTimestep.RecordStepCost( FixedTimestep::Clock_T::now() - step_start );
 	}
 
 	void Core::DoVariableUpdate( const PreciseTimestep& ts )
 	{
 		AV_ASSERT( ts.delta >= 0 );
+		{
+			AV_PROFILE_SCOPE( "Variable update" );
+			BeginVariableUpdate( ts );
+
+			if (mIsRunning)
+				mpGame->OnVariableUpdate( ts );
+
+			EndVariableUpdate( ts );
+		}
+
+		if (mIsRunning)
+			mpGame->OnRenderHandoff();
+
+		DoRender( ts );
+	}
+
+	void Core::BeginVariableUpdate( const PreciseTimestep& ts )
+	{
 		PumpEvents( ts );
+		mpJobSystem->ProcessMainThreadJobs();
+		mpResourceManager->ProcessHotReloads();
+		mpResourceManager->ProcessAsyncLoads();
+		mpResourceManager->NextGeneration();
 
 		for (auto& plugin : mActiveApis)
 			plugin->OnVariableUpdate( ts, StepType::PreGameStep );
@@ -184,21 +373,21 @@ namespace Avokii
 			mExitCode = mpGame->GetExitCode().value();
 			mIsRunning = false;
 		}
+	}
 
-		if (mIsRunning)
-			mpGame->OnVariableUpdate( ts );
-
+	void Core::EndVariableUpdate( const PreciseTimestep& ts )
+	{
 		for (auto& plugin : mActiveApis)
 			plugin->OnVariableUpdate( ts, StepType::PostGameStep );
-
-		DoRender( ts );
 	}
 
 	void Core::DoRender( const PreciseTimestep& ts )
 	{
 		if (auto* video_api = rGetAPI<API::VideoAPI>())
 		{
+			AV_PROFILE_SCOPE( "Render" );
 			video_api->BeginRender();
+			AV_PROFILE_GPU_BEGIN( *video_api, "Render" );
 
 			for (auto& plugin : mActiveApis)
 				plugin->OnRender( ts, StepType::PreGameStep );
@@ -209,12 +398,17 @@ namespace Avokii
 			for (auto& plugin : mActiveApis)
 				plugin->OnRender( ts, StepType::PostGameStep );
 
-			video_api->EndRender();
+			AV_PROFILE_GPU_END( *video_api );
+			{
+				AV_PROFILE_SCOPE( "Present" );
+				video_api->EndRender();
+			}
 		}
 	}
 
 	void Core::PumpEvents( const PreciseTimestep& ts )
 	{
+		AV_PROFILE_SCOPE( "Pump events" );
 		auto* system_api = rGetAPI<API::SystemAPI>();
 		auto* input_api = rGetAPI<API::InputAPI>();
 		auto* video_api = rGetAPI<API::VideoAPI>();
@@ -228,6 +422,15 @@ namespace Avokii
 			mExitCode = 0;
 			mIsRunning = false;
 		}
+
+		if (input_api)
+		{
+			// a replay's input replaces whatever the devices got this frame
+			if (mpInputReplay)
+				mpInputReplay->Apply( *input_api );
+			if (mpInputRecorder)
+				mpInputRecorder->Capture( *input_api, ts );
+		}
 	}
 
 	void Core::InitAPIs()
@@ -4,14 +4,24 @@
 #include <vector>
 
 #include "API/CoreAPIsEnum.hpp"
+#include "File/Filepath.hpp"
+#include "FixedTimestep.hpp"
+#include "FramePacer.hpp"
 #include "Timestep.hpp"
 
 namespace Avokii
 {
 	class AbstractGame;
 	class Core;
+	class JobSystem;
 	class ResourceManager;
 
+	namespace Input
+	{
+		class InputRecorder;
+		class InputReplay;
+	}
+
 	namespace API
 	{
 		class BaseAPI;
@@ -22,8 +32,25 @@ namespace Avokii
 	struct CoreProperties
 	{
 		int fps = 60;
+		FixedStepPolicy fixedStepPolicy;
+		double maxRenderFps = 0.0; // 0 to render at the fixed update rate (or 60 without one), negative for uncapped
+		unsigned jobWorkers = 0; // 0 for one per core, leaving one for the main thread
+		// Runs the game's updates for the next frame on a worker while the current frame renders, overlapping simulation with
+		// the wait for the swap at the cost of a frame of input latency. The game's updates must then leave the video API
+		// and anything OnRender() reads alone, handing state over with AbstractGame::OnRenderHandoff(), and must not load
+		// resources (the ResourceManager is main thread only). Ignored with the Dear ImGui plugin, its frame can't be split
+		// across threads.
+		bool pipelinedRendering = false;
 
 		std::function<void( ResourceManager& )> resourceInitaliserFunc;
+		Filepath resourceManifest; // optional, see ResourceManifest. Preloaded once the plugins are up, before the game is initialised.
+
+		// Runs frames back to back without the wall clock, each a single fixed step with time advancing by exactly a step.
+		// Reproducible frame for frame given the same input, for benchmarking the game headless (e.g. with the null video plugin).
+		bool lockstep = false;
+		uint64_t lockstepFrames = 0; // exits after this many frames, 0 to run until the game exits or the replay ends
+		Filepath inputRecording; // optional, streams the button input and steps of every frame to this file, see Input::InputRecorder
+		Filepath inputReplay; // optional, replays a recording in lock-step, repeating its frames' steps and input
 
 		unsigned maxPlugins = 0;
 		std::function<std::unique_ptr<API::BaseAPI>( Core&, APIType )> pluginFactory;
@@ -32,6 +59,8 @@ namespace Avokii
 		{
 			return true
 				&& (fps >= 0)
+				&& (fixedStepPolicy.maxStepsPerFrame > 0)
+				&& (fixedStepPolicy.maxBacklogSteps >= 0)
 				&& (maxPlugins >= CoreAPIs::Type::User)
 				&& (bool)resourceInitaliserFunc
 				&& (bool)pluginFactory
@@ -59,6 +88,9 @@ namespace Avokii
 
 		AbstractGame& GetGame() const { return *mpGame; }
 		ResourceManager& GetResourceManager() const { return *mpResourceManager; }
+		const FramePacer& GetFramePacer() const noexcept { return mFramePacer; }
+		const FixedTimestep& GetFixedTimestep() const noexcept { return mFixedTimestep; }
+		JobSystem& rGetJobSystem() noexcept { return *mpJobSystem; }
 
 		template<APIConcept API_T>
 		API_T* rGetAPI() noexcept
@@ -108,13 +140,22 @@ namespace Avokii
 		int Dispatch();
 
 	private:
+		int DispatchLockstep();
+
 		void InitResources();
+		void PreloadResources();
+		void InitInputRecording();
 		void InitRNG();
 
 		void Shutdown();
 
+		void DoFrame( const FixedTimestep::Frame& fixed, const PreciseTimestep& variable_ts );
+		void DoPipelinedFrame( const FixedTimestep::Frame& fixed, const PreciseTimestep& variable_ts );
 		void DoFixedUpdate( const PreciseTimestep& ts );
 		void DoVariableUpdate( const PreciseTimestep& ts );
+		// The main thread halves of the variable update, either side of the game's
+		void BeginVariableUpdate( const PreciseTimestep& ts );
+		void EndVariableUpdate( const PreciseTimestep& ts );
 		void DoRender( const PreciseTimestep& ts );
 
 		void PumpEvents( const PreciseTimestep& ts );
@@ -126,13 +167,26 @@ namespace Avokii
 		bool mIsInitialised = false;
 
 		int mTargetFps;
+		const unsigned mJobWorkers;
+		bool mPipelinedRendering;
+		const bool mLockstep;
+		const uint64_t mLockstepFrames;
+		FixedTimestep mFixedTimestep;
+		FramePacer mFramePacer;
 		bool mIsRunning = true;
 		int mExitCode = -1;
 
 		std::unique_ptr<AbstractGame> mpGame;
+		std::unique_ptr<JobSystem> mpJobSystem;
 		std::unique_ptr<ResourceManager> mpResourceManager;
 
 		const std::function<void( ResourceManager& )> mResourceInitaliserFunc;
+		const Filepath mResourceManifest;
+
+		const Filepath mInputRecordingPath;
+		const Filepath mInputReplayPath;
+		std::unique_ptr<Input::InputRecorder> mpInputRecorder;
+		std::unique_ptr<Input::InputReplay> mpInputReplay;
 
 		std::vector<std::unique_ptr<API::BaseAPI>> mApis;
 		std::vector<API::BaseAPI*> mActiveApis;
@@ -0,0 +1,222 @@
+#include "AssetArchive.hpp"
+
+#include "FileOps.hpp"
+
+namespace Avokii
+{
+	namespace
+	{
+		bool EntryLess( const AssetArchive::Entry& a, const AssetArchive::Entry& b ) noexcept
+		{
+			return a.resource_id < b.resource_id;
+		}
+
+		uint64_t AlignUp( uint64_t value, uint64_t alignment ) noexcept
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+
+		// [offset, offset + size) lies within [0, total), without `offset + size` wrapping around
+		bool IsInBounds( uint64_t offset, uint64_t size, uint64_t total ) noexcept
+		{
+			return (offset <= total) && (size <= total - offset);
+		}
+	}
+
+	///
+	/// AssetArchive
+	///
+
+	bool AssetArchive::Open( const Filepath& filepath )
+	{
+		Close();
+		if (!mFile.Open( filepath ))
+			return false;
+
+		const auto data = mFile.GetData();
+		const auto fail = [&]( std::string_view reason )
+		{
+			AV_LOG_ERROR( LoggingChannels::Resource, "'{}' is not a valid asset archive: {}", filepath.generic_string(), reason );
+			Close();
+			return false;
+		};
+
+		if (data.size() < sizeof( Header ))
+			return fail( "too small for the header" );
+
+		Header header;
+		std::memcpy( &header, data.data(), sizeof( Header ) );
+		if (header.magic != Magic)
+			return fail( "bad magic" );
+		if (header.version != Version)
+			return fail( "unsupported version" );
+
+		// entry_count is bounded by the space left before multiplying, so the index size can't overflow either
+		if ((header.index_offset % alignof( Entry ) != 0) || (header.index_offset > data.size())
+			|| (header.entry_count > (data.size() - header.index_offset) / sizeof( Entry )) || (header.names_offset > data.size()))
+			return fail( "index out of bounds" );
+
+		mEntries = { reinterpret_cast<const Entry*>(data.data() + header.index_offset), header.entry_count };
+		mNames = { reinterpret_cast<const char*>(data.data() + header.names_offset), static_cast<size_t>( data.size() - header.names_offset ) };
+
+		// checked once here so lookups can trust the index
+		for (const auto& entry : mEntries)
+		{
+			if (!IsInBounds( entry.offset, entry.size, data.size() ) || !IsInBounds( entry.name_offset, entry.name_length, mNames.size() ))
+				return fail( "entry out of bounds" );
+		}
+		if (!std::is_sorted( std::begin( mEntries ), std::end( mEntries ), EntryLess ))
+			return fail( "index isn't sorted" );
+
+		mFilepath = filepath;
+		AV_LOG_INFO( LoggingChannels::Resource, "Opened asset archive '{}' with {} entries", filepath.generic_string(), mEntries.size() );
+		return true;
+	}
+
+	void AssetArchive::Close() noexcept
+	{
+		mEntries = {};
+		mNames = {};
+		mFile.Close();
+		mFilepath.clear();
+	}
+
+	std::optional<std::span<const std::byte>> AssetArchive::Find( StringView asset_id ) const
+	{
+		Entry key{};
+		key.resource_id = ToResourceId( asset_id ).value();
+
+		// ids can collide, the names settle it
+		const auto [first, last] = std::equal_range( std::begin( mEntries ), std::end( mEntries ), key, EntryLess );
+		for (auto it = first; it != last; ++it)
+		{
+			if (mNames.substr( it->name_offset, it->name_length ) != asset_id)
+				continue;
+
+			if (it->compression != ArchiveCompression::None)
+			{
+				AV_LOG_ERROR( LoggingChannels::Resource, "Asset '{}' in '{}' uses an unsupported compression", asset_id, mFilepath.generic_string() );
+				return std::nullopt;
+			}
+
+			return mFile.GetData().subspan( static_cast<size_t>( it->offset ), static_cast<size_t>( it->size ) );
+		}
+
+		return std::nullopt;
+	}
+
+	StringView AssetArchive::GetEntryAssetId( size_t idx ) const
+	{
+		const auto& entry = mEntries[idx];
+		return mNames.substr( entry.name_offset, entry.name_length );
+	}
+
+	///
+	/// AssetArchiveBuilder
+	///
+
+	void AssetArchiveBuilder::AddFile( StringView asset_id, const Filepath& source )
+	{
+		mFiles.push_back( PendingFile{ String{ asset_id }, source } );
+	}
+
+	void AssetArchiveBuilder::AddDirectory( const Filepath& directory, const Filepath& asset_id_prefix )
+	{
+		for (const auto& entry : std::filesystem::recursive_directory_iterator( directory ))
+		{
+			if (!entry.is_regular_file())
+				continue;
+
+			const auto asset_id = (asset_id_prefix / std::filesystem::relative( entry.path(), directory )).lexically_normal().generic_string();
+			AddFile( asset_id, entry.path() );
+		}
+	}
+
+	bool AssetArchiveBuilder::Write( const Filepath& output ) const
+	{
+		std::vector<AssetArchive::Entry> entries;
+		entries.reserve( mFiles.size() );
+
+		String names;
+		std::unordered_set<StringView> seen_ids;
+		for (const auto& file : mFiles)
+		{
+			if (!seen_ids.insert( file.asset_id ).second)
+			{
+				AV_LOG_ERROR( LoggingChannels::Resource, "Asset id '{}' was added to the archive more than once", file.asset_id );
+				return false;
+			}
+
+			AssetArchive::Entry entry{};
+			entry.resource_id = ToResourceId( file.asset_id ).value();
+			entry.compression = ArchiveCompression::None;
+			entry.name_offset = static_cast<uint32_t>( names.size() );
+			entry.name_length = static_cast<uint32_t>( file.asset_id.size() );
+			names += file.asset_id;
+			entries.push_back( entry );
+		}
+
+		// sort the files along with their entries so the data is laid out in index order
+		std::vector<size_t> order( mFiles.size() );
+		for (size_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+		std::stable_sort( std::begin( order ), std::end( order ), [&]( size_t a, size_t b ) { return EntryLess( entries[a], entries[b] ); } );
+
+		AssetArchive::Header header{};
+		header.magic = AssetArchive::Magic;
+		header.version = AssetArchive::Version;
+		header.entry_count = static_cast<uint32_t>( entries.size() );
+		header.index_offset = sizeof( AssetArchive::Header );
+		header.names_offset = header.index_offset + entries.size() * sizeof( AssetArchive::Entry );
+
+		std::ofstream out( output, std::ios::binary | std::ios::trunc );
+		if (!out)
+		{
+			AV_LOG_ERROR( LoggingChannels::Resource, "Failed to open '{}' to write the asset archive", output.generic_string() );
+			return false;
+		}
+
+		// data goes after the names, the index is written last once the offsets are known
+		uint64_t position = AlignUp( header.names_offset + names.size(), AssetArchive::DataAlignment );
+		out.seekp( static_cast<std::streamoff>( position ) );
+
+		std::vector<AssetArchive::Entry> sorted_entries;
+		sorted_entries.reserve( entries.size() );
+		std::vector<std::byte> contents;
+		for (const size_t idx : order)
+		{
+			const auto& file = mFiles[idx];
+			if (!FileOps::ReadFile( file.source, contents ))
+			{
+				AV_LOG_ERROR( LoggingChannels::Resource, "Failed to read '{}' for the asset archive", file.source.generic_string() );
+				return false;
+			}
+
+			const uint64_t aligned_position = AlignUp( position, AssetArchive::DataAlignment );
+			for (; position < aligned_position; ++position)
+				out.put( 0 );
+
+			auto entry = entries[idx];
+			entry.offset = position;
+			entry.size = contents.size();
+			sorted_entries.push_back( entry );
+
+			out.write( reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>( contents.size() ) );
+			position += contents.size();
+		}
+
+		out.seekp( 0 );
+		out.write( reinterpret_cast<const char*>(&header), sizeof( header ) );
+		out.write( reinterpret_cast<const char*>(sorted_entries.data()), static_cast<std::streamsize>( sorted_entries.size() * sizeof( AssetArchive::Entry ) ) );
+		out.write( names.data(), static_cast<std::streamsize>( names.size() ) );
+
+		if (!out)
+		{
+			AV_LOG_ERROR( LoggingChannels::Resource, "Failed writing the asset archive '{}'", output.generic_string() );
+			return false;
+		}
+
+		AV_LOG_INFO( LoggingChannels::Resource, "Wrote {} assets ({} bytes) to '{}'", sorted_entries.size(), position, output.generic_string() );
+		return true;
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <span>
+
+#include "Filepath.hpp"
+#include "MappedFile.hpp"
+#include "Avokii/Resources/ResourceId.hpp"
+
+namespace Avokii
+{
+	enum class ArchiveCompression : uint32_t
+	{
+		None = 0,
+	};
+
+	// Packed assets, memory mapped and read without copying
+	//
+	// Layout: a Header, the Entry index sorted by resource id, a block of asset id strings, then the file contents.
+	// Entries are looked up by asset id, the same id the asset would be loaded by as a loose file.
+	class AssetArchive final
+	{
+	public:
+		static constexpr uint32_t Magic = 0x4B505641; // "AVPK"
+		static constexpr uint32_t Version = 1;
+		static constexpr uint64_t DataAlignment = 16;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entry_count;
+			uint32_t reserved;
+			uint64_t index_offset;
+			uint64_t names_offset;
+		};
+		static_assert(sizeof( Header ) == 32);
+
+		struct Entry
+		{
+			uint32_t resource_id;
+			ArchiveCompression compression;
+			uint64_t offset; // from the start of the archive
+			uint64_t size;
+			uint32_t name_offset; // into the names block
+			uint32_t name_length;
+		};
+		static_assert(sizeof( Entry ) == 32);
+		static_assert(sizeof( ResourceId::hash_type ) == sizeof( Entry::resource_id ));
+
+	public:
+		bool Open( const Filepath& filepath );
+		void Close() noexcept;
+
+		[[nodiscard]] bool IsOpen() const noexcept { return mFile.IsOpen(); }
+		[[nodiscard]] const Filepath& GetFilepath() const noexcept { return mFilepath; }
+
+		// Contents of the asset, valid until the archive is closed. nullopt if the archive doesn't contain it.
+		[[nodiscard]] std::optional<std::span<const std::byte>> Find( StringView asset_id ) const;
+		[[nodiscard]] bool Contains( StringView asset_id ) const { return Find( asset_id ).has_value(); }
+
+		[[nodiscard]] size_t GetEntryCount() const noexcept { return mEntries.size(); }
+		[[nodiscard]] StringView GetEntryAssetId( size_t idx ) const;
+
+	private:
+		Filepath mFilepath;
+		MappedFile mFile;
+		std::span<const Entry> mEntries;
+		StringView mNames;
+	};
+
+	// Writes AssetArchives, from loose files on disk
+	class AssetArchiveBuilder final
+	{
+	public:
+		// `asset_id` is what the asset is loaded by, usually its path relative to the working directory
+		void AddFile( StringView asset_id, const Filepath& source );
+		// Every file under `directory`, with asset ids of `asset_id_prefix` joined with the path relative to `directory`
+		void AddDirectory( const Filepath& directory, const Filepath& asset_id_prefix );
+
+		[[nodiscard]] size_t GetFileCount() const noexcept { return mFiles.size(); }
+
+		// Fails if a file can't be read or two files share an asset id
+		bool Write( const Filepath& output ) const;
+
+	private:
+		struct PendingFile
+		{
+			String asset_id;
+			Filepath source;
+		};
+		std::vector<PendingFile> mFiles;
+	};
+}
@@ -40,6 +40,21 @@ namespace Avokii::FileOps
 		return false;
 	}
 
+	bool ReadFile( const Filepath& filename, std::vector<std::byte>& file_contents )
+	{
+		std::ifstream file( filename, std::ios::binary );
+		if (!file.is_open())
+			return false;
+
+		const std::streamoff len = StreamSize( file );
+		if (len == -1)
+			return false;
+
+		file_contents.resize( static_cast<size_t>(len) );
+		file.read( reinterpret_cast<char*>(file_contents.data()), len );
+		return true;
+	}
+
 	std::vector<String> GetFilesInFolder( const Filepath& path )
 	{
 		std::vector<String> filenames{};
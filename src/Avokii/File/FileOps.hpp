@@ -17,6 +17,7 @@ namespace Avokii::FileOps
 
 	bool ReadFile( const Filepath& filename, String& out_file_contents );
 	inline bool ReadFile( StringView filename, String& out_file_contents ) { return ReadFile( Filepath{ filename }, out_file_contents ); }
+	bool ReadFile( const Filepath& filename, std::vector<std::byte>& out_file_contents );
 
 	std::vector<String> GetFilesInFolder( const Filepath& path );
 	inline std::vector<String> GetFilesInFolder( StringView path ) { return GetFilesInFolder( Filepath{ path } ); }
@@ -0,0 +1,124 @@
+#include "FileWatcher.hpp"
+
+namespace Avokii
+{
+	std::vector<Filepath> FileWatcher::PollChanges()
+	{
+		std::vector<Filepath> settled;
+		const auto now = Clock_T::now();
+
+		std::scoped_lock lock( mMutex );
+		for (auto it = std::begin( mPending ); it != std::end( mPending ); )
+		{
+			if (now - it->second >= mSettleTime)
+			{
+				settled.push_back( mDirectory / it->first );
+				it = mPending.erase( it );
+			}
+			else
+				++it;
+		}
+
+		return settled;
+	}
+}
+
+#ifdef AVOKII_PLATFORM_WINDOWS
+#include "Avokii/Platform/Windows/WindowsHeader.hpp"
+
+namespace Avokii
+{
+	FileWatcher::FileWatcher( Filepath directory, Clock_T::duration settle_time )
+		: mDirectory{ std::move( directory ) }
+		, mSettleTime{ settle_time }
+	{
+		HANDLE directory_handle = ::CreateFileW( mDirectory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr );
+		if (directory_handle == INVALID_HANDLE_VALUE)
+		{
+			AV_LOG_ERROR( LoggingChannels::Application, "Failed to watch '{}', error {}", mDirectory.generic_string(), ::GetLastError() );
+			return;
+		}
+
+		mDirectoryHandle = directory_handle;
+		mStopEvent = ::CreateEventW( nullptr, TRUE, FALSE, nullptr );
+		mThread = std::thread( [this]() { WatchThread(); } );
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		if (mThread.joinable())
+		{
+			::SetEvent( mStopEvent );
+			mThread.join();
+		}
+
+		if (mStopEvent)
+			::CloseHandle( mStopEvent );
+		if (mDirectoryHandle)
+			::CloseHandle( mDirectoryHandle );
+	}
+
+	void FileWatcher::WatchThread()
+	{
+		const HANDLE directory_handle = mDirectoryHandle;
+		constexpr DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+
+		// ReadDirectoryChangesW wants a DWORD aligned buffer
+		std::vector<DWORD> buffer( 16 * 1024 );
+
+		OVERLAPPED overlapped{};
+		overlapped.hEvent = ::CreateEventW( nullptr, TRUE, FALSE, nullptr );
+		const HANDLE wait_handles[] = { overlapped.hEvent, mStopEvent };
+
+		while (true)
+		{
+			::ResetEvent( overlapped.hEvent );
+			if (!::ReadDirectoryChangesW( directory_handle, buffer.data(), static_cast<DWORD>(buffer.size() * sizeof( DWORD )), TRUE, filter, nullptr, &overlapped, nullptr ))
+			{
+				AV_LOG_ERROR( LoggingChannels::Application, "Stopped watching '{}', error {}", mDirectory.generic_string(), ::GetLastError() );
+				break;
+			}
+
+			DWORD n_bytes = 0;
+			if (::WaitForMultipleObjects( 2, wait_handles, FALSE, INFINITE ) != WAIT_OBJECT_0)
+			{
+				::CancelIoEx( directory_handle, &overlapped );
+				::GetOverlappedResult( directory_handle, &overlapped, &n_bytes, TRUE );
+				break;
+			}
+
+			if (!::GetOverlappedResult( directory_handle, &overlapped, &n_bytes, FALSE ))
+			{
+				AV_LOG_ERROR( LoggingChannels::Application, "Stopped watching '{}', error {}", mDirectory.generic_string(), ::GetLastError() );
+				break;
+			}
+
+			if (n_bytes == 0)
+			{
+				AV_LOG_WARN( LoggingChannels::Application, "Too many changes in '{}' at once, some were missed", mDirectory.generic_string() );
+				continue;
+			}
+
+			const auto now = Clock_T::now();
+			std::scoped_lock lock( mMutex );
+			for (const auto* p = reinterpret_cast<const std::byte*>(buffer.data()); ; )
+			{
+				const auto& info = *reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+				if ((info.Action == FILE_ACTION_ADDED) || (info.Action == FILE_ACTION_MODIFIED) || (info.Action == FILE_ACTION_RENAMED_NEW_NAME))
+				{
+					const Filepath relative_path{ std::wstring_view{ info.FileName, info.FileNameLength / sizeof( WCHAR ) } };
+					mPending[relative_path.generic_string()] = now;
+				}
+
+				if (info.NextEntryOffset == 0)
+					break;
+
+				p += info.NextEntryOffset;
+			}
+		}
+
+		::CloseHandle( overlapped.hEvent );
+	}
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "Filepath.hpp"
+
+namespace Avokii
+{
+	// Watches a directory tree for written, created and renamed files on a background thread.
+	//
+	// Changes are batched, a file is only reported once it has gone `settle_time` without changing again.
+	// A burst of writes, like an atlas being re-exported or an editor saving through a temporary file, comes through once.
+	class FileWatcher final
+	{
+	public:
+		using Clock_T = std::chrono::steady_clock;
+
+		explicit FileWatcher( Filepath directory, Clock_T::duration settle_time = std::chrono::milliseconds( 250 ) );
+		~FileWatcher();
+
+		FileWatcher( const FileWatcher& ) = delete;
+		FileWatcher& operator=( const FileWatcher& ) = delete;
+
+		[[nodiscard]] bool IsWatching() const noexcept { return mThread.joinable(); }
+		[[nodiscard]] const Filepath& GetDirectory() const noexcept { return mDirectory; }
+
+		// Files that have settled since the last call, as the watched directory joined with the path below it
+		[[nodiscard]] std::vector<Filepath> PollChanges();
+
+	private:
+		void WatchThread();
+
+	private:
+		const Filepath mDirectory;
+		const Clock_T::duration mSettleTime;
+
+		void* mDirectoryHandle = nullptr;
+		void* mStopEvent = nullptr;
+		std::thread mThread;
+
+		std::mutex mMutex;
+		std::unordered_map<String, Clock_T::time_point> mPending; // relative path to when it last changed
+	};
+}
@@ -0,0 +1,89 @@
+#include "MappedFile.hpp"
+
+#ifdef AVOKII_PLATFORM_WINDOWS
+#include "Avokii/Platform/Windows/WindowsHeader.hpp"
+
+namespace Avokii
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile( MappedFile&& other ) noexcept
+	{
+		*this = std::move( other );
+	}
+
+	MappedFile& MappedFile::operator=( MappedFile&& other ) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			mFileHandle = std::exchange( other.mFileHandle, nullptr );
+			mMappingHandle = std::exchange( other.mMappingHandle, nullptr );
+			mpData = std::exchange( other.mpData, nullptr );
+			mSize = std::exchange( other.mSize, 0 );
+		}
+		return *this;
+	}
+
+	bool MappedFile::Open( const Filepath& filepath )
+	{
+		Close();
+
+		HANDLE file = ::CreateFileW( filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr );
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			AV_LOG_ERROR( LoggingChannels::Application, "Failed to open '{}' for mapping, error {}", filepath.generic_string(), ::GetLastError() );
+			return false;
+		}
+		mFileHandle = file;
+
+		LARGE_INTEGER file_size{};
+		if (!::GetFileSizeEx( file, &file_size ) || (file_size.QuadPart == 0))
+		{
+			// empty files can't be mapped
+			AV_LOG_ERROR( LoggingChannels::Application, "Can't map '{}', it's empty or its size couldn't be read", filepath.generic_string() );
+			Close();
+			return false;
+		}
+
+		HANDLE mapping = ::CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if (mapping == nullptr)
+		{
+			AV_LOG_ERROR( LoggingChannels::Application, "Failed to create a mapping of '{}', error {}", filepath.generic_string(), ::GetLastError() );
+			Close();
+			return false;
+		}
+		mMappingHandle = mapping;
+
+		mpData = static_cast<const std::byte*>(::MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ));
+		if (mpData == nullptr)
+		{
+			AV_LOG_ERROR( LoggingChannels::Application, "Failed to map a view of '{}', error {}", filepath.generic_string(), ::GetLastError() );
+			Close();
+			return false;
+		}
+		mSize = static_cast<size_t>(file_size.QuadPart);
+
+		return true;
+	}
+
+	void MappedFile::Close() noexcept
+	{
+		if (mpData)
+			::UnmapViewOfFile( mpData );
+		if (mMappingHandle)
+			::CloseHandle( mMappingHandle );
+		if (mFileHandle)
+			::CloseHandle( mFileHandle );
+
+		mpData = nullptr;
+		mMappingHandle = nullptr;
+		mFileHandle = nullptr;
+		mSize = 0;
+	}
+}
+
+#endif
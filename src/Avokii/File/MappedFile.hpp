@@ -0,0 +1,34 @@
+#pragma once
+
+#include <span>
+
+#include "Filepath.hpp"
+
+namespace Avokii
+{
+	// Read-only memory mapping of a whole file, pages are read in by the OS as they're touched
+	class MappedFile final
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile( MappedFile&& other ) noexcept;
+		MappedFile& operator=( MappedFile&& other ) noexcept;
+		MappedFile( const MappedFile& ) = delete;
+		MappedFile& operator=( const MappedFile& ) = delete;
+
+		bool Open( const Filepath& filepath );
+		void Close() noexcept;
+
+		[[nodiscard]] bool IsOpen() const noexcept { return mpData != nullptr; }
+		// Valid until the file is closed
+		[[nodiscard]] std::span<const std::byte> GetData() const noexcept { return { mpData, mSize }; }
+
+	private:
+		void* mFileHandle = nullptr;
+		void* mMappingHandle = nullptr;
+		const std::byte* mpData = nullptr;
+		size_t mSize = 0;
+	};
+}
@@ -0,0 +1,90 @@
+#include "FixedTimestep.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Avokii
+{
+	FixedTimestep::FixedTimestep( double steps_per_second, const FixedStepPolicy& policy )
+		: mPolicy{ policy }
+		, mStepLength{ std::max<int64_t>( 1, std::llround( 1.0e9 / std::max( steps_per_second, 1.0e-3 ) ) ) }
+	{
+		AV_ASSERT( steps_per_second > 0.0 );
+		AV_ASSERT( policy.maxStepsPerFrame > 0 );
+		AV_ASSERT( policy.maxBacklogSteps >= 0 );
+	}
+
+	FixedTimestep::Frame FixedTimestep::Advance( std::chrono::nanoseconds elapsed )
+	{
+		mAccumulated += std::max( elapsed, std::chrono::nanoseconds{ 0 } );
+
+		const int64_t steps_due = mAccumulated / mStepLength;
+		const int64_t steps_run = std::min<int64_t>( steps_due, mPolicy.maxStepsPerFrame );
+		const int64_t steps_dropped = std::max<int64_t>( 0, steps_due - steps_run - mPolicy.maxBacklogSteps );
+		if (steps_run < steps_due)
+			++mNumCappedFrames;
+		mNumDroppedSteps += steps_dropped;
+		mAccumulated -= (steps_run + steps_dropped) * mStepLength;
+
+		Frame frame;
+		frame.first_step = mNextStep;
+		frame.n_steps = static_cast<int>( steps_run );
+		// a carried backlog leaves more than a step accumulated, the latest state is as far as rendering can go
+		frame.alpha = std::min( 1.0, static_cast<double>( mAccumulated.count() ) / static_cast<double>( mStepLength.count() ) );
+
+		mNextStep += steps_run;
+		return frame;
+	}
+
+	FixedTimestep::Frame FixedTimestep::AdvanceSteps( int n_steps )
+	{
+		AV_ASSERT( n_steps >= 0 );
+
+		Frame frame;
+		frame.first_step = mNextStep;
+		frame.n_steps = n_steps;
+		mNextStep += n_steps;
+		return frame;
+	}
+
+	PreciseTimestep FixedTimestep::GetStep( uint64_t step ) const noexcept
+	{
+		const double step_seconds = std::chrono::duration<double>( mStepLength ).count();
+		// from the integer step time so late steps don't collect rounding error
+		const double time = std::chrono::duration<double>( mStepLength * static_cast<int64_t>( step ) ).count();
+		return PreciseTimestep( time, step_seconds, step );
+	}
+
+	void FixedTimestep::RecordStepCost( Clock_T::duration cost ) noexcept
+	{
+		mStepCostMs[mNumStepCosts % HistorySize] = std::chrono::duration<float, std::milli>( cost ).count();
+		++mNumStepCosts;
+	}
+
+	FixedTimestep::Stats FixedTimestep::GetStats() const
+	{
+		Stats stats;
+		stats.n_steps = mNextStep;
+		stats.n_dropped_steps = mNumDroppedSteps;
+		stats.n_capped_frames = mNumCappedFrames;
+
+		const size_t n_costs = static_cast<size_t>( std::min<uint64_t>( mNumStepCosts, HistorySize ) );
+		if (n_costs == 0)
+			return stats;
+
+		std::vector<float> costs( std::begin( mStepCostMs ), std::begin( mStepCostMs ) + n_costs );
+		double total_ms = 0.0;
+		for (const float cost : costs)
+		{
+			total_ms += cost;
+			stats.max_step_ms = std::max( stats.max_step_ms, static_cast<double>( cost ) );
+		}
+		stats.mean_step_ms = total_ms / static_cast<double>( n_costs );
+
+		const auto p99 = std::begin( costs ) + static_cast<ptrdiff_t>( 0.99 * static_cast<double>( n_costs - 1 ) );
+		std::nth_element( std::begin( costs ), p99, std::end( costs ) );
+		stats.p99_step_ms = *p99;
+		return stats;
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "Timestep.hpp"
+
+namespace Avokii
+{
+	// What to do when the fixed updates fall behind real time, rather than spiralling into ever longer catch up frames
+	struct FixedStepPolicy
+	{
+		int maxStepsPerFrame = 5;
+		int maxBacklogSteps = 0; // steps over maxStepsPerFrame carried over to later frames, any more are dropped
+	};
+
+	// Decides how many fixed updates each frame runs and the timestep of each
+	//
+	// Real time is accumulated in whole nanoseconds. A step's timestamp is its index times the step length, so the updates see
+	// the same times however the frames happen to fall. Dropped steps don't advance simulated time, under load the simulation
+	// slows down instead. Not thread safe, with pipelined rendering read the stats outside OnRender().
+	class FixedTimestep final
+	{
+	public:
+		using Clock_T = std::chrono::steady_clock;
+
+		struct Frame
+		{
+			uint64_t first_step = 0;
+			int n_steps = 0;
+			double alpha = 0.0; // see PreciseTimestep::alpha
+		};
+
+		struct Stats
+		{
+			uint64_t n_steps = 0;
+			uint64_t n_dropped_steps = 0;
+			uint64_t n_capped_frames = 0; // frames that ran fewer steps than were due
+			// CPU time of the most recent steps, up to HistorySize
+			double mean_step_ms = 0.0;
+			double p99_step_ms = 0.0;
+			double max_step_ms = 0.0;
+		};
+
+		static constexpr size_t HistorySize = 256;
+
+		explicit FixedTimestep( double steps_per_second, const FixedStepPolicy& policy = {} );
+
+		// Adds the real time since the last call and returns the steps due, as limited by the policy
+		[[nodiscard]] Frame Advance( std::chrono::nanoseconds elapsed );
+		// Exactly `n_steps` regardless of real time, for running a step per frame or repeating a recording
+		[[nodiscard]] Frame AdvanceSteps( int n_steps );
+
+		[[nodiscard]] PreciseTimestep GetStep( uint64_t step ) const noexcept;
+		[[nodiscard]] std::chrono::nanoseconds GetStepLength() const noexcept { return mStepLength; }
+		[[nodiscard]] uint64_t GetNextStep() const noexcept { return mNextStep; }
+
+		void RecordStepCost( Clock_T::duration cost ) noexcept;
+		[[nodiscard]] Stats GetStats() const;
+
+	private:
+		const FixedStepPolicy mPolicy;
+		const std::chrono::nanoseconds mStepLength;
+
+		std::chrono::nanoseconds mAccumulated{ 0 };
+		uint64_t mNextStep = 0;
+
+		uint64_t mNumDroppedSteps = 0;
+		uint64_t mNumCappedFrames = 0;
+		std::array<float, HistorySize> mStepCostMs{};
+		uint64_t mNumStepCosts = 0;
+	};
+}
@@ -0,0 +1,188 @@
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#ifdef AVOKII_PLATFORM_WINDOWS
+#include "Avokii/Platform/Windows/WindowsHeader.hpp"
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+
+// Windows 10 1803 and later, older SDKs don't define it
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#	define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+namespace Avokii
+{
+	namespace
+	{
+		using namespace std::chrono_literals;
+
+		// sleeps are requested in small slices so a single long overshoot can't eat the whole frame
+		constexpr auto SleepSlice = 1ms;
+
+		double ToMilliseconds( FramePacer::Clock_T::duration duration ) noexcept
+		{
+			return std::chrono::duration<double, std::milli>( duration ).count();
+		}
+
+		double Percentile( std::vector<float>& values, double fraction )
+		{
+			const auto nth = std::begin( values ) + static_cast<ptrdiff_t>( fraction * static_cast<double>( values.size() - 1 ) );
+			std::nth_element( std::begin( values ), nth, std::end( values ) );
+			return *nth;
+		}
+	}
+
+	FramePacer::FramePacer( double max_fps )
+	{
+#ifdef AVOKII_PLATFORM_WINDOWS
+		mTimerHandle = ::CreateWaitableTimerExW( nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS );
+		if (!mTimerHandle)
+		{
+			// the default 15.6ms timer would leave most of every frame to the spin, raised for the rest of the process
+			static const bool raised_timer_resolution = (::timeBeginPeriod( 1 ) == TIMERR_NOERROR);
+			AV_LOG_INFO( LoggingChannels::Application, "High resolution waitable timers are unavailable (error {}), {}", ::GetLastError(),
+				raised_timer_resolution ? "sleeping with a 1ms system timer" : "sleeping with the default system timer" );
+		}
+#endif
+		SetMaxFps( max_fps );
+	}
+
+	FramePacer::~FramePacer()
+	{
+#ifdef AVOKII_PLATFORM_WINDOWS
+		if (mTimerHandle)
+			::CloseHandle( mTimerHandle );
+#endif
+	}
+
+	void FramePacer::SetMaxFps( double max_fps )
+	{
+		mMaxFps = std::max( max_fps, 0.0 );
+		mPeriod = (mMaxFps > 0.0) ? std::chrono::duration_cast<Clock_T::duration>( std::chrono::duration<double>( 1.0 / mMaxFps ) ) : Clock_T::duration{ 0 };
+		mStarted = false;
+	}
+
+	void FramePacer::WaitForNextFrame()
+	{
+		const auto frame_end = Clock_T::now();
+		auto frame_start = frame_end;
+		double jitter_us = 0.0;
+
+		if (mPeriod.count() > 0)
+		{
+			// the first frame and frames over a period late start a new schedule rather than catching up
+			const bool on_schedule = mStarted && (frame_end - mNextDeadline <= mPeriod);
+			const auto deadline = on_schedule ? mNextDeadline : frame_end;
+
+			WaitUntil( deadline );
+			frame_start = Clock_T::now();
+			jitter_us = std::max( 0.0, ToMilliseconds( frame_start - deadline ) * 1000.0 );
+			mNextDeadline = deadline + mPeriod;
+		}
+
+		if (mStarted)
+		{
+			auto& record = mHistory[mNumFrames % HistorySize];
+			record.frame_ms = static_cast<float>( ToMilliseconds( frame_start - mFrameStart ) );
+			record.wait_ms = static_cast<float>( ToMilliseconds( frame_start - frame_end ) );
+			record.jitter_us = static_cast<float>( jitter_us );
+			++mNumFrames;
+		}
+
+		mFrameStart = frame_start;
+		mStarted = true;
+	}
+
+	void FramePacer::WaitUntil( Clock_T::time_point deadline )
+	{
+		auto now = Clock_T::now();
+
+		// sleep while the deadline is further off than a sleep usually overshoots by
+		while (true)
+		{
+			const double overshoot_stddev = (mNumSleeps > 1) ? std::sqrt( mSleepOvershootM2 / static_cast<double>( mNumSleeps - 1 ) ) : 0.0;
+			const auto margin = std::chrono::nanoseconds( static_cast<int64_t>( mSleepOvershootMean + 2.0 * overshoot_stddev ) );
+			if (deadline - now <= SleepSlice + margin)
+				break;
+
+			const auto sleep_start = now;
+			Sleep( SleepSlice );
+			now = Clock_T::now();
+			RecordSleep( SleepSlice, now - sleep_start );
+		}
+
+		while (Clock_T::now() < deadline)
+			std::this_thread::yield();
+	}
+
+	void FramePacer::Sleep( Clock_T::duration duration )
+	{
+#ifdef AVOKII_PLATFORM_WINDOWS
+		if (mTimerHandle)
+		{
+			// relative due times are negative, in 100ns units
+			LARGE_INTEGER due_time{};
+			due_time.QuadPart = -std::max<LONGLONG>( 1, std::chrono::duration_cast<std::chrono::nanoseconds>( duration ).count() / 100 );
+			if (::SetWaitableTimerEx( mTimerHandle, &due_time, 0, nullptr, nullptr, nullptr, 0 ))
+			{
+				::WaitForSingleObject( mTimerHandle, INFINITE );
+				return;
+			}
+		}
+#endif
+		std::this_thread::sleep_for( duration );
+	}
+
+	void FramePacer::RecordSleep( Clock_T::duration requested, Clock_T::duration actual )
+	{
+		const double overshoot_ns = std::max( 0.0, static_cast<double>( std::chrono::duration_cast<std::chrono::nanoseconds>( actual - requested ).count() ) );
+
+		// windowed so the estimate follows changes in the OS timer resolution
+		constexpr uint64_t MaxSamples = 1000;
+		mNumSleeps = std::min( mNumSleeps + 1, MaxSamples );
+		const double delta = overshoot_ns - mSleepOvershootMean;
+		mSleepOvershootMean += delta / static_cast<double>( mNumSleeps );
+		mSleepOvershootM2 += delta * (overshoot_ns - mSleepOvershootMean);
+		if (mNumSleeps == MaxSamples)
+			mSleepOvershootM2 *= static_cast<double>( MaxSamples - 1 ) / static_cast<double>( MaxSamples );
+	}
+
+	FramePacer::Stats FramePacer::GetStats() const
+	{
+		Stats stats;
+		stats.n_frames = std::min( mNumFrames, HistorySize );
+		if (stats.n_frames == 0)
+			return stats;
+
+		std::vector<float> frame_ms;
+		frame_ms.reserve( stats.n_frames );
+		double total_frame_ms = 0.0;
+		double total_wait_ms = 0.0;
+		double total_jitter_us = 0.0;
+		for (size_t i = 0; i < stats.n_frames; ++i)
+		{
+			const auto& record = mHistory[i];
+			frame_ms.push_back( record.frame_ms );
+			total_frame_ms += record.frame_ms;
+			total_wait_ms += record.wait_ms;
+			total_jitter_us += record.jitter_us;
+			stats.max_frame_ms = std::max( stats.max_frame_ms, static_cast<double>( record.frame_ms ) );
+			stats.max_jitter_us = std::max( stats.max_jitter_us, static_cast<double>( record.jitter_us ) );
+		}
+
+		const auto n = static_cast<double>( stats.n_frames );
+		stats.mean_frame_ms = total_frame_ms / n;
+		stats.mean_jitter_us = total_jitter_us / n;
+		stats.cpu_utilisation = (total_frame_ms > 0.0) ? std::clamp( 1.0 - total_wait_ms / total_frame_ms, 0.0, 1.0 ) : 0.0;
+		stats.p50_frame_ms = Percentile( frame_ms, 0.50 );
+		stats.p95_frame_ms = Percentile( frame_ms, 0.95 );
+		stats.p99_frame_ms = Percentile( frame_ms, 0.99 );
+		return stats;
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+
+namespace Avokii
+{
+	// Caps the frame rate by waiting out the rest of each frame
+	//
+	// Waits sleep while the deadline is further off than a sleep is likely to overshoot, then spin for the rest.
+	// The overshoot is measured as it goes, so the spin stays short on a fine grained OS timer and grows on a coarse one.
+	// On Windows sleeps use a high resolution waitable timer, or raise the system timer resolution to 1ms where that's unavailable.
+	// Deadlines advance by whole periods from the previous deadline rather than from when the wait finished,
+	// so timing doesn't drift. After a stall longer than a frame the schedule restarts rather than rushing to catch up.
+	class FramePacer final
+	{
+	public:
+		using Clock_T = std::chrono::steady_clock;
+
+		struct Stats
+		{
+			size_t n_frames = 0; // the stats cover the most recent frames, up to HistorySize
+			double mean_frame_ms = 0.0;
+			double p50_frame_ms = 0.0;
+			double p95_frame_ms = 0.0;
+			double p99_frame_ms = 0.0;
+			double max_frame_ms = 0.0;
+			double mean_jitter_us = 0.0; // how late the waits finished
+			double max_jitter_us = 0.0;
+			double cpu_utilisation = 0.0; // fraction of the time spent on frames rather than waiting in the pacer
+		};
+
+		static constexpr size_t HistorySize = 256;
+
+		// 0 fps for no cap
+		explicit FramePacer( double max_fps = 0.0 );
+		~FramePacer();
+
+		FramePacer( const FramePacer& ) = delete;
+		FramePacer& operator=( const FramePacer& ) = delete;
+
+		void SetMaxFps( double max_fps );
+		[[nodiscard]] double GetMaxFps() const noexcept { return mMaxFps; }
+
+		// Called at the end of each frame, returns once the next one is due
+		void WaitForNextFrame();
+		// Hybrid sleep then spin until `deadline`
+		void WaitUntil( Clock_T::time_point deadline );
+
+		[[nodiscard]] Stats GetStats() const;
+
+	private:
+		void Sleep( Clock_T::duration duration );
+		void RecordSleep( Clock_T::duration requested, Clock_T::duration actual );
+
+	private:
+		void* mTimerHandle = nullptr; // high resolution waitable timer, Windows only
+		double mMaxFps = 0.0;
+		Clock_T::duration mPeriod{ 0 };
+		Clock_T::time_point mNextDeadline;
+		Clock_T::time_point mFrameStart;
+		bool mStarted = false;
+
+		// how far sleeps have overshot, as a running mean and variance (Welford) of the overshoot in nanoseconds
+		double mSleepOvershootMean = 1.0e6;
+		double mSleepOvershootM2 = 0.0;
+		uint64_t mNumSleeps = 0;
+
+		struct FrameRecord
+		{
+			float frame_ms;
+			float wait_ms; // sleeping and spinning
+			float jitter_us;
+		};
+		std::array<FrameRecord, HistorySize> mHistory{};
+		size_t mNumFrames = 0;
+	};
+}
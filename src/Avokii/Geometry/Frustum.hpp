@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+
+#include "Avokii/Types/Mat4.hpp"
+#include "Avokii/Types/Vec3.hpp"
+#include "Avokii/Types/Vec4.hpp"
+
+namespace Avokii
+{
+	// Six inward facing planes (normal.xyz, distance), points inside satisfy dot( normal, p ) + distance >= 0
+	class Frustum
+	{
+	public:
+		enum Planes { Left, Right, Bottom, Top, Near, Far, NPlanes };
+
+	public:
+		constexpr Frustum() = default;
+
+		// Extracts the planes of an OpenGL style (-w..w clip space) projection, in the space `matrix` transforms from
+		static Frustum FromMatrix( const Mat4f& matrix ) noexcept
+		{
+			// glm is column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+			const auto row = [&matrix]( const int i ) { return Vec4f{ matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i] }; };
+			const Vec4f x = row( 0 ), y = row( 1 ), z = row( 2 ), w = row( 3 );
+
+			Frustum frustum;
+			frustum.mPlanes[Left] = w + x;
+			frustum.mPlanes[Right] = w - x;
+			frustum.mPlanes[Bottom] = w + y;
+			frustum.mPlanes[Top] = w - y;
+			frustum.mPlanes[Near] = w + z;
+			frustum.mPlanes[Far] = w - z;
+			return frustum;
+		}
+
+		// Conservative, boxes straddling a corner outside the frustum can still pass
+		[[nodiscard]] bool IntersectsBox( const Vec3f& min, const Vec3f& max ) const noexcept
+		{
+			for (const auto& plane : mPlanes)
+			{
+				// the box corner furthest along the plane normal
+				const float d = plane.x * (plane.x >= 0.f ? max.x : min.x)
+					+ plane.y * (plane.y >= 0.f ? max.y : min.y)
+					+ plane.z * (plane.z >= 0.f ? max.z : min.z)
+					+ plane.w;
+				if (d < 0.f)
+					return false;
+			}
+			return true;
+		}
+
+		[[nodiscard]] const Vec4f& GetPlane( Planes plane ) const noexcept { return mPlanes[plane]; }
+
+	private:
+		std::array<Vec4f, NPlanes> mPlanes{};
+	};
+}
@@ -12,8 +12,8 @@ namespace Avokii
 
 		constexpr Point2D() : x( 0 ), y( 0 ) {}
 		constexpr Point2D( T x, T y ) : x( x ), y( y ) {}
-		constexpr Point2D( const Point2D& other ) : x( other.x ), y( other.y ) {}
-		constexpr Point2D& operator= ( const Point2D& rhs ) { this->x = rhs.x; this->y = rhs.y; return *this; }
+		constexpr Point2D( const Point2D& other ) = default;
+		constexpr Point2D& operator= ( const Point2D& rhs ) = default;
 
 		static const Point2D empty;
 
@@ -9,5 +9,8 @@ namespace Avokii::Graphics
 		uint32_t max_texture_width = 0, max_texture_height = 0;
 		uint32_t max_cubemap_width = 0, max_cubemap_height = 0;
 		uint32_t max_texture_coordinates = 0;
+		bool persistent_mapped_buffers = false; // BufferUsage::Stream can be backed by a persistently mapped buffer
+		bool base_instance = false; // DrawInstanced() supports a non-zero base instance
+		uint32_t max_texture_array_layers = 0; // 0 when TextureArray layers can't be copied into on the device
 	};
 }
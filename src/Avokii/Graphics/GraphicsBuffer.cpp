@@ -74,8 +74,9 @@ namespace Avokii::Graphics
 		}
 	}
 
-	BufferLayout::BufferLayout( const std::initializer_list<BufferElement>& elements )
+	BufferLayout::BufferLayout( const std::initializer_list<BufferElement>& elements, uint32_t instance_divisor )
 		: mElements{ elements }
+		, mInstanceDivisor{ instance_divisor }
 	{
 		CalculateOffsetsAndStride();
 	}
@@ -51,9 +51,11 @@ namespace Avokii::Graphics
 	{
 	public:
 		BufferLayout() {}
-		BufferLayout( const std::initializer_list<BufferElement>& elements );
+		BufferLayout( const std::initializer_list<BufferElement>& elements, uint32_t instance_divisor = 0 );
 
 		uint32_t GetStride() const { return mStride; }
+		// 0: advance per vertex, N: advance once every N instances
+		uint32_t GetInstanceDivisor() const { return mInstanceDivisor; }
 		const std::vector<BufferElement>& GetElements() const { return mElements; }
 
 		std::vector<BufferElement>::iterator begin() { return mElements.begin(); }
@@ -69,14 +71,29 @@ namespace Avokii::Graphics
 	private:
 		std::vector<BufferElement> mElements;
 		uint32_t mStride = 0;
+		uint32_t mInstanceDivisor = 0;
 	};
 
 
+	enum class BufferUsage
+	{
+		Static,		// written once on creation
+		Dynamic,	// occasionally replaced through SetData()
+		Stream,		// rewritten for every draw through BeginWrite()/EndWrite()
+	};
+
 	struct VertexBufferDefinition
 	{
 		std::optional<std::string> name;
 		BufferLayout layout;
 		std::vector<unsigned char> data;
+		BufferUsage usage = BufferUsage::Dynamic;
+
+		// BufferUsage::Stream only.
+		// The buffer is split into `stream_segment_count` segments of `stream_segment_size` bytes which are written round-robin,
+		// so the GPU can still be reading the previous segments while the next one is being filled.
+		uint32_t stream_segment_size = 0;
+		uint32_t stream_segment_count = 3;
 
 		template<typename T>
 		void SetDataFromVector( const std::vector<T>& in_ )
@@ -96,6 +113,14 @@ namespace Avokii::Graphics
 		virtual void Unbind() const = 0;
 
 		virtual void SetData( const void* data, uint32_t size ) = 0;
+		// Replaces `size` bytes starting at `offset`, for patching part of a Static or Dynamic buffer
+		virtual void SetSubData( uint32_t offset, const void* data, uint32_t size ) = 0;
+
+		// Returns a pointer to the next writable segment, valid until EndWrite().
+		// May block if the GPU is still reading from that segment.
+		[[nodiscard]] virtual void* BeginWrite() = 0;
+		// Finishes a write started with BeginWrite(), returns the byte offset of the written data within the buffer.
+		virtual uint32_t EndWrite( uint32_t size ) = 0;
 
 		virtual const BufferLayout& GetLayout() const = 0;
 		virtual void SetLayout( const BufferLayout& layout ) = 0;
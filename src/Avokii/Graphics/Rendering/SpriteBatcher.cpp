@@ -1,6 +1,8 @@
 #include "SpriteBatcher.hpp"
 
+#include <bit>
 #include <cinttypes>
+#include <cstring>
 #include <numeric>
 #include <stack>
 
@@ -16,36 +18,62 @@
 
 #include "Avokii/Containers/ContainerOperations.hpp"
 
+#if defined( _M_X64 ) || defined( __SSE2__ )
+#define AV_SPRITEBATCHER_SSE2
+#include <emmintrin.h>
+#endif
+
 using namespace Avokii::ContainerOps;
 
 namespace Avokii::Graphics
 {
-	namespace
-	{
 #pragma pack(push, 1)
-		struct QuadVertex
-		{
-			Vec3f pos;
-			Vec4f colour;
-			Vec2f texcoord;
-			uint32_t texture_index;
-
-			QuadVertex()
-				: pos{ 0.f, 0.f, 0.f }
-				, colour{ 1.f, 1.f, 1.f, 1.f }
-				, texcoord{ 0.f, 0.f }
-				, texture_index{ 0 }
-			{}
-
-			QuadVertex( Vec3f pos, Vec4f colour, Vec2f texcoord, uint32_t texture_index )
-				: pos{ pos }
-				, colour{ colour }
-				, texcoord{ texcoord }
-				, texture_index{ texture_index }
-			{}
-		};
+	struct SpriteBatcher::QuadVertex
+	{
+		Vec3f pos;
+		Vec4f colour;
+		Vec2f texcoord;
+		uint32_t texture_index;
+
+		QuadVertex()
+			: pos{ 0.f, 0.f, 0.f }
+			, colour{ 1.f, 1.f, 1.f, 1.f }
+			, texcoord{ 0.f, 0.f }
+			, texture_index{ 0 }
+		{}
+
+		QuadVertex( Vec3f pos, Vec4f colour, Vec2f texcoord, uint32_t texture_index )
+			: pos{ pos }
+			, colour{ colour }
+			, texcoord{ texcoord }
+			, texture_index{ texture_index }
+		{}
+	};
+
+	struct SpriteBatcher::SpriteInstance
+	{
+		Vec3f pos;				// world position of the pivot
+		Vec4f rect;				// min.xy, max.xy of the quad relative to the pivot
+		Vec4f uvs;				// left, top, right, bottom
+		uint32_t colour;		// packed ColourRGBA
+		uint32_t texture_index;
+	};
 #pragma pack(pop)
 
+	// kept in both the vertex and the packed instance representation
+	struct SpriteBatcher::MultiplyColour
+	{
+		Vec4f floats;
+		uint32_t packed; // byte order matches unpackUnorm4x8 in the instanced shader
+
+		static MultiplyColour FromPacked( const uint32_t packed )
+		{
+			return MultiplyColour{ ColourRGBA( packed & 0xFF, (packed >> 8u) & 0xFF, (packed >> 16u) & 0xFF, (packed >> 24u) & 0xFF ).AsFloatsRGBA(), packed };
+		}
+	};
+
+	namespace
+	{
 		static const BufferLayout VertexLayout
 		{
 			BufferElement{ ShaderDataType::Float3, "a_Position" },
@@ -54,7 +82,304 @@ namespace Avokii::Graphics
 			BufferElement{ ShaderDataType::uInt, "a_TextureIndex" },
 		};
 
+		// two triangles over [0, 1], corners in the same order as the quad indices
+		static const Vec2f UnitQuadCorners[] =
+		{
+			{ 0.f, 0.f }, { 1.f, 0.f }, { 0.f, 1.f },
+			{ 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f },
+		};
+		constexpr uint32_t UnitQuadVertexCount = static_cast<uint32_t>(std::size( UnitQuadCorners ));
+
+		static const BufferLayout UnitQuadLayout
+		{
+			BufferElement{ ShaderDataType::Float2, "a_Corner" },
+		};
+
+		static const BufferLayout InstanceLayout(
+			{
+				BufferElement{ ShaderDataType::Float3, "a_Position" },
+				BufferElement{ ShaderDataType::Float4, "a_Rect" },
+				BufferElement{ ShaderDataType::Float4, "a_Texcoords" },
+				BufferElement{ ShaderDataType::uInt, "a_Colour" },
+				BufferElement{ ShaderDataType::uInt, "a_TextureIndex" },
+			},
+			1 ); // advance once per instance
+
+		// the embedded shaders are tied to the layouts above so live next to them rather than in the assets
+		// the #version line and options are prepended by MakeShaderSource()
+		constexpr uint32_t EmbeddedShaderMaxTextureSlots = 16;
+
+		std::string MakeShaderSource( std::string_view body, const bool texture_array )
+		{
+			std::string source = "#version 410 core\n";
+			if (texture_array)
+				source += "#define AV_TEXTURE_ARRAY\n";
+			source += body;
+			return source;
+		}
+
+		// only used with TextureBinding::TextureArray, otherwise quads use the shader from the assets
+		constexpr std::string_view QuadVertexShaderSrc = R"(
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec4 a_Colour;
+layout(location = 2) in vec2 a_Texcoord;
+layout(location = 3) in uint a_TextureIndex;
+
+uniform mat4 u_ViewProjection;
+uniform mat4 u_Model;
+
+out vec4 v_Colour;
+out vec2 v_Texcoord;
+flat out uint v_TextureIndex;
+
+void main()
+{
+	v_Colour = a_Colour;
+	v_Texcoord = a_Texcoord;
+	v_TextureIndex = a_TextureIndex;
+	gl_Position = u_ViewProjection * u_Model * vec4( a_Position, 1.0 );
+}
+)";
+
+		constexpr std::string_view InstancedVertexShaderSrc = R"(
+layout(location = 0) in vec2 a_Corner;
+layout(location = 1) in vec3 a_Position;
+layout(location = 2) in vec4 a_Rect;
+layout(location = 3) in vec4 a_Texcoords;
+layout(location = 4) in uint a_Colour;
+layout(location = 5) in uint a_TextureIndex;
+
+uniform mat4 u_ViewProjection;
+uniform mat4 u_Model;
+
+out vec4 v_Colour;
+out vec2 v_Texcoord;
+flat out uint v_TextureIndex;
+
+void main()
+{
+	vec2 offset = mix( a_Rect.xy, a_Rect.zw, a_Corner );
+	v_Colour = unpackUnorm4x8( a_Colour );
+	v_Texcoord = mix( a_Texcoords.xy, a_Texcoords.zw, a_Corner );
+	v_TextureIndex = a_TextureIndex;
+	gl_Position = u_ViewProjection * u_Model * vec4( a_Position + vec3( offset.x, 0.0, offset.y ), 1.0 );
+}
+)";
+
+		constexpr std::string_view SpriteFragmentShaderSrc = R"(
+in vec4 v_Colour;
+in vec2 v_Texcoord;
+flat in uint v_TextureIndex;
+
+uniform sampler2D u_Textures[16];
+#ifdef AV_TEXTURE_ARRAY
+uniform sampler2DArray u_TextureArray;
+#endif
+
+layout(location = 0) out vec4 o_Colour;
+
+void main()
+{
+#ifdef AV_TEXTURE_ARRAY
+	if ((v_TextureIndex & 0x80000000u) != 0u)
+	{
+		o_Colour = texture( u_TextureArray, vec3( v_Texcoord, float( v_TextureIndex & 0x7FFFFFFFu ) ) ) * v_Colour;
+		return;
+	}
+#endif
+	o_Colour = texture( u_Textures[v_TextureIndex], v_Texcoord ) * v_Colour;
+}
+)";
+
 		constexpr uint32_t DefaultTextureIndex = 0; // index that the plain white texture should be loaded in
+
+		///
+		/// Texture array binding
+		/// 
+
+		// set in a texture index when it addresses a texture array layer rather than a slot
+		constexpr uint32_t TextureArrayLayerFlag = 0x80000000u;
+
+		// every layer is allocated up front, so keep them modest: 16 layers of 1024x1024 RGBA8 is 64MiB
+		constexpr uint32_t TextureArrayLayerSize = 1024;
+		constexpr uint32_t TextureArrayMaxLayers = 16;
+
+		///
+		/// Deferred submission
+		/// 
+
+		// 64-bit sort key, most significant first: | layer:8 | depth:16 | shader:8 | texture:32 |
+		// shader bits are reserved, every sprite currently goes through the default shader
+		constexpr uint32_t SortKeyLayerShift = 56;
+		constexpr uint32_t SortKeyDepthShift = 40;
+
+		// maps a float to an unsigned integer with the same ordering
+		inline uint32_t ToSortableBits( const float value ) noexcept
+		{
+			const uint32_t bits = std::bit_cast<uint32_t>(value);
+			return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+		}
+
+		struct SortEntry
+		{
+			uint64_t key;
+			uint32_t command_idx;
+		};
+
+		// Stable LSD radix sort on SortEntry::key, skipping byte positions every key shares (usually most of them)
+		void RadixSortByKey( std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch )
+		{
+			const size_t n = entries.size();
+			if (n < 2)
+				return;
+
+			std::array<std::array<uint32_t, 256>, sizeof( uint64_t )> histograms{};
+			for (const auto& entry : entries)
+			{
+				for (size_t byte = 0; byte < sizeof( uint64_t ); ++byte)
+					++histograms[byte][(entry.key >> (byte * 8)) & 0xFF];
+			}
+
+			scratch.resize( n );
+			std::vector<SortEntry>* src = &entries;
+			std::vector<SortEntry>* dst = &scratch;
+			for (size_t byte = 0; byte < sizeof( uint64_t ); ++byte)
+			{
+				auto& histogram = histograms[byte];
+				const auto shift = byte * 8;
+				if (histogram[(src->front().key >> shift) & 0xFF] == n)
+					continue; // all keys share this byte
+
+				uint32_t offset = 0;
+				for (auto& count : histogram)
+					offset += std::exchange( count, offset );
+
+				for (const auto& entry : *src)
+					(*dst)[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+
+				std::swap( src, dst );
+			}
+
+			if (src != &entries)
+				entries.swap( scratch );
+		}
+
+		///
+		/// Culling
+		/// 
+
+		// tests the same quad ExpandStandingSprite() writes, flat in the x/z plane at location.y
+		inline bool IsStandingSpriteVisible( const Frustum& frustum, const SpriteSheetEntry& img, const Vec3f& location ) noexcept
+		{
+			const Vec3f min{ location.x - img.pivot.x, location.y, location.z - img.pivot.y };
+			const Vec3f max{ min.x + img.size.width, location.y, min.z + img.size.height };
+			return frustum.IntersectsBox( min, max );
+		}
+	}
+
+	///
+	/// Bulk expansion kernels
+	/// 
+	namespace
+	{
+		// QuadVertex and SpriteInstance byte layouts the kernels write, checked against the structs in ExpandStandingSprites()
+		constexpr size_t QuadVertexStride = 40; // pos:12 | colour:16 | texcoord:8 | texture_index:4
+		constexpr size_t SpriteInstanceStride = 52; // pos:12 | rect:16 | uvs:16 | colour:4 | texture_index:4
+
+#ifdef AV_SPRITEBATCHER_SSE2
+		// (left, top, right, bottom) * uv_scale
+		inline __m128 LoadScaledUVs( const Rect<float>& uvs, const __m128 uv_scale ) noexcept
+		{
+			const __m128 xywh = _mm_setr_ps( uvs.x, uvs.y, uvs.w, uvs.h );
+			return _mm_mul_ps( _mm_add_ps( xywh, _mm_movelh_ps( _mm_setzero_ps(), xywh ) ), uv_scale );
+		}
+
+		// (a.x, a.y) into the low lanes, the high lanes are zero
+		template<typename T>
+		inline __m128 LoadPair( const T& pair ) noexcept
+		{
+			static_assert(sizeof( T ) == sizeof( float ) * 2);
+			return _mm_castpd_ps( _mm_load_sd( reinterpret_cast<const double*>(&pair) ) );
+		}
+
+		// Each vertex is written as two 16 byte stores and one 8 byte store:
+		// (x, y, z, r) (g, b, a, u) (v, texture_index)
+		void ExpandQuadsSSE2( std::byte* dst, const SpriteSheetEntry* entries, const SpriteBatcher::StandingSprite* sprites, const size_t count, const uint32_t texture_id, const Vec2f uv_scale ) noexcept
+		{
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 scale = _mm_setr_ps( uv_scale.x, uv_scale.y, uv_scale.x, uv_scale.y );
+			const __m128 inv_255 = _mm_set1_ps( 1.f / 255.f );
+			const __m128 texture = _mm_castsi128_ps( _mm_set1_epi32( static_cast<int>(texture_id) ) );
+			const __m128i zero_i = _mm_setzero_si128();
+
+			for (size_t i = 0; i < count; ++i, dst += QuadVertexStride * 4)
+			{
+				const auto& sprite = sprites[i];
+				const auto& img = entries[sprite.sprite_idx];
+
+				// corner positions, lane 3 is unused
+				const __m128 location = _mm_loadu_ps( &sprite.location.x ); // reads sprite_idx into lane 3
+				const __m128 p_min = _mm_sub_ps( location, _mm_unpacklo_ps( LoadPair( img.pivot ), zero ) ); // (min.x, y, min.z)
+				const __m128 p_max = _mm_add_ps( p_min, _mm_unpacklo_ps( LoadPair( img.size ), zero ) ); // (max.x, y, max.z)
+				const __m128 p_top_right = _mm_move_ss( p_min, p_max );
+				const __m128 p_bottom_left = _mm_move_ss( p_max, p_min );
+
+				// colour bytes to floats
+				__m128i colour_i = _mm_cvtsi32_si128( static_cast<int>(std::bit_cast<uint32_t>(sprite.colour)) );
+				colour_i = _mm_unpacklo_epi16( _mm_unpacklo_epi8( colour_i, zero_i ), zero_i );
+				const __m128 colour = _mm_mul_ps( _mm_cvtepi32_ps( colour_i ), inv_255 );
+
+				const __m128 uvs = LoadScaledUVs( img.uvs, scale ); // (u0, v0, u1, v1)
+				const __m128 v_texture = _mm_unpacklo_ps( _mm_shuffle_ps( uvs, uvs, _MM_SHUFFLE( 3, 3, 3, 1 ) ), texture ); // (v0, tex, v1, tex)
+
+				// (g, b, a, u0) and (g, b, a, u1)
+				const __m128 gba_u0 = _mm_shuffle_ps( colour, _mm_shuffle_ps( colour, uvs, _MM_SHUFFLE( 0, 0, 3, 3 ) ), _MM_SHUFFLE( 2, 0, 2, 1 ) );
+				const __m128 gba_u1 = _mm_shuffle_ps( colour, _mm_shuffle_ps( colour, uvs, _MM_SHUFFLE( 2, 2, 3, 3 ) ), _MM_SHUFFLE( 2, 0, 2, 1 ) );
+
+				const auto write_vertex = [&]( std::byte* vertex, const __m128 pos, const __m128 gba_u, const bool bottom )
+				{
+					// (x, y, z, r)
+					const __m128 xyzr = _mm_shuffle_ps( pos, _mm_shuffle_ps( pos, colour, _MM_SHUFFLE( 0, 0, 2, 2 ) ), _MM_SHUFFLE( 2, 0, 1, 0 ) );
+					_mm_storeu_ps( reinterpret_cast<float*>(vertex), xyzr );
+					_mm_storeu_ps( reinterpret_cast<float*>(vertex + 16), gba_u );
+					if (bottom)
+						_mm_storeh_pi( reinterpret_cast<__m64*>(vertex + 32), v_texture );
+					else
+						_mm_storel_pi( reinterpret_cast<__m64*>(vertex + 32), v_texture );
+				};
+
+				write_vertex( dst, p_min, gba_u0, false ); // top left
+				write_vertex( dst + QuadVertexStride, p_top_right, gba_u1, false ); // top right
+				write_vertex( dst + QuadVertexStride * 2, p_bottom_left, gba_u0, true ); // bottom left
+				write_vertex( dst + QuadVertexStride * 3, p_max, gba_u1, true ); // bottom right
+			}
+		}
+
+		// Each instance is written as three 16 byte stores and the texture index:
+		// (x, y, z, rect.x) (rect.y, rect.z, rect.w, u0) (v0, u1, v1, colour) (texture_index)
+		void ExpandInstancesSSE2( std::byte* dst, const SpriteSheetEntry* entries, const SpriteBatcher::StandingSprite* sprites, const size_t count, const uint32_t texture_id, const Vec2f uv_scale ) noexcept
+		{
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 scale = _mm_setr_ps( uv_scale.x, uv_scale.y, uv_scale.x, uv_scale.y );
+
+			for (size_t i = 0; i < count; ++i, dst += SpriteInstanceStride)
+			{
+				const auto& sprite = sprites[i];
+				const auto& img = entries[sprite.sprite_idx];
+
+				const __m128 location = _mm_loadu_ps( &sprite.location.x ); // reads sprite_idx into lane 3
+				const __m128 pivot = LoadPair( img.pivot );
+				const __m128 rect = _mm_add_ps( _mm_sub_ps( zero, _mm_movelh_ps( pivot, pivot ) ), _mm_movelh_ps( zero, LoadPair( img.size ) ) ); // (min.x, min.y, max.x, max.y)
+				const __m128 uvs = LoadScaledUVs( img.uvs, scale );
+				const __m128 colour = _mm_castsi128_ps( _mm_set1_epi32( static_cast<int>(std::bit_cast<uint32_t>(sprite.colour)) ) );
+
+				_mm_storeu_ps( reinterpret_cast<float*>(dst), _mm_shuffle_ps( location, _mm_shuffle_ps( location, rect, _MM_SHUFFLE( 0, 0, 2, 2 ) ), _MM_SHUFFLE( 2, 0, 1, 0 ) ) );
+				_mm_storeu_ps( reinterpret_cast<float*>(dst + 16), _mm_shuffle_ps( rect, _mm_shuffle_ps( rect, uvs, _MM_SHUFFLE( 0, 0, 3, 3 ) ), _MM_SHUFFLE( 2, 0, 2, 1 ) ) );
+				_mm_storeu_ps( reinterpret_cast<float*>(dst + 32), _mm_shuffle_ps( uvs, _mm_shuffle_ps( uvs, colour, _MM_SHUFFLE( 0, 0, 3, 3 ) ), _MM_SHUFFLE( 2, 0, 2, 1 ) ) );
+				std::memcpy( dst + 48, &texture_id, sizeof( texture_id ) );
+			}
+		}
+#endif
 	}
 
 	///
@@ -66,53 +391,176 @@ namespace Avokii::Graphics
 		const uint32_t NMaxVertices;
 		const uint32_t NMaxIndices;
 		const uint32_t NMaxTextureSlots;
+		const Mode mode;
+		const TextureBinding texture_binding;
 
 		API::VideoAPI& rVideo;
 
 		// multiply colour
-		std::stack<Vec4f> multiply_colour;
+		std::stack<MultiplyColour> multiply_colour;
 
 		// device objects
 		std::shared_ptr<Graphics::VertexArray> va;
-		std::shared_ptr<Graphics::VertexBuffer> vb;
+		std::shared_ptr<Graphics::VertexBuffer> vb; // streamed QuadVertex or SpriteInstance data depending on mode
 		std::shared_ptr<Graphics::Shader> default_shader;
 		std::shared_ptr<Graphics::Texture> white_texture;
 		std::vector<std::shared_ptr<const Graphics::Texture>> texture_slots;
+		std::shared_ptr<Graphics::TextureArray> texture_array; // TextureBinding::TextureArray only, bound after the slots
+
+		// texture array layers, a layer is only reused once its texture has been destroyed
+		struct TextureLayer
+		{
+			std::weak_ptr<const Graphics::Texture> texture;
+			const Graphics::Texture* pKey = nullptr; // in texture_layer_lookup
+			Vec2f uv_scale{ 1.f, 1.f }; // texture size relative to the layer, textures sit in the top left corner
+			uint32_t content_version = 0; // Texture::GetContentVersion() when copied
+			bool stale = false; // the texture was reloaded since, reclaimed with the expired layers
+		};
+		std::vector<TextureLayer> texture_layers;
+		std::unordered_map<const Graphics::Texture*, uint32_t> texture_layer_lookup;
+		std::vector<uint32_t> free_texture_layers;
+
+		// result of the previous FindOrAddTexture(), consecutive sprites usually come from the same sheet
+		struct
+		{
+			std::shared_ptr<const Graphics::Texture> texture;
+			TextureSlotId id = 0;
+			Vec2f uv_scale{ 1.f, 1.f };
+		} last_texture;
 
 		// data pointers/counters
-		std::vector<QuadVertex> vertex_data;
-		uint32_t quad_index_count = 0;
+		std::byte* write_base = nullptr; // start of the mapped write region, null when no region is open
+		uint32_t batch_quad_count = 0;
 		uint32_t texture_slot_index = 0;
 		std::shared_ptr<Graphics::Shader> active_shader;
 
 		// current scene data
 		const Camera* pSceneCamera = nullptr;
 		Mat4f scene_transform{ 1.f };
+		Mat4f scene_view_transform{ 1.f };
+		Submission submission = Submission::Immediate;
+		uint8_t layer = 0;
+		Frustum scene_frustum; // in the space sprites are submitted in, before the world transform
+		bool culling = true;
 
-		Data( API::VideoAPI& r_video, const uint32_t max_quads, const uint32_t max_texture_slots )
-			: rVideo{ r_video }
-			, NMaxQuads{ max_quads }
+		bool IsVisible( const SpriteSheetEntry& img, const Vec3f& location ) const noexcept
+		{
+			return !culling || IsStandingSpriteVisible( scene_frustum, img, location );
+		}
+
+		// deferred submission, everything here is cleared every scene but keeps its capacity
+		struct DeferredCommand
+		{
+			Vec3f location;
+			SpriteSheetEntry img; // copied, the caller's handle may be the last reference to its sheet and sheets can be reloaded
+			uint32_t texture_idx; // into frame_textures
+			uint32_t colour; // packed
+		};
+		std::vector<DeferredCommand> commands;
+		std::vector<SortEntry> sort_entries;
+		std::vector<SortEntry> sort_scratch;
+		std::vector<std::shared_ptr<const Graphics::Texture>> frame_textures;
+		std::unordered_map<const Graphics::Texture*, uint32_t> frame_texture_lookup;
+		// submission order batching estimate for Statistics::nUnsortedDrawCalls
+		std::vector<uint32_t> unsorted_slots;
+		uint32_t unsorted_batch_quads = 0;
+
+		// parallel recording
+		std::vector<std::unique_ptr<Writer>> writers;
+		uint32_t n_active_writers = 0;
+
+		void ClearDeferred()
+		{
+			commands.clear();
+			sort_entries.clear();
+			frame_textures.clear();
+			frame_texture_lookup.clear();
+			unsorted_slots.clear();
+			unsorted_batch_quads = 0;
+		}
+
+		uint32_t GetFrameTextureIndex( const std::shared_ptr<const Graphics::Texture>& texture )
+		{
+			const auto [it, inserted] = frame_texture_lookup.try_emplace( texture.get(), static_cast<uint32_t>(frame_textures.size()) );
+			if (inserted)
+				frame_textures.push_back( texture );
+			return it->second;
+		}
+
+		Data( API::VideoAPI& r_video, const Mode mode_, const TextureBinding texture_binding_, const uint32_t max_quads, const uint32_t max_texture_slots, const uint32_t max_texture_array_layers )
+			: NMaxQuads{ max_quads }
 			, NMaxVertices{ NMaxQuads * 4 }
 			, NMaxIndices{ NMaxQuads * 6 }
 			, NMaxTextureSlots{ std::min( (uint32_t)32, max_texture_slots ) }
+			, mode{ mode_ }
+			, texture_binding{ texture_binding_ }
+			, rVideo{ r_video }
 		{
 			if (NMaxQuads < 1)
 				throw std::runtime_error( "Device reported it can't render quads?" );
 			if (NMaxTextureSlots <= 1)
 				throw std::runtime_error( "Device reported not enough texture slots" );
 
-			std::shared_ptr<Graphics::IndexBuffer> ib;
+			switch (mode)
+			{
+			case Mode::Quads: InitQuads(); break;
+			case Mode::Instanced: InitInstanced(); break;
+			}
+
+			if (texture_binding == TextureBinding::TextureArray)
+				InitTextureArray( max_texture_array_layers );
 
-			// vertex buffer
+			// texture slots
+			texture_slots.resize( NMaxTextureSlots );
+			Fill( texture_slots, nullptr );
+
+			// white texture
+			{
+				white_texture = rVideo.CreateTexture( TextureDefinition
+					{
+						.size = { 1, 1 },
+					} );
+				uint32_t white_texture_data = 0xffffffff;
+				white_texture->SetData( &white_texture_data, sizeof( decltype(white_texture_data) ) );
+
+				// first slot is always the white texture
+				texture_slots[0] = white_texture;
+			}
+
+			// default shader samplers
+			{
+				std::vector<int> initial_samplers{ std::vector<int>( NMaxTextureSlots ) };
+				std::iota( std::begin( initial_samplers ), std::end( initial_samplers ), 0 ); // fill initial samplers with 0, 1, 2, 3, etc
+
+				default_shader->Bind();
+				default_shader->SetIntArray( "u_Textures", initial_samplers.data(), NMaxTextureSlots );
+				if (texture_array)
+					default_shader->SetInt( "u_TextureArray", static_cast<int>(NMaxTextureSlots) );
+			}
+
+			// default states
+			{
+				multiply_colour.emplace( MultiplyColour{ Vec4f{ 1.f, 1.f, 1.f, 1.f }, 0xffffffff } );
+			}
+		}
+
+		~Data() = default;
+
+		void InitQuads()
+		{
+			// vertex buffer, streamed into directly while sprites are submitted
 			vb = rVideo.CreateVertexBuffer(
 				VertexBufferDefinition
 				{
 					.name = "SpriteBatcher VB",
 					.layout = VertexLayout,
-					.data = std::vector<unsigned char>( sizeof(QuadVertex) * NMaxVertices ),
+					.usage = BufferUsage::Stream,
+					.stream_segment_size = static_cast<uint32_t>(sizeof( QuadVertex ) * NMaxVertices),
+					.stream_segment_count = 3,
 				} );
 
 			// index buffer
+			std::shared_ptr<Graphics::IndexBuffer> ib;
 			{
 				IndexBufferDefinition ib_props
 				{
@@ -137,42 +585,142 @@ namespace Avokii::Graphics
 					.index_buffer = std::move( ib ),
 				} );
 
-			// texture slots
-			texture_slots.resize( NMaxTextureSlots );
-			Fill( texture_slots, nullptr );
-
-			// white texture
+			if (texture_binding == TextureBinding::TextureArray)
 			{
-				white_texture = rVideo.CreateTexture( TextureDefinition
-					{
-						.size = { 1, 1 },
-					} );
-				uint32_t white_texture_data = 0xffffffff;
-				white_texture->SetData( &white_texture_data, sizeof( decltype(white_texture_data) ) );
+				if (NMaxTextureSlots > EmbeddedShaderMaxTextureSlots)
+					throw std::runtime_error( "Sprite shader doesn't support that many texture slots" );
 
-				// first slot is always the white texture
-				texture_slots[0] = white_texture;
+				default_shader = rVideo.CreateShader( "SpriteBatcher texture array", MakeShaderSource( QuadVertexShaderSrc, true ), MakeShaderSource( SpriteFragmentShaderSrc, true ) );
 			}
+			else
+				default_shader = rVideo.CreateShader( Filepath{ "Shaders/DefaultSpriteBatchShader.glsl" } ); // TODO: replace extention once we support multiple pipelines
+		}
+
+		void InitInstanced()
+		{
+			if (NMaxTextureSlots > EmbeddedShaderMaxTextureSlots)
+				throw std::runtime_error( "Instanced sprite shader doesn't support that many texture slots" );
 
-			// default shader
+			// static unit quad every instance is expanded from
+			VertexBufferDefinition unit_quad_props
 			{
-				std::vector<int> initial_samplers{ std::vector<int>( NMaxTextureSlots ) };
-				std::iota( std::begin( initial_samplers ), std::end( initial_samplers ), 0 ); // fill initial samplers with 0, 1, 2, 3, etc
+				.name = "SpriteBatcher unit quad VB",
+				.layout = UnitQuadLayout,
+				.usage = BufferUsage::Static,
+			};
+			unit_quad_props.SetDataFromVector( std::vector<Vec2f>( std::begin( UnitQuadCorners ), std::end( UnitQuadCorners ) ) );
+			auto unit_quad_vb = rVideo.CreateVertexBuffer( unit_quad_props );
+
+			// instance buffer, streamed into directly while sprites are submitted
+			vb = rVideo.CreateVertexBuffer(
+				VertexBufferDefinition
+				{
+					.name = "SpriteBatcher instance VB",
+					.layout = InstanceLayout,
+					.usage = BufferUsage::Stream,
+					.stream_segment_size = static_cast<uint32_t>(sizeof( SpriteInstance ) * NMaxQuads),
+					.stream_segment_count = 3,
+				} );
 
-				default_shader = rVideo.CreateShader( Filepath{ "Shaders/DefaultSpriteBatchShader.glsl" } ); // TODO: replace extention once we support multiple pipelines
-				default_shader->Bind();
-				default_shader->SetIntArray( "u_Textures", initial_samplers.data(), NMaxTextureSlots );
-			}
+			// vertex array, the unit quad must come first to match the attribute locations in the shader
+			va = rVideo.CreateVertexArray( VertexArrayDefinition
+				{
+					.name = "SpriteBatcher instanced VA",
+					.vertex_buffers = { std::move( unit_quad_vb ), vb },
+				} );
 
-			// default states
+			const bool use_texture_array = (texture_binding == TextureBinding::TextureArray);
+			default_shader = rVideo.CreateShader( "SpriteBatcher instanced", MakeShaderSource( InstancedVertexShaderSrc, use_texture_array ), MakeShaderSource( SpriteFragmentShaderSrc, use_texture_array ) );
+		}
+
+		void InitTextureArray( const uint32_t max_layers )
+		{
+			const uint32_t n_layers = std::min( max_layers, TextureArrayMaxLayers );
+			AV_ASSERT( n_layers > 0 );
+
+			texture_array = rVideo.CreateTextureArray( TextureArrayDefinition
+				{
+					.size = { TextureArrayLayerSize, TextureArrayLayerSize },
+					.layers = n_layers,
+				} );
+
+			texture_layers.resize( n_layers );
+			free_texture_layers.resize( n_layers );
+			std::iota( free_texture_layers.rbegin(), free_texture_layers.rend(), 0 ); // hand out layer 0 first
+		}
+
+		// Layers are only reclaimed between scenes, so sprites already written this scene keep sampling the texture they were written with
+		void ReclaimTextureLayers()
+		{
+			for (uint32_t i = 0; i < static_cast<uint32_t>(texture_layers.size()); ++i)
 			{
-				vertex_data.reserve( NMaxQuads );
+				auto& layer = texture_layers[i];
+				if (layer.pKey && (layer.stale || layer.texture.expired()))
+				{
+					// the address may have been reused by a texture that now has its own layer
+					if (const auto found = texture_layer_lookup.find( layer.pKey ); (found != texture_layer_lookup.end()) && (found->second == i))
+						texture_layer_lookup.erase( found );
+					layer = TextureLayer{};
+					free_texture_layers.push_back( i );
+				}
+			}
+		}
 
-				multiply_colour.emplace( Vec4f{ 1.f, 1.f, 1.f, 1.f } );
+		// Finds the layer holding `texture`, copying it into a free layer if it isn't already in the array
+		// Returns false if the texture can't live in the array, it has to go in a slot instead
+		bool FindOrAddTextureLayer( const std::shared_ptr<const Graphics::Texture>& texture, TextureSlotId& id, Vec2f& uv_scale )
+		{
+			if (const auto found = texture_layer_lookup.find( texture.get() ); found != texture_layer_lookup.end())
+			{
+				auto& layer = texture_layers[found->second];
+				// same control block, not just an address that happens to have been reused
+				if (!layer.texture.owner_before( texture ) && !texture.owner_before( layer.texture ))
+				{
+					if (layer.content_version == texture->GetContentVersion())
+					{
+						id = found->second | TextureArrayLayerFlag;
+						uv_scale = layer.uv_scale;
+						return true;
+					}
+
+					// reloaded, possibly at a new size or format. Sprites already written this scene may use the old layer,
+					// so it's left alone until the scene ends and the texture is copied again below or bound to a slot.
+					layer.stale = true;
+					texture_layer_lookup.erase( found );
+				}
 			}
+
+			const auto& size = texture->GetSize();
+			const auto& array_size = texture_array->GetSize();
+			if ((texture->GetFormat() != TextureFormat::RGBA8) || (size.width > array_size.width) || (size.height > array_size.height))
+				return false;
+			if (free_texture_layers.empty())
+				return false;
+
+			const uint32_t index = free_texture_layers.back();
+			free_texture_layers.pop_back();
+
+			// the rest of the layer gets sampled by filtering at the texture's edges, keep it transparent
+			if ((size.width < array_size.width) || (size.height < array_size.height))
+				texture_array->ClearLayer( index );
+			texture_array->CopyLayerFrom( index, *texture );
+
+			auto& layer = texture_layers[index];
+			layer.texture = texture;
+			layer.pKey = texture.get();
+			layer.uv_scale = Vec2f{ static_cast<float>(size.width) / array_size.width, static_cast<float>(size.height) / array_size.height };
+			layer.content_version = texture->GetContentVersion();
+			texture_layer_lookup[layer.pKey] = index;
+
+			id = index | TextureArrayLayerFlag;
+			uv_scale = layer.uv_scale;
+			return true;
 		}
 
-		~Data() = default;
+		uint32_t GetSpriteStride() const noexcept
+		{
+			return SpriteBatcher::GetSpriteStride( mode );
+		}
 	};
 
 
@@ -180,23 +728,45 @@ namespace Avokii::Graphics
 	/// SpriteBatcher
 	/// 
 
-	SpriteBatcher::SpriteBatcher( API::VideoAPI& r_video )
+	SpriteBatcher::SpriteBatcher( API::VideoAPI& r_video, Mode mode, TextureBinding texture_binding )
 		: mrVideo( r_video )
 	{
 		const auto& capabilities = mrVideo.GetDeviceCapabilities();
 
+		if ((texture_binding == TextureBinding::TextureArray) && (capabilities.max_texture_array_layers == 0))
+		{
+			AV_LOG_WARN( LoggingChannels::Application, "SpriteBatcher: device doesn't support copying into texture arrays, falling back to texture slots" );
+			texture_binding = TextureBinding::Slots;
+		}
+
+		// instances are located in the streamed buffer with a base instance
+		if ((mode == Mode::Instanced) && !capabilities.base_instance)
+		{
+			AV_LOG_WARN( LoggingChannels::Application, "SpriteBatcher: device doesn't support base instance drawing, falling back to quads" );
+			mode = Mode::Quads;
+		}
+
 		// TODO: determine max number of vertexes/indices
-		mpData = std::make_unique<Data>( mrVideo, 20000, std::min( (uint32_t)capabilities.max_texture_slots, (uint32_t)10 ) );
+		// the texture array takes the unit after the slots
+		const uint32_t max_texture_slots = (uint32_t)capabilities.max_texture_slots - (texture_binding == TextureBinding::TextureArray ? 1 : 0);
+		mpData = std::make_unique<Data>( mrVideo, mode, texture_binding, 20000, std::min( max_texture_slots, (uint32_t)10 ), capabilities.max_texture_array_layers );
 	}
 
 	SpriteBatcher::~SpriteBatcher() = default;
 
-	void SpriteBatcher::Begin( const Camera& camera, const glm::mat4& world_transform )
+	void SpriteBatcher::Begin( const Camera& camera, const glm::mat4& world_transform, Submission submission )
 	{
 		AV_ASSERT( !mActive );
 
 		mpData->pSceneCamera = &camera;
 		mpData->scene_transform = world_transform;
+		mpData->scene_view_transform = camera.GetViewMatrix() * world_transform;
+		mpData->scene_frustum = Frustum::FromMatrix( camera.GetViewProjectionMatrix() * world_transform );
+		mpData->submission = submission;
+		mpData->layer = 0;
+		mpData->ClearDeferred();
+		if (mpData->texture_array)
+			mpData->ReclaimTextureLayers();
 
 		mpData->default_shader->Bind();
 		mpData->default_shader->SetMat4( "u_ViewProjection", camera.GetViewProjectionMatrix() );
@@ -211,6 +781,8 @@ namespace Avokii::Graphics
 	void SpriteBatcher::EndScene()
 	{
 		AV_ASSERT( mActive );
+		if (mpData->submission != Submission::Immediate)
+			SubmitDeferred();
 		Flush();
 
 		if (mpData->active_shader)
@@ -220,7 +792,7 @@ namespace Avokii::Graphics
 
 	void SpriteBatcher::Flush()
 	{
-		if (mpData->vertex_data.empty())
+		if (mpData->write_base == nullptr)
 			return; // nothing currently pending
 		
 		if (mpData->active_shader == nullptr)
@@ -231,13 +803,26 @@ namespace Avokii::Graphics
 		// bind textures
 		for (uint32_t i = 0; i < mpData->texture_slot_index; i++)
 			mpData->texture_slots[i]->Bind( i );
+		if (mpData->texture_array)
+			mpData->texture_array->Bind( mpData->NMaxTextureSlots );
 
 		mpData->va->Bind();
 
-		// move data into the vertex buffer object
-		mpData->vb->SetData( mpData->vertex_data.data(), (uint32_t)mpData->vertex_data.size() * sizeof( QuadVertex ) );
+		// sprites were written straight into the buffer, just close the region and draw from where it landed
+		const auto byte_offset = mpData->vb->EndWrite( mpData->batch_quad_count * mpData->GetSpriteStride() );
+		mpData->write_base = nullptr;
+
+		switch (mpData->mode)
+		{
+		case Mode::Quads:
+			mrVideo.DrawIndexed( mpData->va, mpData->batch_quad_count * 6, byte_offset / sizeof( QuadVertex ) );
+			break;
 
-		mrVideo.DrawIndexed( mpData->va, mpData->quad_index_count );
+		case Mode::Instanced:
+			mrVideo.DrawInstanced( mpData->va, UnitQuadVertexCount, mpData->batch_quad_count, byte_offset / sizeof( SpriteInstance ) );
+			break;
+		}
+		mpData->batch_quad_count = 0;
 
 		mpData->va->Unbind();
 
@@ -247,10 +832,10 @@ namespace Avokii::Graphics
 	void SpriteBatcher::StartBatch()
 	{
 		AV_ASSERT( mActive );
-		mpData->quad_index_count = 0;
-		mpData->vertex_data.clear(); // reset data pointer to the start
-		AV_ASSERT( mpData->vertex_data.capacity() > 0 );
+		AV_ASSERT( mpData->write_base == nullptr, "Previous batch was not flushed" );
+		mpData->batch_quad_count = 0;
 		mpData->texture_slot_index = DefaultTextureIndex + 1;
+		mpData->last_texture.texture.reset(); // slot ids only hold within a batch
 	}
 
 	void SpriteBatcher::NextBatch()
@@ -260,7 +845,46 @@ namespace Avokii::Graphics
 		StartBatch();
 	}
 
-	SpriteBatcher::TextureSlotId SpriteBatcher::FindOrAddTexture( const std::shared_ptr<const Graphics::Texture>& texture_handle )
+	std::byte* SpriteBatcher::AllocateSprite()
+	{
+		return AllocateSprites( 1 );
+	}
+
+	std::byte* SpriteBatcher::AllocateSprites( const uint32_t count )
+	{
+		AV_ASSERT( count <= mpData->NMaxQuads - mpData->batch_quad_count );
+
+		// open a write region lazily so empty batches never consume a segment of the ring
+		if (mpData->write_base == nullptr)
+			mpData->write_base = static_cast<std::byte*>(mpData->vb->BeginWrite());
+
+		std::byte* const sprites = mpData->write_base + static_cast<size_t>(mpData->batch_quad_count) * mpData->GetSpriteStride();
+		mpData->batch_quad_count += count;
+		return sprites;
+	}
+
+	SpriteBatcher::TextureSlotId SpriteBatcher::FindOrAddTexture( const std::shared_ptr<const Graphics::Texture>& texture_handle, Vec2f& uv_scale )
+	{
+		auto& last = mpData->last_texture;
+		if (texture_handle == last.texture)
+		{
+			uv_scale = last.uv_scale;
+			return last.id;
+		}
+
+		TextureSlotId index;
+		uv_scale = Vec2f{ 1.f, 1.f };
+		if (!mpData->texture_array || !mpData->FindOrAddTextureLayer( texture_handle, index, uv_scale ))
+			index = FindOrAddTextureSlot( texture_handle );
+
+		// after any batch break, which clears it
+		last.texture = texture_handle;
+		last.id = index;
+		last.uv_scale = uv_scale;
+		return index;
+	}
+
+	SpriteBatcher::TextureSlotId SpriteBatcher::FindOrAddTextureSlot( const std::shared_ptr<const Graphics::Texture>& texture_handle )
 	{
 		SpriteBatcher::TextureSlotId index = std::numeric_limits<TextureSlotId>::max();
 
@@ -296,31 +920,328 @@ namespace Avokii::Graphics
 		if (!sprite_sheet)
 			return;
 
-		if (mpData->quad_index_count >= mpData->NMaxIndices)
+		const auto& img = sprite->GetSprite();
+		if (!mpData->IsVisible( img, location ))
+		{
+			++mStatistics.nCulled;
+			return;
+		}
+
+		const auto& texture = sprite_sheet->GetTexture();
+		const auto& multiply_colour = mpData->multiply_colour.top();
+
+		if (mpData->submission == Submission::Immediate)
+		{
+			WriteSprite( img, location, texture, multiply_colour );
+			return;
+		}
+
+		RecordDeferred( img, location, mpData->GetFrameTextureIndex( texture ), multiply_colour.packed );
+	}
+
+	void SpriteBatcher::DrawStandingSprites( const ResourceHandle<SpriteSheet>& sprite_sheet, std::span<const StandingSprite> sprites )
+	{
+		if (!sprite_sheet || sprites.empty())
+			return;
+
+		const auto& texture = sprite_sheet->GetTexture();
+		const auto entries = sprite_sheet->GetSpriteEntries();
+
+		if (mpData->submission != Submission::Immediate)
+		{
+			const auto texture_idx = mpData->GetFrameTextureIndex( texture );
+			for (const auto& sprite : sprites)
+			{
+				const auto& img = entries[sprite.sprite_idx];
+				if (mpData->IsVisible( img, sprite.location ))
+					RecordDeferred( img, sprite.location, texture_idx, std::bit_cast<uint32_t>(sprite.colour) );
+				else
+					++mStatistics.nCulled;
+			}
+			return;
+		}
+
+		if (!mpData->culling)
+		{
+			WriteStandingSprites( *sprite_sheet, texture, sprites );
+			return;
+		}
+
+		// expand each run of visible sprites in one go
+		size_t run_begin = 0;
+		for (size_t i = 0; i < sprites.size(); ++i)
+		{
+			if (IsStandingSpriteVisible( mpData->scene_frustum, entries[sprites[i].sprite_idx], sprites[i].location ))
+				continue;
+
+			if (i > run_begin)
+				WriteStandingSprites( *sprite_sheet, texture, sprites.subspan( run_begin, i - run_begin ) );
+			run_begin = i + 1;
+			++mStatistics.nCulled;
+		}
+
+		if (run_begin < sprites.size())
+			WriteStandingSprites( *sprite_sheet, texture, sprites.subspan( run_begin ) );
+	}
+
+	void SpriteBatcher::WriteStandingSprites( const SpriteSheet& sheet, const std::shared_ptr<const Graphics::Texture>& texture, std::span<const StandingSprite> sprites )
+	{
+		while (!sprites.empty())
+		{
+			if (mpData->batch_quad_count >= mpData->NMaxQuads)
+				NextBatch();
+
+			// may break the batch itself, so the space left is only known afterwards
+			Vec2f uv_scale;
+			const auto texture_id = FindOrAddTexture( texture, uv_scale );
+
+			const auto n_sprites = std::min( static_cast<uint32_t>(std::min( sprites.size(), size_t{ UINT32_MAX } )), mpData->NMaxQuads - mpData->batch_quad_count );
+			ExpandStandingSprites( mpData->mode, AllocateSprites( n_sprites ), sheet, sprites.first( n_sprites ), texture_id, uv_scale );
+			mStatistics.nQuads += n_sprites;
+
+			sprites = sprites.subspan( n_sprites );
+		}
+	}
+
+	void SpriteBatcher::RecordDeferred( const SpriteSheetEntry& img, const Vec3f& location, const uint32_t texture_idx, const uint32_t packed_colour )
+	{
+		uint64_t key = (static_cast<uint64_t>(mpData->layer) << SortKeyLayerShift) | texture_idx;
+		if (mpData->submission == Submission::DeferredBackToFront)
+		{
+			// view space z, further away is more negative so sorts first
+			const auto& m = mpData->scene_view_transform;
+			const float view_z = m[0][2] * location.x + m[1][2] * location.y + m[2][2] * location.z + m[3][2];
+			key |= static_cast<uint64_t>(ToSortableBits( view_z ) >> 16) << SortKeyDepthShift;
+		}
+
+		mpData->sort_entries.push_back( SortEntry{ key, static_cast<uint32_t>(mpData->commands.size()) } );
+		mpData->commands.push_back( Data::DeferredCommand{ location, img, texture_idx, packed_colour } );
+
+		// estimate what submission order would have cost
+		{
+			auto& slots = mpData->unsorted_slots;
+			bool needs_slot = !Contains( slots, texture_idx );
+			const bool batch_full = mpData->unsorted_batch_quads >= mpData->NMaxQuads;
+			const bool slots_full = needs_slot && (slots.size() + 1 >= mpData->NMaxTextureSlots); // first slot is the white texture
+			if (batch_full || slots_full)
+			{
+				++mStatistics.nUnsortedDrawCalls;
+				slots.clear();
+				mpData->unsorted_batch_quads = 0;
+				needs_slot = true;
+			}
+
+			if (needs_slot)
+				slots.push_back( texture_idx );
+			++mpData->unsorted_batch_quads;
+		}
+	}
+
+	void SpriteBatcher::SetLayer( uint8_t layer )
+	{
+		mpData->layer = layer;
+	}
+
+	void SpriteBatcher::SetFrustumCulling( bool enabled )
+	{
+		mpData->culling = enabled;
+	}
+
+	void SpriteBatcher::SubmitDeferred()
+	{
+		if (mpData->commands.empty())
+			return;
+
+		++mStatistics.nUnsortedDrawCalls; // the final partial batch
+
+		RadixSortByKey( mpData->sort_entries, mpData->sort_scratch );
+
+		uint32_t previous_colour = mpData->commands[mpData->sort_entries.front().command_idx].colour;
+		auto colour = MultiplyColour::FromPacked( previous_colour );
+		for (const auto& entry : mpData->sort_entries)
+		{
+			const auto& command = mpData->commands[entry.command_idx];
+			if (command.colour != previous_colour)
+			{
+				previous_colour = command.colour;
+				colour = MultiplyColour::FromPacked( previous_colour );
+			}
+
+			WriteSprite( command.img, command.location, mpData->frame_textures[command.texture_idx], colour );
+		}
+
+		mpData->ClearDeferred();
+	}
+
+	void SpriteBatcher::WriteSprite( const SpriteSheetEntry& img, const Vec3f& location, const std::shared_ptr<const Graphics::Texture>& texture, const MultiplyColour& multiply_colour )
+	{
+		if (mpData->batch_quad_count >= mpData->NMaxQuads)
 			NextBatch();
 
-		auto& img = sprite->GetSprite();
-		
+		Vec2f uv_scale;
+		const auto texture_id = FindOrAddTexture( texture, uv_scale );
+		ExpandStandingSprite( mpData->mode, AllocateSprite(), img, location, multiply_colour.floats, multiply_colour.packed, texture_id, uv_scale );
+
+		++mStatistics.nQuads;
+	}
+
+	uint32_t SpriteBatcher::GetSpriteStride( const Mode mode ) noexcept
+	{
+		return mode == Mode::Instanced ? static_cast<uint32_t>(sizeof( SpriteInstance )) : static_cast<uint32_t>(sizeof( QuadVertex ) * 4);
+	}
+
+	void SpriteBatcher::ExpandStandingSprite( const Mode mode, std::byte* dst, const SpriteSheetEntry& img, const Vec3f& location, const Vec4f& colour, const uint32_t packed_colour, const TextureSlotId texture_id, const Vec2f uv_scale )
+	{
 		const auto img_size_vec = glm::vec2( img.size.width, img.size.height );
 		const auto min = glm::vec2( -img.pivot.x, -img.pivot.y );
 		const auto max = min + img_size_vec;
 
-		const auto& texture_id = FindOrAddTexture( sprite_sheet->GetTexture() );
-		const auto& uvs = img.uvs;
-		const auto& multiply_colour = mpData->multiply_colour.top();
+		const float u0 = img.uvs.GetLeft() * uv_scale.x;
+		const float v0 = img.uvs.GetTop() * uv_scale.y;
+		const float u1 = img.uvs.GetRight() * uv_scale.x;
+		const float v1 = img.uvs.GetBottom() * uv_scale.y;
+
+		switch (mode)
+		{
+		case Mode::Quads:
+		{
+			auto* const vertices = reinterpret_cast<QuadVertex*>(dst);
+			vertices[0] = QuadVertex( Vec3f{ location.x + min.x, location.y + 0.f, location.z + min.y }, colour, Vec2f( u0, v0 ), texture_id ); // top left
+			vertices[1] = QuadVertex( Vec3f{ location.x + max.x, location.y + 0.f, location.z + min.y }, colour, Vec2f( u1, v0 ), texture_id ); // top right
+			vertices[2] = QuadVertex( Vec3f{ location.x + min.x, location.y + 0.f, location.z + max.y }, colour, Vec2f( u0, v1 ), texture_id ); // bottom left
+			vertices[3] = QuadVertex( Vec3f{ location.x + max.x, location.y + 0.f, location.z + max.y }, colour, Vec2f( u1, v1 ), texture_id ); // bottom right
+			break;
+		}
 
-		mpData->vertex_data.emplace_back( Vec3f{ location.x + min.x, location.y + 0.f, location.z + min.y }, multiply_colour, Vec2f( uvs.GetLeft(), uvs.GetTop() ), texture_id ); // top left
-		mpData->vertex_data.emplace_back( Vec3f{ location.x + max.x, location.y + 0.f, location.z + min.y }, multiply_colour, Vec2f( uvs.GetRight(), uvs.GetTop() ), texture_id ); // top right
-		mpData->vertex_data.emplace_back( Vec3f{ location.x + min.x, location.y + 0.f, location.z + max.y }, multiply_colour, Vec2f( uvs.GetLeft(), uvs.GetBottom() ), texture_id ); // bottom left
-		mpData->vertex_data.emplace_back( Vec3f{ location.x + max.x, location.y + 0.f, location.z + max.y }, multiply_colour, Vec2f( uvs.GetRight(), uvs.GetBottom() ), texture_id ); // bottom right
+		case Mode::Instanced:
+		{
+			auto* const instance = reinterpret_cast<SpriteInstance*>(dst);
+			instance->pos = location;
+			instance->rect = Vec4f{ min.x, min.y, max.x, max.y };
+			instance->uvs = Vec4f{ u0, v0, u1, v1 };
+			instance->colour = packed_colour;
+			instance->texture_index = texture_id;
+			break;
+		}
+		}
+	}
 
-		mpData->quad_index_count += 6;
-		++mStatistics.nQuads;
+	void SpriteBatcher::ExpandStandingSprites( const Mode mode, std::byte* dst, const SpriteSheet& sheet, std::span<const StandingSprite> sprites, const TextureSlotId texture_id, const Vec2f uv_scale )
+	{
+		static_assert(sizeof( QuadVertex ) == QuadVertexStride && offsetof( QuadVertex, colour ) == 12 && offsetof( QuadVertex, texcoord ) == 28 && offsetof( QuadVertex, texture_index ) == 36);
+		static_assert(sizeof( SpriteInstance ) == SpriteInstanceStride && offsetof( SpriteInstance, rect ) == 12 && offsetof( SpriteInstance, uvs ) == 28 && offsetof( SpriteInstance, colour ) == 44 && offsetof( SpriteInstance, texture_index ) == 48);
+		static_assert(offsetof( StandingSprite, sprite_idx ) == sizeof( Vec3f ));
+
+		const auto entries = sheet.GetSpriteEntries();
+#ifdef _DEBUG
+		for (const auto& sprite : sprites)
+			AV_ASSERT( sprite.sprite_idx < entries.size(), "Sprite index out of range" );
+#endif
+
+#ifdef AV_SPRITEBATCHER_SSE2
+		switch (mode)
+		{
+		case Mode::Quads: ExpandQuadsSSE2( dst, entries.data(), sprites.data(), sprites.size(), texture_id, uv_scale ); break;
+		case Mode::Instanced: ExpandInstancesSSE2( dst, entries.data(), sprites.data(), sprites.size(), texture_id, uv_scale ); break;
+		}
+#else
+		const uint32_t stride = GetSpriteStride( mode );
+		for (const auto& sprite : sprites)
+		{
+			ExpandStandingSprite( mode, dst, entries[sprite.sprite_idx], sprite.location, sprite.colour.AsFloatsRGBA(), std::bit_cast<uint32_t>(sprite.colour), texture_id, uv_scale );
+			dst += stride;
+		}
+#endif
+	}
+
+	void SpriteBatcher::BeginWriters( const uint32_t count )
+	{
+		AV_ASSERT( mActive );
+		AV_ASSERT( mpData->n_active_writers == 0, "Previous writers were not submitted" );
+
+		auto& writers = mpData->writers;
+		while (writers.size() < count)
+			writers.push_back( std::unique_ptr<Writer>( new Writer( mpData->mode ) ) );
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			auto& writer = *writers[i];
+			writer.Clear();
+			writer.mFrustum = mpData->scene_frustum;
+			writer.mCulling = mpData->culling;
+		}
+		mpData->n_active_writers = count;
+	}
+
+	SpriteBatcher::Writer& SpriteBatcher::GetWriter( const uint32_t index )
+	{
+		AV_ASSERT( index < mpData->n_active_writers );
+		return *mpData->writers[index];
+	}
+
+	void SpriteBatcher::SubmitWriters()
+	{
+		AV_ASSERT( mActive );
+
+		const uint32_t stride = mpData->GetSpriteStride();
+		for (uint32_t w = 0; w < mpData->n_active_writers; ++w)
+		{
+			auto& writer = *mpData->writers[w];
+			const std::byte* src = writer.mSprites.data();
+
+			writer.mTextures.clear();
+			for (const auto& sheet : writer.mSheets)
+				writer.mTextures.push_back( sheet->GetTexture() );
+
+			for (const uint32_t local_texture : writer.mSpriteTextures)
+			{
+				if (mpData->batch_quad_count >= mpData->NMaxQuads)
+					NextBatch();
+
+				Vec2f uv_scale;
+				const auto texture_id = FindOrAddTexture( writer.mTextures[local_texture], uv_scale );
+				std::byte* const dst = AllocateSprite();
+				std::memcpy( dst, src, stride );
+				src += stride;
+
+				// patch in what the writer couldn't know
+				const bool scale_uvs = (uv_scale.x != 1.f) || (uv_scale.y != 1.f);
+				switch (mpData->mode)
+				{
+				case Mode::Quads:
+				{
+					auto* const vertices = reinterpret_cast<QuadVertex*>(dst);
+					for (int i = 0; i < 4; ++i)
+					{
+						vertices[i].texture_index = texture_id;
+						if (scale_uvs)
+							vertices[i].texcoord *= uv_scale;
+					}
+					break;
+				}
+
+				case Mode::Instanced:
+				{
+					auto* const instance = reinterpret_cast<SpriteInstance*>(dst);
+					instance->texture_index = texture_id;
+					if (scale_uvs)
+						instance->uvs *= Vec4f{ uv_scale.x, uv_scale.y, uv_scale.x, uv_scale.y };
+					break;
+				}
+				}
+			}
+
+			mStatistics.nQuads += writer.GetSpriteCount();
+			mStatistics.nCulled += writer.mCulled;
+		}
+
+		mpData->n_active_writers = 0;
 	}
 
 	void SpriteBatcher::PushMultiplyColour( ColourRGBA colour )
 	{
-		mpData->multiply_colour.emplace( std::move( colour.AsFloatsRGBA() ) );
+		const uint32_t packed = colour.r | (colour.g << 8u) | (colour.b << 16u) | (static_cast<uint32_t>(colour.a) << 24u);
+		mpData->multiply_colour.emplace( MultiplyColour{ colour.AsFloatsRGBA(), packed } );
 	}
 
 	void SpriteBatcher::PopMultiplyColour()
@@ -333,4 +1254,73 @@ namespace Avokii::Graphics
 	{
 		memset( &mStatistics, 0, sizeof( SpriteBatcher::Statistics ) );
 	}
+
+
+	///
+	/// Writer
+	/// 
+
+	SpriteBatcher::Writer::Writer( const Mode mode )
+		: mMode{ mode }
+		, mStride{ SpriteBatcher::GetSpriteStride( mode ) }
+	{
+	}
+
+	void SpriteBatcher::Writer::Clear()
+	{
+		mSprites.clear();
+		mSpriteTextures.clear();
+		mSheets.clear();
+		mTextures.clear();
+		mColour = Vec4f{ 1.f, 1.f, 1.f, 1.f };
+		mPackedColour = 0xffffffff;
+		mCulled = 0;
+	}
+
+	void SpriteBatcher::Writer::Reserve( const uint32_t n_sprites )
+	{
+		mSprites.reserve( static_cast<size_t>(n_sprites) * mStride );
+		mSpriteTextures.reserve( n_sprites );
+	}
+
+	void SpriteBatcher::Writer::SetMultiplyColour( ColourRGBA colour )
+	{
+		mColour = colour.AsFloatsRGBA();
+		mPackedColour = colour.r | (colour.g << 8u) | (colour.b << 16u) | (static_cast<uint32_t>(colour.a) << 24u);
+	}
+
+	uint32_t SpriteBatcher::Writer::FindOrAddSheet( std::shared_ptr<const SpriteSheet>&& sheet )
+	{
+		// few distinct sheets per writer, and usually the same one as last time
+		if (!mSpriteTextures.empty() && (mSheets[mSpriteTextures.back()] == sheet))
+			return mSpriteTextures.back();
+
+		if (const auto found = std::find( mSheets.begin(), mSheets.end(), sheet ); found != mSheets.end())
+			return static_cast<uint32_t>(std::distance( mSheets.begin(), found ));
+
+		mSheets.push_back( std::move( sheet ) );
+		return static_cast<uint32_t>(mSheets.size() - 1);
+	}
+
+	void SpriteBatcher::Writer::DrawStandingSprite( const ResourceHandle<Sprite>& sprite, Vec3f location )
+	{
+		if (!sprite)
+			return;
+		auto sprite_sheet = sprite->GetSpriteSheet();
+		if (!sprite_sheet)
+			return;
+
+		const auto& img = sprite->GetSprite();
+		if (mCulling && !IsStandingSpriteVisible( mFrustum, img, location ))
+		{
+			++mCulled;
+			return;
+		}
+
+		mSpriteTextures.push_back( FindOrAddSheet( std::move( sprite_sheet ) ) );
+
+		const size_t offset = mSprites.size();
+		mSprites.resize( offset + mStride );
+		ExpandStandingSprite( mMode, mSprites.data() + offset, img, location, mColour, mPackedColour, 0, Vec2f{ 1.f, 1.f } );
+	}
 }
@@ -3,10 +3,16 @@
 #include "Avokii/Types/Colour.hpp"
 #include "Avokii/Types/Vec2.hpp"
 #include "Avokii/Types/Vec3.hpp"
+#include "Avokii/Types/Vec4.hpp"
 #include "Avokii/Types/Mat4.hpp"
 
+#include "Avokii/Geometry/Frustum.hpp"
+
+#include "Avokii/Jobs/JobSystem.hpp"
 #include "Avokii/Resources/ResourceHandle.hpp"
 
+#include <span>
+
 namespace Avokii
 {
 	namespace API { class VideoAPI; }
@@ -16,6 +22,8 @@ namespace Avokii
 	{
 		class Camera;
 		class Sprite;
+		class SpriteSheet;
+		struct SpriteSheetEntry;
 		class Texture;
 
 		// Unlike Renderer this does not provide a static interface and allows multiple instances to be created
@@ -26,33 +34,101 @@ namespace Avokii
 		{
 		private:
 			using TextureSlotId = unsigned int;
+			struct QuadVertex;
+			struct SpriteInstance;
+			struct MultiplyColour;
 
 		public:
+			enum class Mode
+			{
+				Quads,		// four vertices per sprite drawn from a shared index buffer
+				Instanced,	// one compact instance record per sprite expanded from a static unit quad
+			};
+
+			enum class TextureBinding
+			{
+				Slots,			// each texture takes one of the bound texture units, running out breaks the batch
+				TextureArray,	// RGBA8 sheets are copied into layers of one texture array, only other textures take a unit
+			};
+
+			enum class Submission
+			{
+				Immediate,				// batched in submission order as sprites are drawn
+				Deferred,				// recorded and sorted by layer then texture at EndScene(), relies on the depth test for ordering
+				DeferredBackToFront,	// as Deferred but sorted back to front within each layer, for translucent sprites
+			};
+
 			struct Statistics
 			{
 				uint32_t nDrawCalls = 0;
 				uint32_t nQuads = 0;
+				// deferred submission only, draw calls the same sprites would have taken if batched in submission order
+				uint32_t nUnsortedDrawCalls = 0;
+				// sprites rejected by frustum culling, not included in nQuads
+				uint32_t nCulled = 0;
 
 				uint32_t GetTotalVertexCount() const { return nQuads * 4; }
 				uint32_t GetTotalIndexCount() const { return nQuads * 6; }
 			};
 
+			// One sprite for DrawStandingSprites()
+			struct StandingSprite
+			{
+				Vec3f location;
+				uint32_t sprite_idx; // into the sprite sheet, must directly follow location so it can be loaded as 16 bytes
+				ColourRGBA colour; // replaces the multiply colour for this sprite
+			};
+
 		public:
-			explicit SpriteBatcher( API::VideoAPI& video );
+			explicit SpriteBatcher( API::VideoAPI& video, Mode mode = Mode::Quads, TextureBinding texture_binding = TextureBinding::Slots );
 			virtual ~SpriteBatcher();
 
-			void Begin( const Camera& rCamera, const Mat4f& worldTransform = Mat4f{ 1.f } );
+			void Begin( const Camera& rCamera, const Mat4f& worldTransform = Mat4f{ 1.f }, Submission submission = Submission::Immediate );
 			void EndScene();
 
 #pragma region Drawing state
 			void PushMultiplyColour( ColourRGBA colour );
 			void PopMultiplyColour();
 
+			// Sprites on lower layers are drawn first. Only applies to deferred submission.
+			void SetLayer( uint8_t layer );
+
+			// Rejects sprites outside the camera frustum before they are expanded, enabled by default
+			void SetFrustumCulling( bool enabled );
+
 			void Flush();
 #pragma endregion
 
 #pragma region Submission
 			void DrawStandingSprite( const ResourceHandle<Sprite>& sprite, Vec3f location );
+			// Bulk submission of sprites sharing a sheet, expanded with SIMD where available
+			void DrawStandingSprites( const ResourceHandle<SpriteSheet>& sprite_sheet, std::span<const StandingSprite> sprites );
+#pragma endregion
+
+#pragma region Parallel recording
+			class Writer;
+
+			// Prepares `count` writers for recording on other threads, one writer per thread
+			// Writers keep their allocations between scenes
+			void BeginWriters( uint32_t count );
+			Writer& GetWriter( uint32_t index );
+			// Writes everything the writers recorded into the scene, in writer order, bypassing deferred sorting.
+			// All recording must have finished. Main thread only, the sheets' textures are resolved here.
+			void SubmitWriters();
+
+			// Records [0, count) on the job system with a writer per batch of `batch_size`, then submits them in order.
+			// `record( writer, begin, end )` runs on any thread, so it mustn't touch the video API or load resources.
+			template<class Func>
+			void RecordParallel( JobSystem& jobs, size_t count, size_t batch_size, Func&& record )
+			{
+				batch_size = std::max<size_t>( batch_size, 1 );
+				BeginWriters( static_cast<uint32_t>( (count + batch_size - 1) / batch_size ) );
+				jobs.ParallelFor( count, batch_size, [&]( size_t begin, size_t end )
+					{
+						record( GetWriter( static_cast<uint32_t>( begin / batch_size ) ), begin, end );
+					} );
+				SubmitWriters();
+			}
 #pragma endregion
 
 			const Statistics& GetStatistics() const { return mStatistics; }
@@ -62,8 +138,30 @@ namespace Avokii
 			void StartBatch();
 			void NextBatch();
 
+			// Writes one sprite into the current batch, can cause batch breaks
+			void WriteSprite( const SpriteSheetEntry& img, const Vec3f& location, const std::shared_ptr<const Graphics::Texture>& texture, const MultiplyColour& colour );
+			// Expands a run of sprites sharing a sheet into the current batch, can cause batch breaks
+			void WriteStandingSprites( const SpriteSheet& sheet, const std::shared_ptr<const Graphics::Texture>& texture, std::span<const StandingSprite> sprites );
+			// Records a sprite for deferred submission
+			void RecordDeferred( const SpriteSheetEntry& img, const Vec3f& location, uint32_t frame_texture_idx, uint32_t packed_colour );
+			// Sorts the recorded deferred commands and writes them out
+			void SubmitDeferred();
+
+			// Reserves space for the next sprite in the mapped vertex buffer, a QuadVertex[4] or SpriteInstance depending on mode
+			std::byte* AllocateSprite();
+			// As AllocateSprite() but for `count` consecutive sprites, which must fit in the current batch
+			std::byte* AllocateSprites( uint32_t count );
+
+			// Returns the texture index to write into the sprite, texcoords must be multiplied by `uv_scale`
 			// Warning: can cause batch breaks
-			TextureSlotId FindOrAddTexture( const std::shared_ptr<const Graphics::Texture>& textureHandle );
+			TextureSlotId FindOrAddTexture( const std::shared_ptr<const Graphics::Texture>& textureHandle, Vec2f& uv_scale );
+			// Writes one sprite in the layout for `mode` to `dst`
+			static void ExpandStandingSprite( Mode mode, std::byte* dst, const SpriteSheetEntry& img, const Vec3f& location, const Vec4f& colour, uint32_t packed_colour, TextureSlotId texture_id, Vec2f uv_scale );
+			static void ExpandStandingSprites( Mode mode, std::byte* dst, const SpriteSheet& sheet, std::span<const StandingSprite> sprites, TextureSlotId texture_id, Vec2f uv_scale );
+			static uint32_t GetSpriteStride( Mode mode ) noexcept;
+
+			// Warning: can cause batch breaks
+			TextureSlotId FindOrAddTextureSlot( const std::shared_ptr<const Graphics::Texture>& textureHandle );
 
 		private:
 			API::VideoAPI& mrVideo;
@@ -74,5 +172,44 @@ namespace Avokii
 			Statistics mStatistics;
 			bool mActive{ false };
 		};
+
+		// Expands sprites into CPU memory on any thread, with texture indices resolved when the owning SpriteBatcher submits it
+		// A writer must only be used by one thread at a time, and not while SpriteBatcher::SubmitWriters() runs
+		class SpriteBatcher::Writer final
+		{
+		public:
+			void Reserve( uint32_t n_sprites );
+
+			void SetMultiplyColour( ColourRGBA colour );
+			void DrawStandingSprite( const ResourceHandle<Sprite>& sprite, Vec3f location );
+
+			uint32_t GetSpriteCount() const noexcept { return static_cast<uint32_t>(mSpriteTextures.size()); }
+
+		private:
+			friend class SpriteBatcher;
+
+			explicit Writer( Mode mode );
+			void Clear();
+
+			uint32_t FindOrAddSheet( std::shared_ptr<const SpriteSheet>&& sheet );
+
+		private:
+			const Mode mMode;
+			const uint32_t mStride;
+
+			std::vector<std::byte> mSprites; // mStride bytes per sprite, texture indices are left for the owning batcher
+			std::vector<uint32_t> mSpriteTextures; // per sprite, into mSheets
+			// sheets rather than their textures as GetTexture() can load, the textures are resolved by SubmitWriters()
+			std::vector<std::shared_ptr<const SpriteSheet>> mSheets;
+			std::vector<std::shared_ptr<const Graphics::Texture>> mTextures;
+
+			Vec4f mColour{ 1.f, 1.f, 1.f, 1.f };
+			uint32_t mPackedColour = 0xffffffff;
+
+			// copied from the batcher by BeginWriters()
+			Frustum mFrustum;
+			bool mCulling = false;
+			uint32_t mCulled = 0;
+		};
 	}
 }
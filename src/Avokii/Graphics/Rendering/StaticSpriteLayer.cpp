@@ -0,0 +1,374 @@
+#include "StaticSpriteLayer.hpp"
+
+#include <numeric>
+
+#include "Avokii/API/VideoAPI.hpp"
+
+#include "Avokii/Graphics/Camera.hpp"
+#include "Avokii/Graphics/DeviceCapabilities.hpp"
+#include "Avokii/Graphics/GraphicsBuffer.hpp"
+#include "Avokii/Graphics/VertexArray.hpp"
+#include "Avokii/Graphics/Shader.hpp"
+#include "Avokii/Graphics/Texture.hpp"
+#include "Avokii/Graphics/Resources/SpriteSheet.hpp"
+
+#include "Avokii/Types/Vec2.hpp"
+#include "Avokii/Types/Vec4.hpp"
+
+namespace Avokii::Graphics
+{
+	// same layout as the SpriteBatcher quad vertices, so both go through the default sprite shader
+#pragma pack(push, 1)
+	struct StaticSpriteLayer::Vertex
+	{
+		Vec3f pos;
+		Vec4f colour;
+		Vec2f texcoord;
+		uint32_t texture_index;
+	};
+#pragma pack(pop)
+
+	namespace
+	{
+		static const BufferLayout VertexLayout
+		{
+			BufferElement{ ShaderDataType::Float3, "a_Position" },
+			BufferElement{ ShaderDataType::Float4, "a_Colour" },
+			BufferElement{ ShaderDataType::Float2, "a_Texcoord" },
+			BufferElement{ ShaderDataType::uInt, "a_TextureIndex" },
+		};
+
+		constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+		constexpr uint32_t MinQuadCapacity = 256;
+	}
+
+	///
+	/// Data
+	///
+	struct StaticSpriteLayer::Data
+	{
+		const uint32_t NMaxTextureSlots;
+
+		API::VideoAPI& rVideo;
+
+		struct SpriteEntry
+		{
+			std::shared_ptr<const Graphics::Texture> texture; // null for removed entries
+			Vec3f location;
+			SpriteSheetEntry img;
+			Vec4f colour;
+
+			// where the sprite was baked, InvalidIndex until the next rebake
+			uint32_t quad = InvalidIndex;
+			uint32_t group = InvalidIndex;
+		};
+		std::vector<SpriteEntry> sprites; // indexed by SpriteId
+		std::vector<SpriteId> free_ids;
+
+		// one draw call each, a contiguous range of quads using at most NMaxTextureSlots textures
+		struct DrawGroup
+		{
+			uint32_t first_quad = 0;
+			uint32_t n_quads = 0;
+			std::vector<std::shared_ptr<const Graphics::Texture>> textures;
+		};
+		std::vector<DrawGroup> groups;
+
+		// CPU copy of the baked vertices, patched in place and re-uploaded by range
+		std::vector<Vertex> vertices;
+		uint32_t n_baked_quads = 0;
+		uint32_t quad_capacity = 0;
+		uint32_t dirty_first_quad = InvalidIndex;
+		uint32_t dirty_last_quad = 0;
+		bool needs_rebake = false;
+
+		// device objects
+		std::shared_ptr<Graphics::Shader> shader;
+		std::shared_ptr<Graphics::VertexBuffer> vb;
+		std::shared_ptr<Graphics::VertexArray> va;
+
+		Data( API::VideoAPI& r_video, const uint32_t max_texture_slots )
+			: NMaxTextureSlots{ max_texture_slots }
+			, rVideo{ r_video }
+		{
+			if (NMaxTextureSlots < 1)
+				throw std::runtime_error( "Device reported not enough texture slots" );
+
+			shader = rVideo.CreateShader( Filepath{ "Shaders/DefaultSpriteBatchShader.glsl" } );
+
+			std::vector<int> samplers( NMaxTextureSlots );
+			std::iota( std::begin( samplers ), std::end( samplers ), 0 );
+			shader->Bind();
+			shader->SetIntArray( "u_Textures", samplers.data(), NMaxTextureSlots );
+			shader->Unbind();
+		}
+
+		void WriteQuad( const SpriteEntry& sprite, const uint32_t texture_slot )
+		{
+			const auto& img = sprite.img;
+			const auto& location = sprite.location;
+			const float min_x = location.x - img.pivot.x;
+			const float min_z = location.z - img.pivot.y;
+			const float max_x = min_x + img.size.width;
+			const float max_z = min_z + img.size.height;
+
+			Vertex* const quad = &vertices[static_cast<size_t>(sprite.quad) * 4];
+			quad[0] = Vertex{ Vec3f{ min_x, location.y, min_z }, sprite.colour, Vec2f{ img.uvs.GetLeft(), img.uvs.GetTop() }, texture_slot }; // top left
+			quad[1] = Vertex{ Vec3f{ max_x, location.y, min_z }, sprite.colour, Vec2f{ img.uvs.GetRight(), img.uvs.GetTop() }, texture_slot }; // top right
+			quad[2] = Vertex{ Vec3f{ min_x, location.y, max_z }, sprite.colour, Vec2f{ img.uvs.GetLeft(), img.uvs.GetBottom() }, texture_slot }; // bottom left
+			quad[3] = Vertex{ Vec3f{ max_x, location.y, max_z }, sprite.colour, Vec2f{ img.uvs.GetRight(), img.uvs.GetBottom() }, texture_slot }; // bottom right
+
+			MarkDirty( sprite.quad );
+		}
+
+		// collapsed and transparent, the quad keeps its place until the next rebake
+		void HideQuad( const uint32_t quad_idx )
+		{
+			std::fill_n( &vertices[static_cast<size_t>(quad_idx) * 4], 4, Vertex{ Vec3f{ 0.f, 0.f, 0.f }, Vec4f{ 0.f, 0.f, 0.f, 0.f }, Vec2f{ 0.f, 0.f }, 0 } );
+			MarkDirty( quad_idx );
+		}
+
+		void MarkDirty( const uint32_t quad_idx )
+		{
+			dirty_first_quad = std::min( dirty_first_quad, quad_idx );
+			dirty_last_quad = std::max( dirty_last_quad, quad_idx );
+		}
+
+		void CreateBuffers( const uint32_t n_quads )
+		{
+			quad_capacity = std::max( { n_quads, quad_capacity * 2, MinQuadCapacity } );
+
+			VertexBufferDefinition vb_props
+			{
+				.name = "StaticSpriteLayer VB",
+				.layout = VertexLayout,
+				.usage = BufferUsage::Dynamic,
+			};
+			vb_props.data.resize( sizeof( Vertex ) * 4 * quad_capacity );
+			vb = rVideo.CreateVertexBuffer( vb_props );
+
+			IndexBufferDefinition ib_props
+			{
+				.name = "StaticSpriteLayer IB",
+			};
+			constexpr uint32_t quad_indices[] = { 0, 1, 2, 1, 3, 2 };
+			ib_props.indices.reserve( static_cast<size_t>(quad_capacity) * 6 );
+			for (uint32_t quad = 0; quad < quad_capacity; ++quad)
+			{
+				for (const auto index : quad_indices)
+					ib_props.indices.push_back( quad * 4 + index );
+			}
+
+			va = rVideo.CreateVertexArray( VertexArrayDefinition
+				{
+					.name = "StaticSpriteLayer VA",
+					.vertex_buffers = { vb },
+					.index_buffer = rVideo.CreateIndexBuffer( ib_props ),
+				} );
+		}
+	};
+
+
+	///
+	/// StaticSpriteLayer
+	///
+
+	StaticSpriteLayer::StaticSpriteLayer( API::VideoAPI& r_video )
+		: mrVideo( r_video )
+	{
+		const auto& capabilities = mrVideo.GetDeviceCapabilities();
+		mpData = std::make_unique<Data>( mrVideo, std::min( (uint32_t)capabilities.max_texture_slots, (uint32_t)10 ) );
+	}
+
+	StaticSpriteLayer::~StaticSpriteLayer() = default;
+
+	StaticSpriteLayer::SpriteId StaticSpriteLayer::AddStandingSprite( const ResourceHandle<Sprite>& sprite, Vec3f location, ColourRGBA colour )
+	{
+		// checked before taking an id, an entry left without a texture would read as already removed
+		if (!sprite || !sprite->GetSpriteSheet() || !sprite->GetSpriteSheet()->GetTexture())
+		{
+			AV_LOG_WARN( LoggingChannels::Application, "Tried to add a missing sprite or one without a texture to a static sprite layer" );
+			return InvalidSpriteId;
+		}
+
+		SpriteId id;
+		if (!mpData->free_ids.empty())
+		{
+			id = mpData->free_ids.back();
+			mpData->free_ids.pop_back();
+		}
+		else
+		{
+			id = static_cast<SpriteId>(mpData->sprites.size());
+			mpData->sprites.emplace_back();
+		}
+
+		SetStandingSprite( id, sprite, location, colour );
+		return id;
+	}
+
+	void StaticSpriteLayer::SetStandingSprite( SpriteId id, const ResourceHandle<Sprite>& sprite, Vec3f location, ColourRGBA colour )
+	{
+		AV_ASSERT( id < mpData->sprites.size() );
+		const auto sprite_sheet = sprite ? sprite->GetSpriteSheet() : nullptr;
+		auto texture = sprite_sheet ? sprite_sheet->GetTexture() : nullptr;
+		// the entry keeps its sprite, without a texture it would read as removed
+		if (!texture)
+		{
+			AV_LOG_WARN( LoggingChannels::Application, "Tried to set a static sprite layer's sprite to a missing sprite or one without a texture" );
+			return;
+		}
+
+		auto& entry = mpData->sprites[id];
+		entry.texture = std::move( texture );
+		entry.location = location;
+		entry.img = sprite->GetSprite();
+		entry.colour = colour.AsFloatsRGBA();
+
+		if (mpData->needs_rebake)
+			return;
+
+		// patch in place if the sprite's draw group already binds the texture
+		if (entry.quad != InvalidIndex)
+		{
+			const auto& textures = mpData->groups[entry.group].textures;
+			if (const auto found = std::find( textures.begin(), textures.end(), entry.texture ); found != textures.end())
+			{
+				mpData->WriteQuad( entry, static_cast<uint32_t>(std::distance( textures.begin(), found )) );
+				++mStatistics.nPatchedSprites;
+				return;
+			}
+		}
+
+		mpData->needs_rebake = true;
+	}
+
+	void StaticSpriteLayer::RemoveSprite( SpriteId id )
+	{
+		AV_ASSERT( id < mpData->sprites.size() );
+		auto& entry = mpData->sprites[id];
+		AV_ASSERT( entry.texture, "Sprite was already removed" );
+
+		if (!mpData->needs_rebake && (entry.quad != InvalidIndex))
+			mpData->HideQuad( entry.quad );
+
+		entry = Data::SpriteEntry{};
+		mpData->free_ids.push_back( id );
+	}
+
+	void StaticSpriteLayer::Clear()
+	{
+		mpData->sprites.clear();
+		mpData->free_ids.clear();
+		mpData->needs_rebake = true;
+	}
+
+	uint32_t StaticSpriteLayer::GetSpriteCount() const noexcept
+	{
+		return static_cast<uint32_t>(mpData->sprites.size() - mpData->free_ids.size());
+	}
+
+	void StaticSpriteLayer::Rebuild()
+	{
+		auto& data = *mpData;
+
+		// live sprites grouped by texture
+		std::vector<SpriteId> order;
+		order.reserve( GetSpriteCount() );
+		for (SpriteId id = 0; id < static_cast<SpriteId>(data.sprites.size()); ++id)
+		{
+			if (data.sprites[id].texture)
+				order.push_back( id );
+		}
+		std::sort( order.begin(), order.end(), [&data]( const SpriteId a, const SpriteId b ) { return data.sprites[a].texture.get() < data.sprites[b].texture.get(); } );
+
+		const auto n_quads = static_cast<uint32_t>(order.size());
+		if (n_quads > data.quad_capacity)
+			data.CreateBuffers( n_quads );
+
+		data.groups.clear();
+		data.vertices.resize( static_cast<size_t>(n_quads) * 4 );
+		const Graphics::Texture* previous_texture = nullptr;
+		for (uint32_t quad = 0; quad < n_quads; ++quad)
+		{
+			auto& entry = data.sprites[order[quad]];
+
+			// a new texture that doesn't fit in the current group starts the next one
+			if (entry.texture.get() != previous_texture)
+			{
+				if (data.groups.empty() || (data.groups.back().textures.size() >= data.NMaxTextureSlots))
+					data.groups.push_back( Data::DrawGroup{ .first_quad = quad } );
+				data.groups.back().textures.push_back( entry.texture );
+				previous_texture = entry.texture.get();
+			}
+
+			auto& group = data.groups.back();
+			++group.n_quads;
+
+			entry.quad = quad;
+			entry.group = static_cast<uint32_t>(data.groups.size() - 1);
+			data.WriteQuad( entry, static_cast<uint32_t>(group.textures.size() - 1) );
+		}
+
+		data.n_baked_quads = n_quads;
+		data.needs_rebake = false;
+		data.dirty_first_quad = InvalidIndex;
+		data.dirty_last_quad = 0;
+
+		if (n_quads > 0)
+			data.vb->SetSubData( 0, data.vertices.data(), static_cast<uint32_t>(data.vertices.size() * sizeof( Vertex )) );
+
+		++mStatistics.nRebakes;
+	}
+
+	void StaticSpriteLayer::UploadPatches()
+	{
+		auto& data = *mpData;
+		if (data.dirty_first_quad == InvalidIndex)
+			return;
+
+		// one upload covering every patched quad, they are usually few and close together
+		const uint32_t first_vertex = data.dirty_first_quad * 4;
+		const uint32_t n_vertices = (data.dirty_last_quad - data.dirty_first_quad + 1) * 4;
+		data.vb->SetSubData( first_vertex * sizeof( Vertex ), &data.vertices[first_vertex], n_vertices * sizeof( Vertex ) );
+
+		data.dirty_first_quad = InvalidIndex;
+		data.dirty_last_quad = 0;
+	}
+
+	void StaticSpriteLayer::Draw( const Camera& camera, const Mat4f& world_transform )
+	{
+		if (mpData->needs_rebake)
+			Rebuild();
+		else
+			UploadPatches();
+
+		if (mpData->groups.empty())
+			return;
+
+		auto& shader = *mpData->shader;
+		shader.Bind();
+		shader.SetMat4( "u_ViewProjection", camera.GetViewProjectionMatrix() );
+		shader.SetMat4( "u_Model", world_transform );
+
+		mpData->va->Bind();
+		for (const auto& group : mpData->groups)
+		{
+			for (uint32_t i = 0; i < static_cast<uint32_t>(group.textures.size()); ++i)
+				group.textures[i]->Bind( i );
+
+			mrVideo.DrawIndexed( mpData->va, group.n_quads * 6, group.first_quad * 4 );
+			++mStatistics.nDrawCalls;
+		}
+		mpData->va->Unbind();
+
+		shader.Unbind();
+
+		mStatistics.nQuads += mpData->n_baked_quads;
+	}
+
+	void StaticSpriteLayer::ClearStats()
+	{
+		mStatistics = Statistics{};
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Avokii/Types/Colour.hpp"
+#include "Avokii/Types/Vec3.hpp"
+#include "Avokii/Types/Mat4.hpp"
+
+#include "Avokii/Resources/ResourceHandle.hpp"
+
+#include <limits>
+
+namespace Avokii
+{
+	namespace API { class VideoAPI; }
+
+	namespace Graphics
+	{
+		class Camera;
+		class Sprite;
+
+		// Sprites that rarely change, baked into GPU resident buffers and redrawn without touching their vertices
+		//
+		// Sprites are grouped by texture when baked, each group is one draw call.
+		// Changing a sprite to another one on a texture its group already binds only re-uploads that sprite,
+		// anything else (adding sprites, new textures) rebakes the layer on the next Draw().
+		class StaticSpriteLayer final
+		{
+		public:
+			using SpriteId = uint32_t;
+			static constexpr SpriteId InvalidSpriteId = std::numeric_limits<SpriteId>::max();
+
+			struct Statistics
+			{
+				uint32_t nDrawCalls = 0;
+				uint32_t nQuads = 0;
+				uint32_t nRebakes = 0;
+				uint32_t nPatchedSprites = 0;
+			};
+
+		public:
+			explicit StaticSpriteLayer( API::VideoAPI& video );
+			~StaticSpriteLayer();
+
+#pragma region Building
+			// Returns an id for patching the sprite later, stays valid until the sprite is removed.
+			// InvalidSpriteId if the sprite, its sheet or the sheet's texture is missing, nothing is added.
+			SpriteId AddStandingSprite( const ResourceHandle<Sprite>& sprite, Vec3f location, ColourRGBA colour = ColourRGBA( 255, 255, 255 ) );
+			// Ignored with a warning if the sprite, its sheet or the sheet's texture is missing
+			void SetStandingSprite( SpriteId id, const ResourceHandle<Sprite>& sprite, Vec3f location, ColourRGBA colour = ColourRGBA( 255, 255, 255 ) );
+			void RemoveSprite( SpriteId id );
+			void Clear();
+
+			// Bakes now rather than on the next Draw()
+			void Rebuild();
+#pragma endregion
+
+			void Draw( const Camera& camera, const Mat4f& world_transform = Mat4f{ 1.f } );
+
+			uint32_t GetSpriteCount() const noexcept;
+
+			const Statistics& GetStatistics() const { return mStatistics; }
+			void ClearStats();
+
+		private:
+			struct Vertex;
+
+			void UploadPatches();
+
+		private:
+			API::VideoAPI& mrVideo;
+
+			struct Data;
+			std::unique_ptr<Data> mpData;
+
+			Statistics mStatistics;
+		};
+	}
+}
@@ -37,6 +37,11 @@ namespace Avokii::Graphics
 		mMaterial = new_material;
 	}
 
+	ResourceFootprint Mesh::GetFootprint() const noexcept
+	{
+		return ResourceFootprint{ .cpu_bytes = mVertexData.size() + mIndices.size() * sizeof( Index_T ) };
+	}
+
 	BasicMesh::BasicMesh()
 		: Mesh{ sBasicMeshLayout }
 	{
@@ -41,6 +41,8 @@ namespace Avokii
 
 			virtual const BufferLayout& GetLayout() const noexcept { return mVertexLayout; }
 
+			virtual ResourceFootprint GetFootprint() const noexcept override;
+
 		protected:
 			uint32_t mNumVertices{ 0 };
 			std::vector<std::byte> mVertexData;
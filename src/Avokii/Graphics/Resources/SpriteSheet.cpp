@@ -1,5 +1,7 @@
 #include "SpriteSheet.hpp"
 
+#include <mutex>
+
 #include "Avokii/File/FileOps.hpp"
 #include "Avokii/Resources/ResourceManager.hpp"
 #include "Avokii/Resources/ResourceLoader.hpp"
@@ -18,10 +20,13 @@ namespace
 {
 	using namespace Avokii;
 
-	bool ParseFreeTexPackerSpritesheetJson( const Json& json, const Filepath& filepath_prefix, std::vector<Graphics::SpriteSheetEntry>& out, Filepath& texture_filename_out )
-	{
-		AV_ASSERT( std::filesystem::is_directory( filepath_prefix ) );
+	using Graphics::SpriteSheet;
+	using Graphics::SpriteSheetEntry;
+
+	using ParsedSprites = std::vector<std::pair<String, SpriteSheetEntry>>;
 
+	bool ParseFreeTexPackerSpritesheetJson( const Json& json, const Filepath& filepath_prefix, ParsedSprites& out, Filepath& texture_filename_out )
+	{
 		const size_t old_out_size{ out.size() };
 
 		const auto parse_frame = [&]( std::string_view key, const nlohmann::json& obj, const Size<float>& texture_size )
@@ -62,9 +67,9 @@ namespace
 			}
 
 			out.emplace_back(
-				Graphics::SpriteSheetEntry
+				String{ key },
+				SpriteSheetEntry
 				{
-					.assetId = String{ key },
 					.pivot = { rect.w * pivot.x, rect.h * pivot.y },
 					.uvs = { Point2D<float>{ rect.x / texture_size.width, rect.y / texture_size.height }, Size<float>{ rect.w / texture_size.width, rect.h / texture_size.height } },
 					.size = { rect.w, rect.h },
@@ -112,6 +117,131 @@ namespace
 		AV_ASSERT( added_images > 0, "Expected to load at least one image?" );
 		return added_images > 0;
 	}
+
+	bool ParseSpritesheetJson( StringView json_string, const Filepath& filepath_prefix, ParsedSprites& out, Filepath& texture_filename_out )
+	{
+		// not checked against the disk, the sheet may have come from an archive
+		try
+		{
+			const auto j = nlohmann::json::parse( json_string );
+			if (j.contains( "frames" ) && j.contains( "meta" ) && j["meta"]["app"].is_string() && j["meta"]["app"].get<std::string>() == "http://free-tex-packer.com")
+				return ParseFreeTexPackerSpritesheetJson( j, filepath_prefix, out, texture_filename_out );
+		}
+		catch (nlohmann::json::exception& e)
+		{
+			AV_LOG_ERROR( LoggingChannels::Resource, "Exception while parsing spritesheet json: '{}'", e.what() );
+		}
+		catch (std::runtime_error& e)
+		{
+			AV_LOG_ERROR( LoggingChannels::Resource, "Exception while parsing spritesheet:'{}'", e.what() );
+		}
+
+		return false;
+	}
+
+	///
+	/// Cooked format
+	///
+
+	constexpr uint32_t CookedMagic = 0x53535641; // "AVSS"
+	constexpr uint32_t CookedVersion = 1;
+
+	// followed by sprite_count SpriteSheetEntrys, sprite_count SpriteIds, the asset id block then the texture asset id
+	struct CookedHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t sprite_count;
+		uint32_t asset_ids_size;
+		uint32_t texture_asset_id_size;
+		uint32_t reserved;
+	};
+	static_assert(sizeof( CookedHeader ) == 24);
+	static_assert(sizeof( SpriteSheetEntry ) == 44, "Changing SpriteSheetEntry changes the cooked format, bump CookedVersion");
+	static_assert(sizeof( SpriteSheet::SpriteId ) == 8 && std::is_trivially_copyable_v<SpriteSheet::SpriteId>);
+
+	bool SpriteIdLess( const SpriteSheet::SpriteId& entry, const ResourceId::hash_type resource_id ) noexcept
+	{
+		return entry.resourceId < resource_id;
+	}
+
+	const SpriteSheet::SpriteId* FindSpriteId( const std::vector<SpriteSheet::SpriteId>& ids, const ResourceId resource_id ) noexcept
+	{
+		const auto found = std::lower_bound( std::begin( ids ), std::end( ids ), resource_id.value(), SpriteIdLess );
+		if ((found != std::end( ids )) && (found->resourceId == resource_id.value()))
+			return &*found;
+
+		return nullptr;
+	}
+
+	bool InsertSprite( std::vector<SpriteSheetEntry>& sprites, std::vector<SpriteSheet::SpriteId>& ids, String& asset_ids, StringView asset_id, SpriteSheetEntry sprite )
+	{
+		const auto resource_id = ToResourceId( asset_id ).value();
+		const auto it = std::lower_bound( std::begin( ids ), std::end( ids ), resource_id, SpriteIdLess );
+		if ((it != std::end( ids )) && (it->resourceId == resource_id))
+		{
+			AV_LOG_WARN( LoggingChannels::Resource, "Sprite '{}' has the same resource id as a sprite already in the sheet, skipping it", asset_id );
+			return false;
+		}
+
+		sprite.assetIdOffset = static_cast<uint32_t>(asset_ids.size());
+		sprite.assetIdLength = static_cast<uint32_t>(asset_id.size());
+		asset_ids += asset_id;
+
+		ids.insert( it, SpriteSheet::SpriteId{ resource_id, static_cast<SpriteSheet::SpriteIdx_T>(sprites.size()) } );
+		sprites.push_back( sprite );
+		return true;
+	}
+
+	template<typename T>
+	void AppendBytes( std::vector<std::byte>& out, const T* data, const size_t count )
+	{
+		const auto* bytes = reinterpret_cast<const std::byte*>(data);
+		out.insert( std::end( out ), bytes, bytes + count * sizeof( T ) );
+	}
+
+	// Field by field into a zeroed record, the padding after the flags would otherwise carry whatever was in memory
+	// and cooking the same sheet twice could give different bytes
+	void AppendSprites( std::vector<std::byte>& out, const std::vector<SpriteSheetEntry>& sprites )
+	{
+		for (const auto& sprite : sprites)
+		{
+			SpriteSheetEntry record;
+			std::memset( &record, 0, sizeof( record ) );
+			record.pivot = sprite.pivot;
+			record.uvs = sprite.uvs;
+			record.size = sprite.size;
+			record.rotated = sprite.rotated;
+			record.trimmed = sprite.trimmed;
+			record.assetIdOffset = sprite.assetIdOffset;
+			record.assetIdLength = sprite.assetIdLength;
+			AppendBytes( out, &record, 1 );
+		}
+	}
+
+	std::vector<std::byte> WriteCooked( StringView texture_asset_id, const std::vector<SpriteSheetEntry>& sprites, const std::vector<SpriteSheet::SpriteId>& ids, StringView asset_ids )
+	{
+		AV_ASSERT( sprites.size() == ids.size() );
+
+		const CookedHeader header
+		{
+			.magic = CookedMagic,
+			.version = CookedVersion,
+			.sprite_count = static_cast<uint32_t>(sprites.size()),
+			.asset_ids_size = static_cast<uint32_t>(asset_ids.size()),
+			.texture_asset_id_size = static_cast<uint32_t>(texture_asset_id.size()),
+			.reserved = 0,
+		};
+
+		std::vector<std::byte> out;
+		out.reserve( sizeof( header ) + sprites.size() * (sizeof( SpriteSheetEntry ) + sizeof( SpriteSheet::SpriteId )) + asset_ids.size() + texture_asset_id.size() );
+		AppendBytes( out, &header, 1 );
+		AppendSprites( out, sprites );
+		AppendBytes( out, ids.data(), ids.size() );
+		AppendBytes( out, asset_ids.data(), asset_ids.size() );
+		AppendBytes( out, texture_asset_id.data(), texture_asset_id.size() );
+		return out;
+	}
 }
 
 namespace Avokii::Graphics
@@ -121,12 +251,12 @@ namespace Avokii::Graphics
 	{
 	}
 
-	const std::shared_ptr<const Texture>& SpriteSheet::GetTexture() const noexcept
+	std::shared_ptr<const Texture> SpriteSheet::GetTexture() const noexcept
 	{
-		if (!mpTexture)
-			ReloadTexture( mrManager );
+		if (auto texture = mpTexture.lock(); texture && (mTextureGeneration == mrManager.GetGeneration()))
+			return texture;
 
-		return mpTexture;
+		return ReloadTexture( mrManager );
 	}
 
 	const SpriteSheetEntry& SpriteSheet::GetSpriteByAssetId( StringView asset_id ) const
@@ -144,6 +274,12 @@ namespace Avokii::Graphics
 		return mSprites.at( idx );
 	}
 
+	StringView SpriteSheet::GetSpriteAssetId( SpriteIdx_T idx ) const
+	{
+		const auto& sprite = mSprites.at( idx );
+		return StringView{ mAssetIds }.substr( sprite.assetIdOffset, sprite.assetIdLength );
+	}
+
 	size_t SpriteSheet::GetNumSprites() const noexcept
 	{
 		return std::size( mSprites );
@@ -156,8 +292,8 @@ namespace Avokii::Graphics
 
 	SpriteSheet::SpriteIdx_T SpriteSheet::GetSpriteIndexByResourceId( ResourceId resource_id ) const
 	{
-		if (const auto found = mSpriteIdxMapping.find( resource_id ); found != std::end( mSpriteIdxMapping ))
-			return found->second;
+		if (const auto* found = FindSpriteId( mSpriteIds, resource_id ))
+			return found->index;
 
 		AV_LOG_ERROR( LoggingChannels::Resource, "SpriteSheet does not contain sprite with resource id '{}'", resource_id );
 		return static_cast<SpriteIdx_T>(-1);
@@ -165,63 +301,145 @@ namespace Avokii::Graphics
 
 	bool SpriteSheet::HasSprite( StringView asset_id ) const noexcept
 	{
-		return mSpriteIdxMapping.contains( ToResourceId( asset_id ) );
+		return HasSprite( ToResourceId( asset_id ) );
 	}
 
 	bool SpriteSheet::HasSprite( ResourceId resource_id ) const noexcept
 	{
-		return mSpriteIdxMapping.contains( resource_id );
+		return FindSpriteId( mSpriteIds, resource_id ) != nullptr;
 	}
 
 	bool SpriteSheet::LoadFromJson( StringView json_string, const Filepath& filepath_prefix )
 	{
-		AV_ASSERT( std::filesystem::is_directory( filepath_prefix ) );
-		auto j = nlohmann::json::parse( json_string );
-		bool handled = false;
+		const auto cooked = CookJson( json_string, filepath_prefix );
+		return !cooked.empty() && LoadFromCooked( cooked );
+	}
 
-		Filepath texture_filename;
-		std::vector<SpriteSheetEntry> entries;
-		try
+	bool SpriteSheet::LoadFromCooked( std::span<const std::byte> data )
+	{
+		const auto fail = []( std::string_view reason )
 		{
-			if (j.contains( "frames" ) && j.contains( "meta" ) && j["meta"]["app"].is_string() && j["meta"]["app"].get<std::string>() == "http://free-tex-packer.com")
-				handled = ParseFreeTexPackerSpritesheetJson( j, filepath_prefix, entries, texture_filename );
-		}
-		catch (nlohmann::json::exception& e)
+			AV_LOG_ERROR( LoggingChannels::Resource, "Invalid cooked spritesheet: {}", reason );
+			return false;
+		};
+
+		if (!IsCooked( data ))
+			return fail( "bad magic" );
+
+		CookedHeader header;
+		std::memcpy( &header, data.data(), sizeof( header ) );
+		if (header.version != CookedVersion)
+			return fail( "unsupported version" );
+
+		const size_t n_sprites = header.sprite_count;
+		const size_t sprites_size = n_sprites * sizeof( SpriteSheetEntry );
+		const size_t ids_size = n_sprites * sizeof( SpriteId );
+		if (data.size() != sizeof( header ) + sprites_size + ids_size + header.asset_ids_size + header.texture_asset_id_size)
+			return fail( "size doesn't match the header" );
+
+		// read into locals so a bad sheet leaves this one untouched
+		auto cursor = data.subspan( sizeof( header ) );
+		std::vector<SpriteSheetEntry> sprites( n_sprites );
+		std::memcpy( sprites.data(), cursor.data(), sprites_size );
+		cursor = cursor.subspan( sprites_size );
+
+		std::vector<SpriteId> ids( n_sprites );
+		std::memcpy( ids.data(), cursor.data(), ids_size );
+		cursor = cursor.subspan( ids_size );
+
+		const auto* chars = reinterpret_cast<const char*>(cursor.data());
+		String asset_ids{ chars, header.asset_ids_size };
+		String texture_asset_id{ chars + header.asset_ids_size, header.texture_asset_id_size };
+
+		for (const auto& sprite : sprites)
 		{
-			AV_LOG_ERROR( LoggingChannels::Resource, "Exception while parsing spritesheet json: '{}'", e.what() );
-			handled = false;
+			if (static_cast<size_t>(sprite.assetIdOffset) + sprite.assetIdLength > asset_ids.size())
+				return fail( "sprite asset id out of bounds" );
 		}
-		catch (std::runtime_error& e)
+		for (size_t i = 0; i < ids.size(); ++i)
 		{
-			AV_LOG_ERROR( LoggingChannels::Resource, "Exception while parsing spritesheet:'{}'", e.what() );
-			handled = false;
+			if ((ids[i].index >= n_sprites) || ((i > 0) && (ids[i - 1].resourceId >= ids[i].resourceId)))
+				return fail( "sprite id table is out of order" );
 		}
 
-		mTextureAssetId = Filepath{ texture_filename }.lexically_normal().generic_string();
+		mSprites = std::move( sprites );
+		mSpriteIds = std::move( ids );
+		mAssetIds = std::move( asset_ids );
+		mTextureAssetId = std::move( texture_asset_id );
 		AV_ASSERT( !mTextureAssetId.empty() );
-		for (auto& entry : entries)
-			AddSprite( entry.assetId, entry );
+		if (!mpTexture.expired())
+			ReloadTexture( mrManager );
 
-		return handled;
+		return true;
 	}
 
 	void SpriteSheet::SetTextureId( StringView textureId )
 	{
 		mTextureAssetId = textureId;
-		if (mpTexture)
+		if (!mpTexture.expired())
 			ReloadTexture( mrManager );
 	}
 
-	void SpriteSheet::AddSprite( StringView asset_id, const SpriteSheetEntry& sprite )
+	void SpriteSheet::AddSprite( StringView asset_id, SpriteSheetEntry sprite )
+	{
+		InsertSprite( mSprites, mSpriteIds, mAssetIds, asset_id, sprite );
+	}
+
+	std::vector<std::byte> SpriteSheet::Cook() const
 	{
-		return AddSprite( ToResourceId( asset_id ), sprite );
+		return WriteCooked( mTextureAssetId, mSprites, mSpriteIds, mAssetIds );
 	}
 
-	void SpriteSheet::AddSprite( ResourceId resource_id, const SpriteSheetEntry& sprite )
+	std::vector<std::byte> SpriteSheet::CookJson( StringView json_string, const Filepath& filepath_prefix )
 	{
-		const auto [it, success] = mSpriteIdxMapping.try_emplace( resource_id, static_cast<SpriteIdx_T>(mSprites.size()) );
-		if (success)
-			mSprites.push_back( sprite );
+		ParsedSprites parsed;
+		Filepath texture_filename;
+		if (!ParseSpritesheetJson( json_string, filepath_prefix, parsed, texture_filename ))
+			return {};
+
+		std::vector<SpriteSheetEntry> sprites;
+		std::vector<SpriteId> ids;
+		String asset_ids;
+		sprites.reserve( parsed.size() );
+		ids.reserve( parsed.size() );
+		for (const auto& [asset_id, sprite] : parsed)
+			InsertSprite( sprites, ids, asset_ids, asset_id, sprite );
+
+		return WriteCooked( texture_filename.lexically_normal().generic_string(), sprites, ids, asset_ids );
+	}
+
+	bool SpriteSheet::CookJsonFile( const Filepath& json_filepath, const Filepath& output_filepath )
+	{
+		String json_string;
+		if (!FileOps::ReadFile( json_filepath, json_string ))
+		{
+			AV_LOG_ERROR( LoggingChannels::Resource, "Failed to read spritesheet '{}' for cooking", json_filepath.generic_string() );
+			return false;
+		}
+
+		const auto cooked = CookJson( json_string, FileOps::GetFileDirectory( json_filepath ) );
+		if (cooked.empty())
+			return false;
+
+		std::ofstream out( output_filepath, std::ios::binary | std::ios::trunc );
+		out.write( reinterpret_cast<const char*>(cooked.data()), static_cast<std::streamsize>(cooked.size()) );
+		if (!out)
+		{
+			AV_LOG_ERROR( LoggingChannels::Resource, "Failed to write cooked spritesheet '{}'", output_filepath.generic_string() );
+			return false;
+		}
+
+		return true;
+	}
+
+	bool SpriteSheet::IsCooked( std::span<const std::byte> data ) noexcept
+	{
+		uint32_t magic = 0;
+		if (data.size() < sizeof( CookedHeader ))
+			return false;
+
+		std::memcpy( &magic, data.data(), sizeof( magic ) );
+		return magic == CookedMagic;
 	}
 
 	void SpriteSheet::LoadSprites() const noexcept
@@ -229,31 +447,177 @@ namespace Avokii::Graphics
 		if (mSpritesLoadedIntoManager)
 			return;
 
-		for (auto& entry : mSprites)
-			mrManager.Load<Sprite>( entry.assetId );
+		// sprites reference their sheet, so it has to be the cached one
+		const auto self = mrManager.Get<SpriteSheet>( GetResourceId() );
+		if (self.get() != this)
+		{
+			AV_LOG_ERROR( LoggingChannels::Resource, "Can't load the sprites of a spritesheet that isn't in the resource manager" );
+			return;
+		}
+
+		std::vector<BaseResourceCache::NewResource> sprites;
+		sprites.reserve( mSprites.size() );
+		for (SpriteIdx_T idx = 0; idx < mSprites.size(); ++idx)
+			sprites.push_back( BaseResourceCache::NewResource{ GetSpriteAssetId( idx ), std::make_shared<Sprite>( self, idx ) } );
+
+		mrManager.AddResources<Sprite>( sprites );
 
 		mSpritesLoadedIntoManager = true;
 	}
 
+	ResourceFootprint SpriteSheet::GetFootprint() const noexcept
+	{
+		// the texture is its own resource and counted by its own cache
+		const size_t bytes = mSprites.capacity() * sizeof( SpriteSheetEntry ) + mSpriteIds.capacity() * sizeof( SpriteId ) + mAssetIds.capacity();
+		return ResourceFootprint{ .cpu_bytes = bytes };
+	}
+
+	bool SpriteSheet::ReloadFrom( SpriteSheet& replacement )
+	{
+		std::swap( mSprites, replacement.mSprites );
+		std::swap( mSpriteIds, replacement.mSpriteIds );
+		std::swap( mAssetIds, replacement.mAssetIds );
+		if (mTextureAssetId != replacement.mTextureAssetId)
+		{
+			std::swap( mTextureAssetId, replacement.mTextureAssetId );
+			mpTexture.reset();
+		}
+
+		// replacement now holds the old sprites, sprites that weren't cached are found through the index when loaded
+		if (!mrManager.IsInitialised<Sprite>())
+			return true;
+
+		for (const auto& old_id : replacement.GetSprites())
+		{
+			const ResourceId resource_id = ToResourceId( replacement.GetSpriteAssetId( old_id.index ) );
+			const auto sprite = mrManager.Get<Sprite>( resource_id );
+			if (!sprite || (sprite->mpParentSpriteSheet.get() != this))
+				continue;
+
+			// only this sheet hands out its sprites, and they're only read on the main thread
+			const_cast<Sprite&>(*sprite).mIndex = HasSprite( resource_id ) ? GetSpriteIndexByResourceId( resource_id ) : static_cast<SpriteIdx_T>(-1);
+		}
+
+		return true;
+	}
+
 	std::shared_ptr<SpriteSheet> SpriteSheet::LoadResource( ResourceLoader& loader )
+	{
+		return DecodeResource( loader );
+	}
+
+	SpriteSheet::DecodedData SpriteSheet::DecodeResource( ResourceLoader& loader )
 	{
 		using namespace StringLiterals;
 
 		auto sheet = std::make_shared<SpriteSheet>( loader.GetManager() );
 		
-		const Filepath filepath{ loader.GetAssetId() };
-		String file_contents;
-		if (FileOps::ReadFile( filepath, file_contents ))
-			sheet->LoadFromJson( file_contents, FileOps::GetFileDirectory( filepath ) );
-		else
+		const auto file_data = loader.GetData();
+		bool loaded = false;
+		if (file_data && IsCooked( *file_data ))
+			loaded = sheet->LoadFromCooked( *file_data );
+		else if (file_data)
+			loaded = sheet->LoadFromJson( StringView{ reinterpret_cast<const char*>(file_data->data()), file_data->size() }, FileOps::GetFileDirectory( Filepath{ loader.GetAssetId() } ) );
+
+		if (!loaded)
 			throw std::runtime_error( "Failed to load spritesheet '"s + std::string( loader.GetAssetId() ) + "'"s );
 
 		return sheet;
 	}
 
-	void SpriteSheet::ReloadTexture( ResourceManager& manager ) const
+	std::shared_ptr<SpriteSheet> SpriteSheet::FinaliseResource( ResourceLoader& loader, DecodedData&& data )
+	{
+		if (data && !data->mTextureAssetId.empty())
+			loader.GetManager().LoadAsync<Texture>( data->mTextureAssetId );
+
+		return std::move( data );
+	}
+
+	std::shared_ptr<const Texture> SpriteSheet::ReloadTexture( ResourceManager& manager ) const
+	{
+		auto texture = manager.GetOrLoad<Texture>( mTextureAssetId );
+		mpTexture = texture;
+		mTextureGeneration = manager.GetGeneration();
+		return texture;
+	}
+
+	std::vector<ResourceId> SpriteSheet::GetSpriteResourceIds() const
 	{
-		mpTexture = manager.GetOrLoad<Texture>( mTextureAssetId );
+		std::vector<ResourceId> ids;
+		ids.reserve( mSprites.size() );
+		for (SpriteIdx_T idx = 0; idx < mSprites.size(); ++idx)
+			ids.push_back( ToResourceId( GetSpriteAssetId( idx ) ) );
+		return ids;
+	}
+
+	ResourceDependents SpriteSheet::GetUnreferencedDependents() const
+	{
+		if (!mrManager.IsInitialised<Sprite>())
+			return {};
+
+		// a sprite with the same id can come from another sheet
+		return mrManager.GetCache<Sprite>().CountUnreferenced( GetSpriteResourceIds(), [this]( const BaseResource& sprite )
+			{
+				return static_cast<const Sprite&>(sprite).mpParentSpriteSheet.get() == this;
+			} );
+	}
+
+	void SpriteSheet::UncacheDependents() const
+	{
+		if (!mrManager.IsInitialised<Sprite>())
+			return;
+
+		mrManager.EvictUnreferenced<Sprite>( GetSpriteResourceIds(), [this]( const BaseResource& sprite )
+			{
+				return static_cast<const Sprite&>(sprite).mpParentSpriteSheet.get() == this;
+			} );
+		// if the sheet stays cached its sprites are loaded from it again by Sprite::LoadResource()
+		mSpritesLoadedIntoManager = false;
+	}
+
+
+	///
+	/// SpriteIndex
+	///
+
+	std::optional<SpriteIndex::Location> SpriteIndex::Find( ResourceId sprite_id ) const
+	{
+		std::shared_lock lock( mMutex );
+		if (const auto found = mSprites.find( sprite_id.value() ); found != std::end( mSprites ))
+		{
+			if (auto sheet = found->second.sheet.lock())
+				return Location{ std::move( sheet ), found->second.index };
+		}
+
+		return std::nullopt;
+	}
+
+	size_t SpriteIndex::GetNumSprites() const
+	{
+		std::shared_lock lock( mMutex );
+		return mSprites.size();
+	}
+
+	void SpriteIndex::OnAdded( const std::shared_ptr<const SpriteSheet>& sheet )
+	{
+		std::unique_lock lock( mMutex );
+		mSprites.reserve( mSprites.size() + sheet->GetNumSprites() );
+		for (const auto& [resource_id, idx] : sheet->GetSprites())
+		{
+			const auto [it, success] = mSprites.try_emplace( resource_id, Entry{ sheet.get(), sheet, idx } );
+			if (!success)
+				AV_LOG_WARN( LoggingChannels::Resource, "Sprite '{}' of spritesheet '{}' is already in another spritesheet", sheet->GetSpriteAssetId( idx ), sheet->GetAssetId() );
+		}
+	}
+
+	void SpriteIndex::OnErased( const SpriteSheet& sheet )
+	{
+		std::unique_lock lock( mMutex );
+		for (const auto& [resource_id, idx] : sheet.GetSprites())
+		{
+			if (const auto found = mSprites.find( resource_id ); (found != std::end( mSprites )) && (found->second.owner == &sheet))
+				mSprites.erase( found );
+		}
 	}
 
 
@@ -262,7 +626,7 @@ namespace Avokii::Graphics
 	/// 
 
 	Sprite::Sprite( std::shared_ptr<const SpriteSheet> parent, SpriteSheet::SpriteIdx_T idx )
-		: mpParentSpriteSheet{ parent }
+		: mpParentSpriteSheet{ std::move( parent ) }
 		, mIndex{ idx }
 	{
 	}
@@ -282,21 +646,19 @@ namespace Avokii::Graphics
 
 	std::shared_ptr<const SpriteSheet> Sprite::GetSpriteSheet() const
 	{
-		return mpParentSpriteSheet.lock();
+		return mpParentSpriteSheet;
 	}
 
-	std::shared_ptr<Sprite> Sprite::LoadResource( ResourceLoader& loader )
+	ResourceFootprint Sprite::GetFootprint() const noexcept
 	{
-		auto& manager = loader.GetManager();
-		auto& spritesheets = manager.GetCache<SpriteSheet>();
-		const auto the_sheet = spritesheets.FindIf( [&loader]( const SpriteSheet& entry ) -> bool
-			{
-				return entry.HasSprite( loader.GetAssetId() );
-			} );
-
+		return ResourceFootprint{ .cpu_bytes = sizeof( Sprite ) + GetAssetId().size() };
+	}
 
-		if (the_sheet)
-			return std::make_shared<Sprite>( the_sheet, the_sheet->GetSpriteIndexByAssetId( loader.GetAssetId() ) );
+	std::shared_ptr<Sprite> Sprite::LoadResource( ResourceLoader& loader )
+	{
+		const auto& index = loader.GetManager().GetCache<SpriteSheet>().GetIndex();
+		if (const auto found = index.Find( loader.GetResourceId() ))
+			return std::make_shared<Sprite>( found->sheet, found->index );
 
 		return nullptr;
 	}
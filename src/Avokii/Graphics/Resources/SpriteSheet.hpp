@@ -1,10 +1,14 @@
 #pragma once
 
+#include <optional>
 #include <ranges>
+#include <shared_mutex>
+#include <span>
 
 #include "Avokii/Resources/BaseResource.hpp"
 #include "Avokii/Resources/ResourceTypes.hpp"
 
+#include "Avokii/Containers/FlatHashMap.hpp"
 #include "Avokii/File/Filepath.hpp"
 #include "Avokii/Geometry/Point2D.hpp"
 #include "Avokii/Geometry/Size.hpp"
@@ -18,16 +22,20 @@ namespace Avokii
 	namespace Graphics
 	{
 		class Texture;
+		class SpriteIndex;
 
+		// Plain data so cooked sheets can be copied in directly, the asset id lives in the sheet (SpriteSheet::GetSpriteAssetId())
 		struct SpriteSheetEntry
 		{
-			String assetId;
 			Point2D<float> pivot;
 			Rect<float> uvs;
 			Size<float> size;
 			bool rotated = false;
 			bool trimmed = false;
+			uint32_t assetIdOffset = 0;
+			uint32_t assetIdLength = 0;
 		};
+		static_assert(std::is_trivially_copyable_v<SpriteSheetEntry>);
 
 		class SpriteSheet final
 			: public BaseResource
@@ -35,12 +43,21 @@ namespace Avokii
 		public:
 			using SpriteIdx_T = uint32_t;
 
+			struct SpriteId
+			{
+				ResourceId::hash_type resourceId;
+				SpriteIdx_T index;
+			};
+
 			SpriteSheet( ResourceManager& rManager );
 
-			const std::shared_ptr<const Texture>& GetTexture() const noexcept;
+			// Loads the texture if it isn't cached, main thread only.
+			// The sheet doesn't keep its texture cached, it's looked up once a generation so the cache sees it used.
+			std::shared_ptr<const Texture> GetTexture() const noexcept;
 			[[nodiscard]] const SpriteSheetEntry& GetSpriteByAssetId( StringView assetId ) const;
 			[[nodiscard]] const SpriteSheetEntry& GetSpriteByResourceId( ResourceId resourceId ) const;
 			[[nodiscard]] const SpriteSheetEntry& GetSpriteBySpriteIndex( SpriteIdx_T idx ) const;
+			[[nodiscard]] StringView GetSpriteAssetId( SpriteIdx_T idx ) const;
 
 			[[nodiscard]] size_t GetNumSprites() const noexcept;
 			[[nodiscard]] SpriteIdx_T GetSpriteIndexByAssetId( StringView assetId ) const;
@@ -48,33 +65,91 @@ namespace Avokii
 			[[nodiscard]] bool HasSprite( StringView assetId ) const noexcept;
 			[[nodiscard]] bool HasSprite( ResourceId resourceId ) const noexcept;
 
-			[[nodiscard]] auto GetSprites() const noexcept { return std::views::all( mSpriteIdxMapping ); }
+			// Sorted by resource id
+			[[nodiscard]] auto GetSprites() const noexcept { return std::views::all( mSpriteIds ); }
 			[[nodiscard]] auto GetSpriteEntries() const noexcept { return std::views::all( mSprites ); }
 
+			// Source format, cooked in memory before loading
 			bool LoadFromJson( StringView json_string, const Filepath& filepath_prefix );
+			bool LoadFromCooked( std::span<const std::byte> data );
 			void SetTextureId( StringView textureAssetId );
-			void AddSprite( StringView assetId, const SpriteSheetEntry& sprite );
-			void AddSprite( ResourceId resourceId, const SpriteSheetEntry& sprite );
+			// The entry's asset id fields are overwritten
+			void AddSprite( StringView assetId, SpriteSheetEntry sprite );
+
+			// Cooked sheets are a header, the entries, the sorted sprite id table then the asset id strings.
+			// They load with a handful of allocations rather than several per sprite, so ship these rather than the JSON.
+			[[nodiscard]] std::vector<std::byte> Cook() const;
+			[[nodiscard]] static std::vector<std::byte> CookJson( StringView json_string, const Filepath& filepath_prefix ); // empty on failure
+			static bool CookJsonFile( const Filepath& json_filepath, const Filepath& output_filepath );
+			[[nodiscard]] static bool IsCooked( std::span<const std::byte> data ) noexcept;
 
-			// Load the contained sprites into the resource manager
+			// Add the contained sprites to the resource manager in one go, the sheet has to be in the resource manager
 			void LoadSprites() const noexcept;
 
+			virtual ResourceFootprint GetFootprint() const noexcept override;
+
+			// Cached sprites of this sheet that nothing else references, so the sheet is evicted along with them (Concepts::CompositeResource)
+			[[nodiscard]] ResourceDependents GetUnreferencedDependents() const;
+			void UncacheDependents() const;
+
+			// Hot reloading, takes the replacement's sprites. Cached Sprites are moved to their new index, removed ones are left invalid.
+			bool ReloadFrom( SpriteSheet& replacement );
+
 			static constexpr AssetType GetResourceType() noexcept { return AssetType::SpriteSheet; }
 			static std::shared_ptr<SpriteSheet> LoadResource( ResourceLoader& loader );
 
+			using CacheIndex = SpriteIndex;
+
+			// Asynchronous loading, the JSON is parsed on a worker and the texture starts loading once the sheet is added
+			using DecodedData = std::shared_ptr<SpriteSheet>;
+			static DecodedData DecodeResource( ResourceLoader& loader );
+			static std::shared_ptr<SpriteSheet> FinaliseResource( ResourceLoader& loader, DecodedData&& data );
+
 		private:
-			void ReloadTexture( ResourceManager& manager ) const;
+			std::shared_ptr<const Texture> ReloadTexture( ResourceManager& manager ) const;
+			[[nodiscard]] std::vector<ResourceId> GetSpriteResourceIds() const;
 
 		private:
 			ResourceManager& mrManager;
 
 			String mTextureAssetId;
-			mutable std::shared_ptr<const Texture> mpTexture;
+			mutable std::weak_ptr<const Texture> mpTexture;
+			mutable size_t mTextureGeneration{ 0 }; // ResourceManager generation the texture was last looked up in
 			std::vector<SpriteSheetEntry> mSprites;
-			std::unordered_map<ResourceId, SpriteIdx_T> mSpriteIdxMapping;
+			std::vector<SpriteId> mSpriteIds; // sorted by resource id
+			String mAssetIds; // every sprite's asset id, back to back
 			mutable bool mSpritesLoadedIntoManager{ false };
 		};
 
+		// Which cached sheet each sprite id belongs to, kept up to date by the SpriteSheet cache.
+		// If two cached sheets contain the same sprite id the first one cached owns it.
+		class SpriteIndex final
+		{
+		public:
+			struct Location
+			{
+				std::shared_ptr<const SpriteSheet> sheet;
+				SpriteSheet::SpriteIdx_T index;
+			};
+
+			[[nodiscard]] std::optional<Location> Find( ResourceId sprite_id ) const;
+			[[nodiscard]] size_t GetNumSprites() const;
+
+			void OnAdded( const std::shared_ptr<const SpriteSheet>& sheet );
+			void OnErased( const SpriteSheet& sheet );
+
+		private:
+			struct Entry
+			{
+				const SpriteSheet* owner; // compared against while the sheet is being erased
+				std::weak_ptr<const SpriteSheet> sheet;
+				SpriteSheet::SpriteIdx_T index;
+			};
+
+			mutable std::shared_mutex mMutex;
+			FlatHashMap<ResourceId::hash_type, Entry> mSprites;
+		};
+
 		class Sprite final
 			: public BaseResource
 		{
@@ -85,11 +160,17 @@ namespace Avokii
 			SpriteSheet::SpriteIdx_T GetIndex() const noexcept;
 			std::shared_ptr<const SpriteSheet> GetSpriteSheet() const;
 
+			virtual ResourceFootprint GetFootprint() const noexcept override;
+
 			static constexpr AssetType GetResourceType() noexcept { return AssetType::Sprite; }
 			static std::shared_ptr<Sprite> LoadResource( ResourceLoader& loader );
 
 		private:
-			std::weak_ptr<const SpriteSheet> mpParentSpriteSheet;
+			friend class SpriteSheet; // remaps the index on reload
+
+			// keeps the sheet referenced, so it isn't evicted while its sprites are in use. Cached sprites nothing else uses
+			// are evicted along with it instead (SpriteSheet::GetUnreferencedDependents()).
+			std::shared_ptr<const SpriteSheet> mpParentSpriteSheet;
 			SpriteSheet::SpriteIdx_T mIndex{ static_cast<SpriteSheet::SpriteIdx_T>(-1) };
 		};
 	}
@@ -5,8 +5,23 @@
 #include "Avokii/Resources/ResourceManager.hpp"
 #include "Avokii/Resources/ResourceLoader.hpp"
 
+#include <stb_image/stb_image.h>
+
 namespace Avokii::Graphics
 {
+	ResourceFootprint Texture::GetFootprint() const noexcept
+	{
+		uint32_t bytes_per_pixel = 4;
+		switch (GetFormat())
+		{
+		case TextureFormat::RGBA8: bytes_per_pixel = 4; break;
+		case TextureFormat::RGB8: bytes_per_pixel = 3; break;
+		case TextureFormat::R8: bytes_per_pixel = 1; break;
+		}
+
+		return ResourceFootprint{ .gpu_bytes = static_cast<size_t>( GetSize().width ) * GetSize().height * bytes_per_pixel };
+	}
+
 	std::shared_ptr<Texture> Texture::LoadResource( ResourceLoader& loader )
 	{
 		std::shared_ptr<Texture> texture;
@@ -14,6 +29,10 @@ namespace Avokii::Graphics
 		auto& core = loader.GetManager().GetCore();
 		auto& video = core.GetRequiredAPI<API::VideoAPI>();
 
+		// packed textures are decoded from the archive's mapping
+		if (loader.GetManager().FindArchivedAsset( loader.GetAssetId() ))
+			return FinaliseResource( loader, DecodeResource( loader ) );
+
 		Filepath filepath{ loader.GetAssetId() };
 
 		// TODO: some way of storing/fetching metadata
@@ -26,4 +45,48 @@ namespace Avokii::Graphics
 			}
 		);
 	}
+
+	Texture::DecodedData Texture::DecodeResource( ResourceLoader& loader )
+	{
+		using namespace StringLiterals;
+
+		const auto file_data = loader.GetData();
+		if (!file_data)
+			throw std::runtime_error( "Failed to read image '"s + String{ loader.GetAssetId() } + "'"s );
+
+		// stb_image's flip setting is global, nothing sets it so it stays off (see TextureOpenGL)
+		int out_w, out_h, out_channels;
+		if (!stbi_info_from_memory( reinterpret_cast<const stbi_uc*>(file_data->data()), static_cast<int>( file_data->size() ), &out_w, &out_h, &out_channels ))
+			throw std::runtime_error( "Failed to decode image '"s + String{ loader.GetAssetId() } + "'"s );
+
+		// the same formats LoadResource() gives, grey with alpha has no match so it's widened
+		DecodedData data;
+		int channels = 4;
+		switch (out_channels)
+		{
+		case 3: data.format = TextureFormat::RGB8; channels = 3; break;
+		case 1: data.format = TextureFormat::R8; channels = 1; break;
+		default: data.format = TextureFormat::RGBA8; channels = 4; break;
+		}
+
+		auto* p_data = stbi_load_from_memory( reinterpret_cast<const stbi_uc*>(file_data->data()), static_cast<int>( file_data->size() ), &out_w, &out_h, &out_channels, channels );
+		if (!p_data)
+			throw std::runtime_error( "Failed to decode image '"s + String{ loader.GetAssetId() } + "'"s );
+
+		data.size = Size( (uint32_t)out_w, (uint32_t)out_h );
+		data.pixels.assign( p_data, p_data + static_cast<size_t>( out_w ) * out_h * channels );
+		stbi_image_free( p_data );
+
+		return data;
+	}
+
+	std::shared_ptr<Texture> Texture::FinaliseResource( ResourceLoader& loader, DecodedData&& data )
+	{
+		auto& core = loader.GetManager().GetCore();
+		auto& video = core.GetRequiredAPI<API::VideoAPI>();
+
+		auto texture = video.CreateTexture( TextureDefinition{ .size = data.size, .format = data.format } );
+		texture->SetData( data.pixels.data(), static_cast<uint32_t>( data.pixels.size() ) );
+		return texture;
+	}
 }
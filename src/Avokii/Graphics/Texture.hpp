@@ -18,9 +18,17 @@ namespace Avokii::Graphics
 		MirroredRepeat,
 	};
 
+	enum class TextureFormat
+	{
+		RGBA8,
+		RGB8,
+		R8,
+	};
+
 	struct TextureDefinition
 	{
 		Size<uint32_t> size;
+		TextureFormat format = TextureFormat::RGBA8;
 		TextureWrapSetting wrap_s = TextureWrapSetting::Repeat;
 		TextureWrapSetting wrap_t = TextureWrapSetting::Repeat;
 	};
@@ -41,7 +49,19 @@ namespace Avokii::Graphics
 		static constexpr AssetType GetResourceType() noexcept { return AssetType::Texture; }
 		static std::shared_ptr<Texture> LoadResource( ResourceLoader& loader );
 
+		// Asynchronous loading, the image is decoded on a worker and uploaded on the main thread.
+		// The decoded format follows the source's channel count, R8 for one, RGB8 for three and RGBA8 otherwise.
+		struct DecodedData
+		{
+			Size<uint32_t> size;
+			TextureFormat format;
+			std::vector<unsigned char> pixels;
+		};
+		static DecodedData DecodeResource( ResourceLoader& loader );
+		static std::shared_ptr<Texture> FinaliseResource( ResourceLoader& loader, DecodedData&& data );
+
 		virtual const Size<uint32_t>& GetSize() const noexcept = 0;
+		virtual TextureFormat GetFormat() const noexcept = 0;
 
 		virtual void SetData( void* data, uint32_t size ) = 0;
 
@@ -50,5 +70,49 @@ namespace Avokii::Graphics
 		virtual bool operator==( const Texture& other ) const = 0;
 
 		virtual uint32_t GetNativeId() const noexcept = 0;
+
+		virtual ResourceFootprint GetFootprint() const noexcept override;
+
+		// Hot reloading, takes over the replacement's device texture and leaves it with the old one to release
+		bool ReloadFrom( Texture& replacement )
+		{
+			if (!SwapContents( replacement ))
+				return false;
+
+			++mContentVersion;
+			return true;
+		}
+		// Changes whenever the texture is reloaded, for anything holding a copy of its pixels (e.g. SpriteBatcher's texture array)
+		[[nodiscard]] uint32_t GetContentVersion() const noexcept { return mContentVersion; }
+
+	protected:
+		virtual bool SwapContents( Texture& other ) noexcept { (void)other; return false; }
+
+	private:
+		uint32_t mContentVersion = 0;
+	};
+
+	struct TextureArrayDefinition
+	{
+		Size<uint32_t> size;
+		uint32_t layers = 1;
+	};
+
+	// RGBA8 2D texture array, layers are filled by copying from existing textures on the device
+	class TextureArray
+	{
+	public:
+		virtual ~TextureArray() = default;
+
+		virtual const Size<uint32_t>& GetSize() const noexcept = 0;
+		virtual uint32_t GetLayerCount() const noexcept = 0;
+
+		// Copies `source` into the top left of `layer`, the source must be RGBA8 and no larger than the array
+		virtual void CopyLayerFrom( uint32_t layer, const Texture& source ) = 0;
+		virtual void ClearLayer( uint32_t layer ) = 0;
+
+		virtual void Bind( uint32_t slot ) const = 0;
+
+		virtual uint32_t GetNativeId() const noexcept = 0;
 	};
 }
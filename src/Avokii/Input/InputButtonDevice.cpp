@@ -93,6 +93,22 @@ namespace Avokii::Input
 			button_pressed[code] = button_pressed_repeat[code] = true;
 	}
 
+	uint8_t InputButtonDevice::GetButtonState( ButtonCode_T code ) const
+	{
+		return static_cast<uint8_t>( (button_pressed.at( code ) ? Pressed : 0)
+			| (button_pressed_repeat.at( code ) ? PressedRepeat : 0)
+			| (button_released.at( code ) ? Released : 0)
+			| (button_down.at( code ) ? Down : 0) );
+	}
+
+	void InputButtonDevice::SetButtonState( ButtonCode_T code, const uint8_t state )
+	{
+		button_pressed.at( code ) = (state & Pressed) != 0;
+		button_pressed_repeat.at( code ) = (state & PressedRepeat) != 0;
+		button_released.at( code ) = (state & Released) != 0;
+		button_down.at( code ) = (state & Down) != 0;
+	}
+
 	void InputButtonDevice::Init( size_t num_buttons )
 	{
 		button_pressed.resize( num_buttons );
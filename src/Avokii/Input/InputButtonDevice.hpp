@@ -39,6 +39,17 @@ namespace Avokii::Input
 		/// </summary>
 		void OnPolledButtonStatus( ButtonCode_T code, bool is_down );
 
+		// A button's pressed, repeat, released and down flags packed together, for recording and replaying input
+		enum ButtonStateFlags : uint8_t
+		{
+			Pressed = 1 << 0,
+			PressedRepeat = 1 << 1,
+			Released = 1 << 2,
+			Down = 1 << 3,
+		};
+		uint8_t GetButtonState( ButtonCode_T code ) const;
+		void SetButtonState( ButtonCode_T code, uint8_t state );
+
 	protected:
 		std::vector<uint8_t> button_pressed;
 		std::vector<uint8_t> button_pressed_repeat;
@@ -0,0 +1,255 @@
+#include "InputRecording.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include "Avokii/API/InputAPI.hpp"
+#include "Avokii/File/FileOps.hpp"
+#include "Avokii/Input/GamepadInput.hpp"
+#include "Avokii/Input/KeyboardInput.hpp"
+
+namespace Avokii::Input
+{
+	namespace
+	{
+		// keyboards first, then gamepads
+		template<class Func>
+		void ForEachDevice( const API::InputAPI& input, Func&& func )
+		{
+			uint64_t device_idx = 0;
+			for (size_t i = 0; i < input.GetKeyboardCount(); ++i)
+				func( device_idx++, *input.GetKeyboard( i ) );
+			for (size_t i = 0; i < input.GetGamepadCount(); ++i)
+				func( device_idx++, *input.GetGamepad( i ) );
+		}
+
+		void WriteVarint( std::vector<uint8_t>& out, uint64_t value )
+		{
+			while (value >= 0x80)
+			{
+				out.push_back( static_cast<uint8_t>( value | 0x80 ) );
+				value >>= 7;
+			}
+			out.push_back( static_cast<uint8_t>( value ) );
+		}
+
+		std::optional<uint64_t> ReadVarint( const std::vector<std::byte>& data, size_t& position )
+		{
+			uint64_t value = 0;
+			for (unsigned shift = 0; (shift < 64) && (position < data.size()); shift += 7)
+			{
+				const auto byte = static_cast<uint8_t>( data[position++] );
+				value |= static_cast<uint64_t>( byte & 0x7f ) << shift;
+				if ((byte & 0x80) == 0)
+					return value;
+			}
+			return std::nullopt;
+		}
+	}
+
+	InputRecorder::InputRecorder( const Filepath& filepath, std::chrono::nanoseconds step_length )
+		: mFilepath{ filepath }
+		, mStepLength{ step_length }
+		, mOut{ filepath, std::ios::binary | std::ios::trunc }
+	{
+		if (!mOut)
+		{
+			AV_LOG_ERROR( LoggingChannels::Application, "Failed to open '{}' to write the input recording", mFilepath.generic_string() );
+			return;
+		}
+
+		// the frame count is filled in by Finish()
+		InputRecordingFormat::Header header{};
+		header.magic = InputRecordingFormat::Magic;
+		header.version = InputRecordingFormat::Version;
+		header.frame_count = 0;
+		header.step_length_ns = static_cast<uint64_t>( mStepLength.count() );
+
+		mOut.write( reinterpret_cast<const char*>(&header), sizeof( header ) );
+		mOut.flush();
+		mSize = sizeof( header );
+	}
+
+	InputRecorder::~InputRecorder()
+	{
+		Finish();
+	}
+
+	void InputRecorder::Capture( const API::InputAPI& input, const PreciseTimestep& ts )
+	{
+		if (!IsOpen())
+			return;
+
+		AV_ASSERT( ts.step >= mLastStep );
+		mFrame.clear();
+		WriteVarint( mFrame, ts.step - mLastStep );
+		WriteVarint( mFrame, static_cast<uint64_t>( std::max<int64_t>( 0, std::llround( ts.delta * 1.0e9 ) ) ) );
+		mLastStep = ts.step;
+
+		// (device, button, state) of what changed
+		mChanges.clear();
+		uint64_t n_changes = 0;
+		ForEachDevice( input, [&]( const uint64_t device_idx, const InputButtonDevice& device )
+			{
+				if (mDeviceStates.size() <= device_idx)
+					mDeviceStates.resize( device_idx + 1 );
+
+				auto& states = mDeviceStates[device_idx];
+				states.resize( device.GetButtonCount() );
+				for (size_t button = 0; button < states.size(); ++button)
+				{
+					// pressed and released only last a frame, a replay clears them before applying the changes
+					const uint8_t state = device.GetButtonState( static_cast<ButtonCode_T>( button ) );
+					const uint8_t expected = states[button] & InputButtonDevice::Down;
+					states[button] = state;
+					if (state == expected)
+						continue;
+
+					WriteVarint( mChanges, device_idx );
+					WriteVarint( mChanges, button );
+					mChanges.push_back( state );
+					++n_changes;
+				}
+			} );
+
+		WriteVarint( mFrame, n_changes );
+		mFrame.insert( std::end( mFrame ), std::begin( mChanges ), std::end( mChanges ) );
+
+		// flushed every frame, a few bytes a frame is nothing next to losing the recording of a crash
+		mOut.write( reinterpret_cast<const char*>(mFrame.data()), static_cast<std::streamsize>( mFrame.size() ) );
+		mOut.flush();
+		if (!mOut)
+		{
+			AV_LOG_ERROR( LoggingChannels::Application, "Failed writing the input recording '{}', stopped after {} frames", mFilepath.generic_string(), mNumFrames );
+			mOut.close();
+			return;
+		}
+
+		mSize += mFrame.size();
+		++mNumFrames;
+	}
+
+	bool InputRecorder::Finish()
+	{
+		if (!IsOpen())
+			return false;
+
+		mOut.seekp( offsetof( InputRecordingFormat::Header, frame_count ) );
+		mOut.write( reinterpret_cast<const char*>(&mNumFrames), sizeof( mNumFrames ) );
+		mOut.close();
+		if (!mOut)
+		{
+			AV_LOG_ERROR( LoggingChannels::Application, "Failed to finish the input recording '{}', it will replay to its last whole frame", mFilepath.generic_string() );
+			return false;
+		}
+
+		AV_LOG_INFO( LoggingChannels::Application, "Wrote {} frames of input ({} bytes) to '{}'", mNumFrames, mSize, mFilepath.generic_string() );
+		return true;
+	}
+
+	bool InputReplay::LoadFromFile( const Filepath& filepath )
+	{
+		std::vector<std::byte> contents;
+		if (!FileOps::ReadFile( filepath, contents ))
+		{
+			AV_LOG_ERROR( LoggingChannels::Application, "Failed to read the input recording '{}'", filepath.generic_string() );
+			return false;
+		}
+
+		InputRecordingFormat::Header header{};
+		if (contents.size() < sizeof( header ))
+		{
+			AV_LOG_ERROR( LoggingChannels::Application, "'{}' is too small to be an input recording", filepath.generic_string() );
+			return false;
+		}
+
+		std::memcpy( &header, contents.data(), sizeof( header ) );
+		if ((header.magic != InputRecordingFormat::Magic) || (header.version != InputRecordingFormat::Version))
+		{
+			AV_LOG_ERROR( LoggingChannels::Application, "'{}' isn't a version {} input recording", filepath.generic_string(), InputRecordingFormat::Version );
+			return false;
+		}
+
+		mData = std::move( contents );
+		mPosition = sizeof( header );
+		mNumFrames = header.frame_count;
+		mNextFrame = 0;
+		mStepLength = std::chrono::nanoseconds( header.step_length_ns );
+		mDeviceStates.clear();
+		return true;
+	}
+
+	std::optional<InputReplay::Frame> InputReplay::NextFrame()
+	{
+		if (mPosition >= mData.size())
+		{
+			// an unfinished recording has no frame count
+			if ((mNumFrames != 0) && (mNextFrame != mNumFrames))
+			{
+				AV_LOG_WARN( LoggingChannels::Application, "Input recording has {} frames but its header says {}", mNextFrame, mNumFrames );
+				mNumFrames = mNextFrame;
+			}
+			return std::nullopt;
+		}
+
+		const auto n_steps = ReadVarint( mData, mPosition );
+		const auto delta_ns = ReadVarint( mData, mPosition );
+		const auto n_changes = ReadVarint( mData, mPosition );
+		if (!n_steps || !delta_ns || !n_changes)
+			return EndPartialFrame();
+		if ((*n_steps > InputRecordingFormat::MaxStepsPerFrame) || (*delta_ns > static_cast<uint64_t>( std::chrono::nanoseconds::max().count() )))
+			return EndPartialFrame();
+
+		// pressed and released only last a frame, whether a button is down carries on
+		for (auto& states : mDeviceStates)
+		{
+			for (auto& state : states)
+				state &= InputButtonDevice::Down;
+		}
+
+		for (uint64_t i = 0; i < *n_changes; ++i)
+		{
+			const auto device_idx = ReadVarint( mData, mPosition );
+			const auto button = ReadVarint( mData, mPosition );
+			// bounded so a corrupt log can't ask for huge allocations
+			constexpr uint64_t MaxDevices = 256;
+			constexpr uint64_t MaxButtons = 4096;
+			if (!device_idx || !button || (*device_idx >= MaxDevices) || (*button >= MaxButtons) || (mPosition >= mData.size()))
+				return EndPartialFrame();
+
+			if (mDeviceStates.size() <= *device_idx)
+				mDeviceStates.resize( *device_idx + 1 );
+			auto& states = mDeviceStates[*device_idx];
+			if (states.size() <= *button)
+				states.resize( *button + 1 );
+			states[*button] = static_cast<uint8_t>( mData[mPosition++] );
+		}
+
+		++mNextFrame;
+		return Frame{ static_cast<int>( *n_steps ), std::chrono::nanoseconds( *delta_ns ) };
+	}
+
+	std::nullopt_t InputReplay::EndPartialFrame()
+	{
+		// most likely the last frame of a recording cut short by a crash
+		AV_LOG_WARN( LoggingChannels::Application, "Input recording ends in a partial or malformed frame after {} frames", mNextFrame );
+		mPosition = mData.size();
+		mNumFrames = mNextFrame;
+		return std::nullopt;
+	}
+
+	void InputReplay::Apply( API::InputAPI& input ) const
+	{
+		ForEachDevice( input, [&]( const uint64_t device_idx, InputButtonDevice& device )
+			{
+				const auto* states = (device_idx < mDeviceStates.size()) ? &mDeviceStates[device_idx] : nullptr;
+				for (size_t button = 0; button < device.GetButtonCount(); ++button)
+				{
+					const uint8_t state = (states && (button < states->size())) ? (*states)[button] : 0;
+					device.SetButtonState( static_cast<ButtonCode_T>( button ), state );
+				}
+			} );
+	}
+}
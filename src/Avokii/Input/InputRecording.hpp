@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <optional>
+#include <vector>
+
+#include "Avokii/File/Filepath.hpp"
+#include "Avokii/Timestep.hpp"
+
+namespace Avokii::API { class InputAPI; }
+
+namespace Avokii::Input
+{
+	// Binary log of the button state of every keyboard and gamepad, a frame at a time
+	//
+	// Each frame records the fixed steps it ran and its variable delta, then the buttons whose state changed since the last frame.
+	// Numbers are varints, a frame without any input takes around six bytes. Replaying the log repeats the same steps with the same input,
+	// see CoreProperties::inputReplay.
+	// Only buttons are recorded. Gamepad axes and thumbsticks are read straight from the device (GamepadInput::GetAxisValue()) and
+	// there is no mouse input API, so a game reading either won't replay the same.
+	//
+	// Layout: a Header then the frames, each `steps, delta ns, n changes, n * (device, button, InputButtonDevice::ButtonStateFlags)`.
+	// Devices are numbered keyboards first, then gamepads, in the order InputAPI lists them.
+	// Frames are written as they're captured and the frame count filled in at the end, a count of 0 means the recording
+	// wasn't finished (e.g. the game crashed) and is replayed up to its last whole frame.
+	struct InputRecordingFormat
+	{
+		static constexpr uint32_t Magic = 0x52495641; // "AVIR"
+		static constexpr uint32_t Version = 1;
+		// far more fixed steps than any FixedStepPolicy lets a frame catch up on, a frame with more is corrupt
+		static constexpr uint64_t MaxStepsPerFrame = 1 << 16;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t frame_count;
+			uint64_t step_length_ns; // of the fixed updates it was recorded with
+		};
+		static_assert(sizeof( Header ) == 24);
+	};
+
+	// Streams the recording to a file, each frame is flushed as it's captured so a crash keeps everything up to it
+	class InputRecorder final
+	{
+	public:
+		// Opens and truncates `filepath`, check IsOpen()
+		InputRecorder( const Filepath& filepath, std::chrono::nanoseconds step_length );
+		~InputRecorder();
+
+		InputRecorder( const InputRecorder& ) = delete;
+		InputRecorder& operator=( const InputRecorder& ) = delete;
+
+		[[nodiscard]] bool IsOpen() const noexcept { return mOut.is_open(); }
+
+		// Call once a frame after the input API's events, `ts` is the frame's variable timestep
+		void Capture( const API::InputAPI& input, const PreciseTimestep& ts );
+
+		// Fills in the header's frame count and closes the file, called by the destructor if not before
+		bool Finish();
+
+		[[nodiscard]] uint64_t GetFrameCount() const noexcept { return mNumFrames; }
+		[[nodiscard]] uint64_t GetSize() const noexcept { return mSize; }
+
+	private:
+		const Filepath mFilepath;
+		const std::chrono::nanoseconds mStepLength;
+		std::ofstream mOut;
+		std::vector<std::vector<uint8_t>> mDeviceStates; // as of the last frame captured
+		std::vector<uint8_t> mFrame; // reused for encoding each frame
+		std::vector<uint8_t> mChanges;
+		uint64_t mNumFrames = 0;
+		uint64_t mLastStep = 0;
+		uint64_t mSize = 0;
+	};
+
+	class InputReplay final
+	{
+	public:
+		struct Frame
+		{
+			int n_steps;
+			std::chrono::nanoseconds delta;
+		};
+
+		bool LoadFromFile( const Filepath& filepath );
+
+		[[nodiscard]] std::chrono::nanoseconds GetStepLength() const noexcept { return mStepLength; }
+		// From the header, 0 if the recording wasn't finished
+		[[nodiscard]] uint64_t GetFrameCount() const noexcept { return mNumFrames; }
+
+		// Decodes the next frame, nullopt at the end of the file or a malformed frame.
+		// Reads to the end of the file whatever the header's frame count, which only warns if it disagrees.
+		[[nodiscard]] std::optional<Frame> NextFrame();
+		// Overwrites the devices' button state with the current frame's, call after the input API's events
+		void Apply( API::InputAPI& input ) const;
+
+	private:
+		// Stops the replay at a frame that couldn't be decoded
+		std::nullopt_t EndPartialFrame();
+
+	private:
+		std::vector<std::byte> mData;
+		size_t mPosition = 0;
+		uint64_t mNumFrames = 0;
+		uint64_t mNextFrame = 0;
+		std::chrono::nanoseconds mStepLength{ 0 };
+		std::vector<std::vector<uint8_t>> mDeviceStates;
+	};
+}
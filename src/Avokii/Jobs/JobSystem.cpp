@@ -0,0 +1,302 @@
+#include "JobSystem.hpp"
+
+#include "Avokii/Profiling/Profiler.hpp"
+
+namespace Avokii
+{
+	namespace
+	{
+		struct ThreadSlot
+		{
+			const JobSystem* system = nullptr;
+			int32_t idx = -1;
+		};
+		thread_local ThreadSlot tThreadSlot;
+
+		uint32_t GetDefaultWorkerCount()
+		{
+			const uint32_t hardware_threads = std::thread::hardware_concurrency();
+			return (hardware_threads > 1) ? hardware_threads - 1 : 1u;
+		}
+
+		// spins before sleeping, jobs often come in bursts a frame apart
+		constexpr uint32_t IdleSpins = 64;
+	}
+
+	JobSystem::JobSystem( uint32_t n_workers )
+		: mMainThreadId{ std::this_thread::get_id() }
+		, mpPreviousSystem{ tThreadSlot.system }
+		, mPreviousThreadIdx{ tThreadSlot.idx }
+	{
+		if (n_workers == 0)
+			n_workers = GetDefaultWorkerCount();
+
+		tThreadSlot = ThreadSlot{ this, 0 };
+
+		mDeques.reserve( n_workers + 1 );
+		for (uint32_t i = 0; i <= n_workers; ++i)
+			mDeques.push_back( std::make_unique<Deque_T>() );
+
+		mWorkers.reserve( n_workers );
+		for (uint32_t i = 1; i <= n_workers; ++i)
+			mWorkers.emplace_back( [this, i]() { WorkerMain( i ); } );
+
+		AV_LOG_INFO( LoggingChannels::Application, "Job system started with {} workers", n_workers );
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::scoped_lock lock( mSleepMutex );
+			mStopping.store( true );
+		}
+		mWakeWorkers.notify_all();
+
+		for (auto& worker : mWorkers)
+			worker.join();
+
+		// jobs nobody waited on are dropped
+		for (auto& deque : mDeques)
+		{
+			while (Job* job = deque->Steal())
+				delete job;
+		}
+		for (Job* job : mSharedJobs)
+			delete job;
+		for (Job* job : mMainThreadJobs)
+			delete job;
+		for (Job* job : mWorkerJobs)
+			delete job;
+
+		if (IsMainThread())
+		{
+			AV_ASSERT( tThreadSlot.system == this, "Job systems on the same thread must be destroyed in reverse order" );
+			if (tThreadSlot.system == this)
+				tThreadSlot = ThreadSlot{ mpPreviousSystem, mPreviousThreadIdx };
+		}
+	}
+
+	void JobSystem::Wait( const JobCounter& counter )
+	{
+		const int32_t thread_idx = GetThreadIndex();
+		const bool is_main_thread = (thread_idx == 0);
+
+		while (!counter.IsDone())
+		{
+			if (is_main_thread)
+				ProcessMainThreadJobs();
+
+			if (Job* job = FindJob( thread_idx ))
+				Execute( job );
+			else
+				std::this_thread::yield();
+		}
+
+		std::exception_ptr exception;
+		{
+			std::scoped_lock lock( counter.mExceptionMutex );
+			std::swap( exception, counter.mException );
+		}
+		if (exception)
+			std::rethrow_exception( exception );
+	}
+
+	void JobSystem::ProcessMainThreadJobs()
+	{
+		AV_ASSERT( IsMainThread() );
+
+		std::vector<Job*> jobs;
+		{
+			std::scoped_lock lock( mMainThreadMutex );
+			if (mMainThreadJobs.empty())
+				return;
+
+			jobs.swap( mMainThreadJobs );
+		}
+
+		AV_PROFILE_SCOPE( "Main thread jobs" );
+		for (Job* job : jobs)
+			Execute( job );
+	}
+
+	void JobSystem::Queue( Job* job )
+	{
+		if (job->mpCounter)
+			job->mpCounter->mPending.fetch_add( 1, std::memory_order_relaxed );
+
+		const int32_t thread_idx = GetThreadIndex();
+		if ((thread_idx < 0) || !mDeques[thread_idx]->Push( job ))
+		{
+			std::scoped_lock lock( mSharedMutex );
+			mSharedJobs.push_back( job );
+			mNumSharedJobs.fetch_add( 1, std::memory_order_relaxed );
+		}
+
+		WakeWorker();
+	}
+
+	void JobSystem::QueueOnMainThread( Job* job )
+	{
+		if (job->mpCounter)
+			job->mpCounter->mPending.fetch_add( 1, std::memory_order_relaxed );
+
+		std::scoped_lock lock( mMainThreadMutex );
+		mMainThreadJobs.push_back( job );
+	}
+
+	void JobSystem::QueueOnWorker( Job* job )
+	{
+		if (job->mpCounter)
+			job->mpCounter->mPending.fetch_add( 1, std::memory_order_relaxed );
+
+		{
+			std::scoped_lock lock( mWorkerMutex );
+			mWorkerJobs.push_back( job );
+			mNumWorkerJobs.fetch_add( 1, std::memory_order_relaxed );
+		}
+
+		WakeWorker();
+	}
+
+	void JobSystem::Execute( Job* job )
+	{
+		std::exception_ptr exception;
+		try
+		{
+			job->mInvoke( job->mStorage );
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+
+		// the counter may be destroyed by its waiter as soon as it reaches zero
+		JobCounter* const counter = job->mpCounter;
+		delete job;
+
+		if (exception)
+		{
+			if (counter)
+			{
+				// the first one wins, Wait() rethrows it
+				std::scoped_lock lock( counter->mExceptionMutex );
+				if (!counter->mException)
+					counter->mException = exception;
+			}
+			else
+			{
+				// nothing waits on the job, so there's nowhere to send it
+				try
+				{
+					std::rethrow_exception( exception );
+				}
+				catch (const std::exception& e)
+				{
+					AV_LOG_ERROR( LoggingChannels::Application, "Job without a counter threw: {}", e.what() );
+				}
+				catch (...)
+				{
+					AV_LOG_ERROR( LoggingChannels::Application, "Job without a counter threw an unknown exception" );
+				}
+			}
+		}
+
+		if (counter)
+			counter->mPending.fetch_sub( 1, std::memory_order_acq_rel );
+	}
+
+	Job* JobSystem::FindJob( int32_t thread_idx )
+	{
+		// worker only jobs first, they're queued to start as soon as possible
+		if ((thread_idx > 0) && (mNumWorkerJobs.load( std::memory_order_relaxed ) > 0))
+		{
+			std::scoped_lock lock( mWorkerMutex );
+			if (!mWorkerJobs.empty())
+			{
+				Job* job = mWorkerJobs.front();
+				mWorkerJobs.pop_front();
+				mNumWorkerJobs.fetch_sub( 1, std::memory_order_relaxed );
+				return job;
+			}
+		}
+
+		// threads outside the system have no deque of their own and can only steal
+		if (thread_idx >= 0)
+		{
+			if (Job* job = mDeques[thread_idx]->Pop())
+				return job;
+		}
+
+		if (mNumSharedJobs.load( std::memory_order_relaxed ) > 0)
+		{
+			std::scoped_lock lock( mSharedMutex );
+			if (!mSharedJobs.empty())
+			{
+				Job* job = mSharedJobs.front();
+				mSharedJobs.pop_front();
+				mNumSharedJobs.fetch_sub( 1, std::memory_order_relaxed );
+				return job;
+			}
+		}
+
+		// start with the next thread along so thieves spread out
+		const auto n_deques = static_cast<uint32_t>( mDeques.size() );
+		const uint32_t first = (thread_idx >= 0) ? static_cast<uint32_t>( thread_idx ) + 1 : 0u;
+		for (uint32_t i = 0; i < n_deques; ++i)
+		{
+			const uint32_t victim = (first + i) % n_deques;
+			if (static_cast<int32_t>( victim ) == thread_idx)
+				continue;
+
+			if (Job* job = mDeques[victim]->Steal())
+				return job;
+		}
+
+		return nullptr;
+	}
+
+	void JobSystem::WakeWorker()
+	{
+		mEpoch.fetch_add( 1, std::memory_order_seq_cst );
+		if (mNumSleeping.load( std::memory_order_seq_cst ) > 0)
+		{
+			std::scoped_lock lock( mSleepMutex );
+			mWakeWorkers.notify_one();
+		}
+	}
+
+	void JobSystem::WorkerMain( uint32_t thread_idx )
+	{
+		tThreadSlot = ThreadSlot{ this, static_cast<int32_t>( thread_idx ) };
+
+		uint32_t idle_spins = 0;
+		while (!mStopping.load( std::memory_order_relaxed ))
+		{
+			const uint64_t epoch = mEpoch.load( std::memory_order_seq_cst );
+			if (Job* job = FindJob( static_cast<int32_t>( thread_idx ) ))
+			{
+				idle_spins = 0;
+				AV_PROFILE_SCOPE( "Job" );
+				Execute( job );
+				continue;
+			}
+
+			if (++idle_spins < IdleSpins)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			std::unique_lock lock( mSleepMutex );
+			mNumSleeping.fetch_add( 1, std::memory_order_seq_cst );
+			mWakeWorkers.wait( lock, [&]() { return mStopping.load( std::memory_order_relaxed ) || (mEpoch.load( std::memory_order_seq_cst ) != epoch); } );
+			mNumSleeping.fetch_sub( 1, std::memory_order_relaxed );
+			idle_spins = 0;
+		}
+	}
+
+	int32_t JobSystem::GetThreadIndex() const noexcept
+	{
+		return (tThreadSlot.system == this) ? tThreadSlot.idx : -1;
+	}
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Avokii/Containers/WorkStealingDeque.hpp"
+
+namespace Avokii
+{
+	class JobSystem;
+
+	// Jobs still to finish, for fork-join. Incremented when a job is queued with it and decremented once the job has run.
+	//
+	// A job can queue children on its own counter and wait on that, waiting runs other jobs rather than blocking.
+	// The first exception thrown by a job counted on it is kept and rethrown by JobSystem::Wait().
+	// Must outlive the jobs counted on it.
+	class JobCounter final
+	{
+	public:
+		JobCounter() = default;
+		JobCounter( const JobCounter& ) = delete;
+		JobCounter& operator=( const JobCounter& ) = delete;
+
+		[[nodiscard]] bool IsDone() const noexcept { return mPending.load( std::memory_order_acquire ) == 0; }
+		[[nodiscard]] uint32_t GetPending() const noexcept { return mPending.load( std::memory_order_relaxed ); }
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32_t> mPending{ 0 };
+
+		mutable std::mutex mExceptionMutex;
+		mutable std::exception_ptr mException;
+	};
+
+	// Type erased callable, small ones are stored inline so queuing a job is a single allocation
+	class Job final
+	{
+	public:
+		template<class Func>
+		Job( Func&& func, JobCounter* counter )
+			: mpCounter{ counter }
+		{
+			using Func_T = std::decay_t<Func>;
+			if constexpr ((sizeof( Func_T ) <= StorageSize) && (alignof( Func_T ) <= alignof( std::max_align_t )))
+			{
+				new (mStorage) Func_T( std::forward<Func>( func ) );
+				mInvoke = []( void* storage ) { (*static_cast<Func_T*>(storage))(); };
+				mDestroy = []( void* storage ) { static_cast<Func_T*>(storage)->~Func_T(); };
+			}
+			else
+			{
+				new (mStorage) Func_T*( new Func_T( std::forward<Func>( func ) ) );
+				mInvoke = []( void* storage ) { (**static_cast<Func_T**>(storage))(); };
+				mDestroy = []( void* storage ) { delete *static_cast<Func_T**>(storage); };
+			}
+		}
+		~Job() { mDestroy( mStorage ); }
+
+		Job( const Job& ) = delete;
+		Job& operator=( const Job& ) = delete;
+
+	private:
+		friend class JobSystem;
+
+		static constexpr size_t StorageSize = 48;
+
+		alignas(std::max_align_t) std::byte mStorage[StorageSize];
+		void (*mInvoke)(void*);
+		void (*mDestroy)(void*);
+		JobCounter* mpCounter;
+	};
+
+	// Work-stealing job scheduler, owned by Core and shared with the game and plugins
+	//
+	// Every worker, and the main thread, has its own Chase-Lev deque. Jobs queued from one of those threads go on its own deque
+	// and are popped newest first, idle workers steal the oldest jobs from the others. Jobs queued from any other thread
+	// go through a shared queue. Jobs that have to run on the main thread, such as anything touching the GL context,
+	// are queued separately with RunOnMainThread() and run by ProcessMainThreadJobs(), which Core calls once per frame.
+	class JobSystem final
+	{
+	public:
+		// 0 workers for one per core, leaving one for the main thread. The main thread is whichever thread constructs the system.
+		// A system constructed while another one owns the main thread takes it over until it's destroyed, then hands it back,
+		// so systems on the same thread must be destroyed in reverse order.
+		explicit JobSystem( uint32_t n_workers = 0 );
+		~JobSystem();
+
+		JobSystem( const JobSystem& ) = delete;
+		JobSystem& operator=( const JobSystem& ) = delete;
+
+		[[nodiscard]] uint32_t GetWorkerCount() const noexcept { return static_cast<uint32_t>( mWorkers.size() ); }
+		[[nodiscard]] bool IsMainThread() const noexcept { return std::this_thread::get_id() == mMainThreadId; }
+
+		// Queues `func` to run on any thread in the system, including the main thread while it waits
+		template<class Func>
+		void Run( Func&& func, JobCounter* counter = nullptr )
+		{
+			Queue( new Job( std::forward<Func>( func ), counter ) );
+		}
+
+		// Queues `func` to run on a worker, never on the main thread while it waits. For long jobs that would otherwise be picked up
+		// and held by the main thread's waits, such as the simulation while the main thread renders with pipelined rendering.
+		template<class Func>
+		void RunOnWorker( Func&& func, JobCounter* counter = nullptr )
+		{
+			QueueOnWorker( new Job( std::forward<Func>( func ), counter ) );
+		}
+
+		// Queues `func` to run during ProcessMainThreadJobs(), or while the main thread waits
+		template<class Func>
+		void RunOnMainThread( Func&& func, JobCounter* counter = nullptr )
+		{
+			QueueOnMainThread( new Job( std::forward<Func>( func ), counter ) );
+		}
+
+		// Splits [0, count) into batches of `batch_size` and calls `func( begin, end )` for each across the workers, returns once they're all done
+		template<class Func>
+		void ParallelFor( size_t count, size_t batch_size, Func&& func )
+		{
+			if (count == 0)
+				return;
+
+			batch_size = std::max<size_t>( batch_size, 1 );
+			if (count <= batch_size)
+			{
+				func( size_t{ 0 }, count );
+				return;
+			}
+
+			JobCounter counter;
+			for (size_t begin = batch_size; begin < count; begin += batch_size)
+				Run( [&func, begin, end = std::min( begin + batch_size, count )]() { func( begin, end ); }, &counter );
+
+			// the calling thread takes the first batch rather than sitting idle,
+			// the other batches reference func and counter so they have to finish before an exception leaves
+			std::exception_ptr exception;
+			try
+			{
+				func( size_t{ 0 }, batch_size );
+			}
+			catch (...)
+			{
+				exception = std::current_exception();
+			}
+
+			if (!exception)
+			{
+				Wait( counter );
+				return;
+			}
+
+			try
+			{
+				Wait( counter );
+			}
+			catch (...)
+			{
+				// the first batch's exception wins
+			}
+			std::rethrow_exception( exception );
+		}
+
+		// Runs queued jobs until the counter reaches zero, on the main thread that includes main thread jobs.
+		// Rethrows the first exception thrown by one of the counter's jobs.
+		void Wait( const JobCounter& counter );
+
+		// Main thread only
+		void ProcessMainThreadJobs();
+
+	private:
+		static constexpr size_t DequeCapacity = 4096;
+		using Deque_T = WorkStealingDeque<Job*, DequeCapacity>;
+
+		void Queue( Job* job );
+		void QueueOnMainThread( Job* job );
+		void QueueOnWorker( Job* job );
+		void Execute( Job* job );
+		// Worker only jobs on workers, then own deque, then the shared queue, then steals
+		[[nodiscard]] Job* FindJob( int32_t thread_idx );
+		void WakeWorker();
+		void WorkerMain( uint32_t thread_idx );
+
+		// index into mDeques of the calling thread, or -1 if it isn't part of this system
+		[[nodiscard]] int32_t GetThreadIndex() const noexcept;
+
+	private:
+		const std::thread::id mMainThreadId;
+		// the system that owned the main thread before this one, restored by the destructor
+		const JobSystem* mpPreviousSystem;
+		int32_t mPreviousThreadIdx;
+
+		// [0] is the main thread's, [i] is mWorkers[i - 1]'s
+		std::vector<std::unique_ptr<Deque_T>> mDeques;
+		std::vector<std::thread> mWorkers;
+
+		std::mutex mSharedMutex;
+		std::deque<Job*> mSharedJobs; // queued from threads outside the system, or when a deque was full
+		std::atomic<size_t> mNumSharedJobs{ 0 };
+
+		std::mutex mMainThreadMutex;
+		std::vector<Job*> mMainThreadJobs;
+
+		std::mutex mWorkerMutex;
+		std::deque<Job*> mWorkerJobs; // RunOnWorker(), only taken by workers
+		std::atomic<size_t> mNumWorkerJobs{ 0 };
+
+		// sleeping workers are woken whenever a job is queued, the epoch catches jobs queued as a worker goes to sleep
+		std::mutex mSleepMutex;
+		std::condition_variable mWakeWorkers;
+		std::atomic<uint64_t> mEpoch{ 0 };
+		std::atomic<uint32_t> mNumSleeping{ 0 };
+		std::atomic<bool> mStopping{ false };
+	};
+}
@@ -12,6 +12,8 @@
 
 #include "Avokii/Plugins/SDL2/WindowSDL2.hpp"
 
+#include "Avokii/Profiling/Profiler.hpp"
+
 using namespace std::string_literals;
 
 namespace
@@ -21,6 +23,70 @@ namespace
 		None,
 		SDL2_OpenGL
 	};
+
+	void DrawProfilerWindow( bool& open, std::vector<float>& frame_times, std::vector<Avokii::Profiler::CpuEvent>& events )
+	{
+		using Avokii::Profiler;
+
+		if (!ImGui::Begin( "Profiler", &open ))
+		{
+			ImGui::End();
+			return;
+		}
+
+		bool enabled = Profiler::IsEnabled();
+		if (ImGui::Checkbox( "Enabled", &enabled ))
+			Profiler::SetEnabled( enabled );
+
+		ImGui::SameLine();
+		if (Profiler::IsCapturing())
+		{
+			if (ImGui::Button( "Save trace" ))
+				Profiler::EndCapture( Avokii::Filepath{ "profile_trace.json" } );
+		}
+		else if (ImGui::Button( "Capture trace" ))
+			Profiler::BeginCapture();
+
+		Profiler::GetFrameTimes( frame_times );
+		ImGui::PlotLines( "##frame_times", frame_times.data(), static_cast<int>(frame_times.size()), 0, "Frame time (ms)", 0.f, 33.3f, ImVec2( -1.f, 60.f ) );
+
+		const auto& frame = Profiler::GetLastFrame();
+		ImGui::Text( "Frame %llu: %.2f ms", static_cast<unsigned long long>(frame.index), frame.GetDurationMs() );
+		if (frame.n_dropped_events > 0)
+			ImGui::TextColored( ImVec4( 1.f, 0.5f, 0.f, 1.f ), "%u scopes dropped", frame.n_dropped_events );
+
+		if (ImGui::CollapsingHeader( "CPU", ImGuiTreeNodeFlags_DefaultOpen ))
+		{
+			// recorded as scopes finish, show them per thread in the order they started
+			events = frame.cpu_events;
+			std::sort( events.begin(), events.end(), []( const auto& a, const auto& b ) { return (a.thread_idx != b.thread_idx) ? (a.thread_idx < b.thread_idx) : (a.start_ns < b.start_ns); } );
+
+			uint32_t thread_idx = std::numeric_limits<uint32_t>::max();
+			for (const auto& event : events)
+			{
+				if (event.thread_idx != thread_idx)
+				{
+					thread_idx = event.thread_idx;
+					ImGui::TextDisabled( "Thread %u", thread_idx );
+				}
+
+				ImGui::Indent( 12.f * (event.depth + 1) );
+				ImGui::Text( "%s: %.3f ms", event.name, (event.end_ns - event.start_ns) / 1'000'000.0 );
+				ImGui::Unindent( 12.f * (event.depth + 1) );
+			}
+		}
+
+		if (ImGui::CollapsingHeader( "GPU", ImGuiTreeNodeFlags_DefaultOpen ))
+		{
+			if (frame.gpu_events.empty())
+				ImGui::TextDisabled( "No GPU timings this frame" );
+
+			for (const auto& event : frame.gpu_events)
+				ImGui::Text( "%s: %.3f ms", event.name, event.duration_ns / 1'000'000.0 );
+		}
+
+		ImGui::End();
+	}
 }
 
 namespace Avokii::Plugins
@@ -34,6 +100,10 @@ namespace Avokii::Plugins
 		ImGuiContext* imgui_context = NULL;
 		Impl impl = Impl::None;
 		bool implementation_initalised = false;
+
+		// profiler window scratch
+		std::vector<float> profiler_frame_times;
+		std::vector<Profiler::CpuEvent> profiler_events;
 	};
 
 
@@ -118,6 +188,9 @@ namespace Avokii::Plugins
 
 		case StepType::PostGameStep:
 		{
+			if (profiler_visible)
+				DrawProfilerWindow( profiler_visible, data->profiler_frame_times, data->profiler_events );
+
 			ImGui::Render();
 			break;
 		}
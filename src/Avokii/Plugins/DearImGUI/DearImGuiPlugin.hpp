@@ -25,6 +25,9 @@ namespace Avokii
 			void SetEnabled( const bool enable ) override;
 			bool GetEnabled() const noexcept override { return enabled; }
 
+			void SetProfilerVisible( const bool visible ) override { profiler_visible = visible; }
+			bool GetProfilerVisible() const noexcept override { return profiler_visible; }
+
 			bool WantsToCaptureKeyboard() const noexcept override;
 			bool WantsToCaptureMouse() const noexcept override;
 
@@ -47,6 +50,7 @@ namespace Avokii
 			struct Data;
 			std::unique_ptr<Data> data;
 			bool enabled = false;
+			bool profiler_visible = false;
 		};
 	}
 }
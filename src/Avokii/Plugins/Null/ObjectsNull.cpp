@@ -0,0 +1,224 @@
+#include "ObjectsNull.hpp"
+
+#include <atomic>
+
+namespace Avokii::Plugins
+{
+	namespace
+	{
+		// native ids for textures and texture arrays, 0 is never handed out
+		std::atomic<uint32_t> NextTextureId{ 1 };
+
+		uint32_t GetBytesPerPixel( Graphics::TextureFormat format )
+		{
+			switch (format)
+			{
+			case Graphics::TextureFormat::RGBA8: return 4;
+			case Graphics::TextureFormat::RGB8: return 3;
+			case Graphics::TextureFormat::R8: return 1;
+			}
+
+			return 4;
+		}
+	}
+
+	///
+	/// VertexBufferNull
+	///
+
+	VertexBufferNull::VertexBufferNull( const Graphics::VertexBufferDefinition& definition, NullStatistics_T statistics )
+		: mpStatistics( std::move( statistics ) )
+		, mLayout( definition.layout )
+	{
+		if (definition.usage == Graphics::BufferUsage::Stream)
+		{
+			AV_ASSERT( definition.stream_segment_size > 0, "Stream buffers require a segment size" );
+			mSegmentSize = definition.stream_segment_size;
+			mSegmentCount = std::max( 1u, definition.stream_segment_count );
+			mContents.resize( static_cast<size_t>( mSegmentSize ) * mSegmentCount );
+		}
+		else
+		{
+			mSegmentSize = static_cast<uint32_t>( definition.data.size() );
+			mContents.resize( definition.data.size() );
+			std::memcpy( mContents.data(), definition.data.data(), definition.data.size() );
+			mpStatistics->nBufferBytes += definition.data.size();
+		}
+
+		++mpStatistics->nBuffersCreated;
+	}
+
+	void VertexBufferNull::SetData( const void* data, uint32_t size )
+	{
+		SetSubData( 0, data, size );
+	}
+
+	void VertexBufferNull::SetSubData( uint32_t offset, const void* data, uint32_t size )
+	{
+		AV_ASSERT( static_cast<size_t>( offset ) + size <= mContents.size(), "Write past the end of the buffer" );
+		std::memcpy( mContents.data() + offset, data, size );
+		mpStatistics->nBufferBytes += size;
+	}
+
+	void* VertexBufferNull::BeginWrite()
+	{
+		AV_ASSERT( !mWriting, "BeginWrite() called twice without EndWrite()" );
+		mWriting = true;
+		return mContents.data() + static_cast<size_t>( mCurrentSegment ) * mSegmentSize;
+	}
+
+	uint32_t VertexBufferNull::EndWrite( uint32_t size )
+	{
+		AV_ASSERT( mWriting, "EndWrite() called without BeginWrite()" );
+		AV_ASSERT( size <= mSegmentSize );
+		mWriting = false;
+
+		const uint32_t offset = mCurrentSegment * mSegmentSize;
+		mCurrentSegment = (mCurrentSegment + 1) % mSegmentCount;
+		mpStatistics->nBufferBytes += size;
+		return offset;
+	}
+
+	///
+	/// IndexBufferNull
+	///
+
+	IndexBufferNull::IndexBufferNull( const Graphics::IndexBufferDefinition& definition, NullStatistics_T statistics )
+		: mIndices( definition.indices )
+	{
+		statistics->nBufferBytes += mIndices.size() * sizeof( uint32_t );
+		++statistics->nBuffersCreated;
+	}
+
+	///
+	/// VertexArrayNull
+	///
+
+	VertexArrayNull::VertexArrayNull( const Graphics::VertexArrayDefinition& definition )
+		: mVertexBuffers( definition.vertex_buffers )
+		, mIndexBuffer( definition.index_buffer )
+	{
+	}
+
+	void VertexArrayNull::AddVertexBuffer( const std::shared_ptr<Graphics::VertexBuffer>& vertex_buffer )
+	{
+		AV_ASSERT( vertex_buffer->GetLayout().GetElements().size() > 0, "Vertex buffer has no layout!" );
+		mVertexBuffers.push_back( vertex_buffer );
+	}
+
+	const std::shared_ptr<Graphics::VertexBuffer>& VertexArrayNull::GetVertexBuffer( size_t i ) const
+	{
+		AV_ASSERT( i < mVertexBuffers.size() );
+		return mVertexBuffers[i];
+	}
+
+	///
+	/// FrameBufferNull
+	///
+
+	FrameBufferNull::FrameBufferNull( const Graphics::FrameBufferSpecification& specification )
+		: mSpecification( specification )
+	{
+	}
+
+	void FrameBufferNull::Resize( uint32_t width, uint32_t height )
+	{
+		mSpecification.size = Size<uint32_t>( width, height );
+	}
+
+	///
+	/// ShaderNull
+	///
+
+	ShaderNull::ShaderNull( std::string_view name, NullStatistics_T statistics )
+		: mpStatistics( std::move( statistics ) )
+		, mName( name )
+	{
+		++mpStatistics->nShadersCreated;
+	}
+
+	void ShaderNull::Bind() const
+	{
+		++mpStatistics->nShaderBinds;
+	}
+
+	void ShaderNull::SetInt( const std::string&, int ) { ++mpStatistics->nUniformsSet; }
+	void ShaderNull::SetUInt( const std::string&, unsigned int ) { ++mpStatistics->nUniformsSet; }
+	void ShaderNull::SetIntArray( const std::string&, int*, uint32_t ) { ++mpStatistics->nUniformsSet; }
+	void ShaderNull::SetUIntArray( const std::string&, unsigned int*, uint32_t ) { ++mpStatistics->nUniformsSet; }
+	void ShaderNull::SetFloat( const std::string&, float ) { ++mpStatistics->nUniformsSet; }
+	void ShaderNull::SetFloat3( const std::string&, Vec3f ) { ++mpStatistics->nUniformsSet; }
+	void ShaderNull::SetFloat4( const std::string&, Vec4f ) { ++mpStatistics->nUniformsSet; }
+	void ShaderNull::SetMat4( const std::string&, Mat4f ) { ++mpStatistics->nUniformsSet; }
+
+	///
+	/// TextureNull
+	///
+
+	TextureNull::TextureNull( Size<uint32_t> size, Graphics::TextureFormat format, NullStatistics_T statistics )
+		: mpStatistics( std::move( statistics ) )
+		, mSize( size )
+		, mFormat( format )
+		, mId( NextTextureId.fetch_add( 1, std::memory_order_relaxed ) )
+	{
+		++mpStatistics->nTexturesCreated;
+	}
+
+	void TextureNull::SetData( void* data, uint32_t size )
+	{
+		(void)data;
+		AV_ASSERT( size == mSize.width * mSize.height * GetBytesPerPixel( mFormat ), "Data must be entire texture!" );
+		mpStatistics->nTextureBytes += size;
+	}
+
+	void TextureNull::Bind( uint32_t slot ) const
+	{
+		(void)slot;
+		++mpStatistics->nTextureBinds;
+	}
+
+	bool TextureNull::SwapContents( Texture& other ) noexcept
+	{
+		auto* const null_other = dynamic_cast<TextureNull*>(&other);
+		if (!null_other)
+			return false;
+
+		std::swap( mSize, null_other->mSize );
+		std::swap( mFormat, null_other->mFormat );
+		std::swap( mId, null_other->mId );
+		return true;
+	}
+
+	///
+	/// TextureArrayNull
+	///
+
+	TextureArrayNull::TextureArrayNull( const Graphics::TextureArrayDefinition& definition, NullStatistics_T statistics )
+		: mpStatistics( std::move( statistics ) )
+		, mSize( definition.size )
+		, mLayers( definition.layers )
+		, mId( NextTextureId.fetch_add( 1, std::memory_order_relaxed ) )
+	{
+		++mpStatistics->nTexturesCreated;
+	}
+
+	void TextureArrayNull::CopyLayerFrom( uint32_t layer, const Graphics::Texture& source )
+	{
+		AV_ASSERT( layer < mLayers );
+		AV_ASSERT( source.GetFormat() == Graphics::TextureFormat::RGBA8, "Texture array layers can only be copied from RGBA8 textures" );
+		AV_ASSERT( source.GetSize().width <= mSize.width && source.GetSize().height <= mSize.height, "Source texture is larger than the array" );
+		mpStatistics->nTextureBytes += static_cast<uint64_t>( source.GetSize().width ) * source.GetSize().height * 4;
+	}
+
+	void TextureArrayNull::ClearLayer( uint32_t layer )
+	{
+		AV_ASSERT( layer < mLayers );
+		mpStatistics->nTextureBytes += static_cast<uint64_t>( mSize.width ) * mSize.height * 4;
+	}
+
+	void TextureArrayNull::Bind( uint32_t slot ) const
+	{
+		(void)slot;
+		++mpStatistics->nTextureBinds;
+	}
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "Avokii/Graphics/FrameBuffer.hpp"
+#include "Avokii/Graphics/GraphicsBuffer.hpp"
+#include "Avokii/Graphics/Shader.hpp"
+#include "Avokii/Graphics/Texture.hpp"
+#include "Avokii/Graphics/VertexArray.hpp"
+
+#include "VideoNull.hpp"
+
+namespace Avokii::Plugins
+{
+	using NullStatistics_T = std::shared_ptr<VideoNull::Statistics>;
+
+	class VertexBufferNull final
+		: public Graphics::VertexBuffer
+	{
+	public:
+		VertexBufferNull( const Graphics::VertexBufferDefinition& definition, NullStatistics_T statistics );
+
+		virtual void Bind() const override {}
+		virtual void Unbind() const override {}
+
+		virtual void SetData( const void* data, uint32_t size ) override;
+		virtual void SetSubData( uint32_t offset, const void* data, uint32_t size ) override;
+
+		virtual void* BeginWrite() override;
+		virtual uint32_t EndWrite( uint32_t size ) override;
+
+		virtual const Graphics::BufferLayout& GetLayout() const override { return mLayout; }
+		virtual void SetLayout( const Graphics::BufferLayout& layout ) override { mLayout = layout; }
+
+		const std::vector<std::byte>& GetContents() const noexcept { return mContents; }
+
+	private:
+		NullStatistics_T mpStatistics;
+		Graphics::BufferLayout mLayout;
+		std::vector<std::byte> mContents;
+
+		// streaming, segments are written round-robin like on a real device
+		uint32_t mSegmentSize = 0;
+		uint32_t mSegmentCount = 1;
+		uint32_t mCurrentSegment = 0;
+		bool mWriting = false;
+	};
+
+	class IndexBufferNull final
+		: public Graphics::IndexBuffer
+	{
+	public:
+		IndexBufferNull( const Graphics::IndexBufferDefinition& definition, NullStatistics_T statistics );
+
+		virtual void Bind() const override {}
+		virtual void Unbind() const override {}
+
+		virtual uint32_t GetCount() const override { return static_cast<uint32_t>( mIndices.size() ); }
+
+		const std::vector<uint32_t>& GetIndices() const noexcept { return mIndices; }
+
+	private:
+		std::vector<uint32_t> mIndices;
+	};
+
+	class VertexArrayNull final
+		: public Graphics::VertexArray
+	{
+	public:
+		VertexArrayNull( const Graphics::VertexArrayDefinition& definition );
+
+		virtual void Bind() const override {}
+		virtual void Unbind() const override {}
+
+		virtual void AddVertexBuffer( const std::shared_ptr<Graphics::VertexBuffer>& vertex_buffer ) override;
+		virtual void SetIndexBuffer( const std::shared_ptr<Graphics::IndexBuffer>& index_buffer ) override { mIndexBuffer = index_buffer; }
+
+		virtual const std::vector< std::shared_ptr<Graphics::VertexBuffer> >& GetVertexBuffers() const override { return mVertexBuffers; }
+		virtual const std::shared_ptr<Graphics::VertexBuffer>& GetVertexBuffer( size_t i ) const override;
+		virtual size_t GetVertexBufferCount() const override { return mVertexBuffers.size(); }
+
+		virtual const std::shared_ptr<Graphics::IndexBuffer>& GetIndexBuffer() const override { return mIndexBuffer; }
+
+	private:
+		std::vector< std::shared_ptr<Graphics::VertexBuffer> > mVertexBuffers;
+		std::shared_ptr<Graphics::IndexBuffer> mIndexBuffer;
+	};
+
+	class FrameBufferNull final
+		: public Graphics::FrameBuffer
+	{
+	public:
+		FrameBufferNull( const Graphics::FrameBufferSpecification& specification );
+
+		virtual void Bind() override {}
+		virtual void Unbind() override {}
+
+		virtual void Resize( uint32_t width, uint32_t height ) override;
+
+		virtual const Graphics::FrameBufferSpecification& GetSpecification() const override { return mSpecification; }
+
+		virtual uint32_t GetNativeColourAttachment() const override { return 0; }
+
+	private:
+		Graphics::FrameBufferSpecification mSpecification;
+	};
+
+	// Never compiled, binds and uniforms are only counted
+	class ShaderNull final
+		: public Graphics::Shader
+	{
+	public:
+		ShaderNull( std::string_view name, NullStatistics_T statistics );
+
+		virtual void Bind() const override;
+		virtual void Unbind() const override {}
+
+		virtual void SetInt( const std::string& name, int value ) override;
+		virtual void SetUInt( const std::string& name, unsigned int value ) override;
+		virtual void SetIntArray( const std::string& name, int* values, uint32_t count ) override;
+		virtual void SetUIntArray( const std::string& name, unsigned int* values, uint32_t count ) override;
+		virtual void SetFloat( const std::string& name, float value ) override;
+		virtual void SetFloat3( const std::string& name, Vec3f value ) override;
+		virtual void SetFloat4( const std::string& name, Vec4f value ) override;
+		virtual void SetMat4( const std::string& name, Mat4f value ) override;
+
+		virtual std::string_view GetName() const override { return mName; }
+
+	private:
+		NullStatistics_T mpStatistics;
+		std::string mName;
+	};
+
+	// Only the size and format are kept, pixel data is counted and discarded
+	class TextureNull final
+		: public Graphics::Texture
+	{
+	public:
+		TextureNull( Size<uint32_t> size, Graphics::TextureFormat format, NullStatistics_T statistics );
+
+		virtual const Size<uint32_t>& GetSize() const noexcept override { return mSize; }
+		virtual Graphics::TextureFormat GetFormat() const noexcept override { return mFormat; }
+
+		virtual void SetData( void* data, uint32_t size ) override;
+
+		virtual void Bind( uint32_t slot ) const override;
+
+		virtual bool operator==( const Texture& other ) const override { return GetNativeId() == other.GetNativeId(); }
+
+		virtual uint32_t GetNativeId() const noexcept override { return mId; }
+
+	protected:
+		virtual bool SwapContents( Texture& other ) noexcept override;
+
+	private:
+		NullStatistics_T mpStatistics;
+		Size<uint32_t> mSize;
+		Graphics::TextureFormat mFormat;
+		uint32_t mId;
+	};
+
+	class TextureArrayNull final
+		: public Graphics::TextureArray
+	{
+	public:
+		TextureArrayNull( const Graphics::TextureArrayDefinition& definition, NullStatistics_T statistics );
+
+		virtual const Size<uint32_t>& GetSize() const noexcept override { return mSize; }
+		virtual uint32_t GetLayerCount() const noexcept override { return mLayers; }
+
+		virtual void CopyLayerFrom( uint32_t layer, const Graphics::Texture& source ) override;
+		virtual void ClearLayer( uint32_t layer ) override;
+
+		virtual void Bind( uint32_t slot ) const override;
+
+		virtual uint32_t GetNativeId() const noexcept override { return mId; }
+
+	private:
+		NullStatistics_T mpStatistics;
+		Size<uint32_t> mSize;
+		uint32_t mLayers;
+		uint32_t mId;
+	};
+}
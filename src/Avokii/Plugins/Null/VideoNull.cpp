@@ -0,0 +1,163 @@
+#include "VideoNull.hpp"
+
+#include "ObjectsNull.hpp"
+
+#include <stb_image/stb_image.h>
+
+namespace Avokii::Plugins
+{
+	VideoNull::VideoNull( const VideoNullDefinition& definition )
+		: capabilities( definition.capabilities )
+		, statistics( std::make_shared<Statistics>() )
+		, record_commands( definition.record_commands )
+	{
+	}
+
+	VideoNull::~VideoNull() = default;
+
+	void VideoNull::Init()
+	{
+	}
+
+	void VideoNull::Shutdown()
+	{
+		commands.clear();
+	}
+
+	void VideoNull::BeginRender()
+	{
+		commands.clear();
+	}
+
+	void VideoNull::EndRender()
+	{
+		++statistics->nFrames;
+	}
+
+	void VideoNull::SetWindow( Graphics::WindowDefinition&& definition )
+	{
+		(void)definition;
+		AV_LOG_WARN( LoggingChannels::Application, "VideoNull is headless, ignoring SetWindow()" );
+	}
+
+	const Graphics::Window& VideoNull::GetWindow() const
+	{
+		throw std::runtime_error( "VideoNull has no window" );
+	}
+
+	void VideoNull::SetViewport( Rect<uint32_t> rect )
+	{
+		viewport = rect;
+	}
+
+	void VideoNull::DrawIndexed( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t index_count, uint32_t base_vertex )
+	{
+		AV_ASSERT( vertex_array != nullptr );
+		AV_ASSERT( vertex_array->GetIndexBuffer() != nullptr, "DrawIndexed() requires an index buffer" );
+
+		const uint32_t count = (index_count > 0) ? index_count : vertex_array->GetIndexBuffer()->GetCount();
+		++statistics->nDrawCalls;
+		statistics->nIndices += count;
+
+		RecordCommand( Command{ Command::Type::DrawIndexed, vertex_array.get(), count, 1, base_vertex } );
+	}
+
+	void VideoNull::DrawInstanced( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t vertex_count, uint32_t instance_count, uint32_t base_instance )
+	{
+		AV_ASSERT( vertex_array != nullptr );
+		AV_ASSERT( (base_instance == 0) || capabilities.base_instance, "Device doesn't support a base instance" );
+
+		++statistics->nDrawCalls;
+		statistics->nVertices += vertex_count;
+		statistics->nInstances += instance_count;
+
+		RecordCommand( Command{ Command::Type::DrawInstanced, vertex_array.get(), vertex_count, instance_count, base_instance } );
+	}
+
+	void VideoNull::RecordCommand( const Command& command )
+	{
+		if (record_commands)
+			commands.push_back( command );
+	}
+
+	void VideoNull::ResetStatistics()
+	{
+		*statistics = Statistics{};
+	}
+
+	std::shared_ptr<Graphics::VertexBuffer> VideoNull::CreateVertexBuffer( const Graphics::VertexBufferDefinition& definition ) const
+	{
+		return std::make_shared<VertexBufferNull>( definition, statistics );
+	}
+
+	std::shared_ptr<Graphics::IndexBuffer> VideoNull::CreateIndexBuffer( const Graphics::IndexBufferDefinition& definition ) const
+	{
+		return std::make_shared<IndexBufferNull>( definition, statistics );
+	}
+
+	std::shared_ptr<Graphics::FrameBuffer> VideoNull::CreateFrameBuffer( const Graphics::FrameBufferSpecification& definition ) const
+	{
+		++statistics->nFrameBuffersCreated;
+		return std::make_shared<FrameBufferNull>( definition );
+	}
+
+	std::shared_ptr<Graphics::Shader> VideoNull::CreateShader( const Filepath& filepath ) const
+	{
+		return std::make_shared<ShaderNull>( filepath.stem().string(), statistics );
+	}
+
+	std::shared_ptr<Graphics::Shader> VideoNull::CreateShader( std::string_view name, std::string_view vertex_src, std::string_view fragment_src ) const
+	{
+		(void)vertex_src;
+		(void)fragment_src;
+		return std::make_shared<ShaderNull>( name, statistics );
+	}
+
+	std::shared_ptr<Graphics::Texture> VideoNull::CreateTexture( const Graphics::TextureDefinition& definition ) const
+	{
+		return std::make_shared<TextureNull>( definition.size, definition.format, statistics );
+	}
+
+	std::shared_ptr<Graphics::Texture> VideoNull::CreateTexture( const Filepath& filepath, const Graphics::TextureLoadProperties& props ) const
+	{
+		(void)props;
+		AV_ASSERT( std::filesystem::is_regular_file( filepath ) );
+
+		// only the header is read, the image is never decoded
+		int out_w = 0, out_h = 0, out_channels = 0;
+		const bool read = stbi_info( filepath.string().c_str(), &out_w, &out_h, &out_channels ) != 0;
+		AV_ASSERT( read, "Failed to read image" ); (void)read;
+
+		Graphics::TextureFormat format = Graphics::TextureFormat::RGBA8;
+		if (out_channels == 3)
+			format = Graphics::TextureFormat::RGB8;
+		else if (out_channels == 1)
+			format = Graphics::TextureFormat::R8;
+		else
+			AV_ASSERT( out_channels == 4, "Unsupported number of channels in image!" );
+
+		return std::make_shared<TextureNull>( Size( (uint32_t)out_w, (uint32_t)out_h ), format, statistics );
+	}
+
+	std::shared_ptr<Graphics::TextureArray> VideoNull::CreateTextureArray( const Graphics::TextureArrayDefinition& definition ) const
+	{
+		AV_ASSERT( definition.layers <= capabilities.max_texture_array_layers, "Device doesn't support that many texture array layers" );
+		return std::make_shared<TextureArrayNull>( definition, statistics );
+	}
+
+	std::shared_ptr<Graphics::VertexArray> VideoNull::CreateVertexArray( const Graphics::VertexArrayDefinition& definition ) const
+	{
+		return std::make_shared<VertexArrayNull>( definition );
+	}
+
+	std::string_view VideoNull::GetName() const noexcept
+	{
+		return "Null";
+	}
+
+	std::string_view VideoNull::GetShaderLanguage() const
+	{
+		// matches the OpenGL plugin so the same shader assets resolve
+		return "glsl";
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Avokii/API/VideoAPI.hpp"
+#include "Avokii/Graphics/DeviceCapabilities.hpp"
+
+namespace Avokii::Plugins
+{
+	struct VideoNullDefinition
+	{
+		// reported as-is by GetDeviceCapabilities(), the defaults roughly match a desktop OpenGL 4.5 device
+		Graphics::DeviceCapabilities capabilities
+		{
+			.max_texture_slots = 16,
+			.max_texture_width = 16384, .max_texture_height = 16384,
+			.max_cubemap_width = 16384, .max_cubemap_height = 16384,
+			.max_texture_coordinates = 8,
+			.persistent_mapped_buffers = true,
+			.base_instance = true,
+			.max_texture_array_layers = 2048,
+		};
+		// keep a log of the commands issued each frame, see GetCommands()
+		bool record_commands = true;
+	};
+
+	// Headless video backend, everything lives in CPU memory and nothing is ever drawn
+	//
+	// Useful for running and benchmarking rendering code without a display or GPU driver.
+	// Issued draws and bytes written to buffers and textures are counted, so the cost of a renderer can be checked
+	// independent of the device. Shaders and textures loaded from files never read the file contents.
+	class VideoNull final
+		: public API::VideoAPI
+	{
+	public:
+		struct Statistics
+		{
+			uint32_t nFrames = 0;
+			uint32_t nDrawCalls = 0;
+			uint64_t nIndices = 0; // DrawIndexed()
+			uint64_t nVertices = 0; // DrawInstanced(), per instance
+			uint64_t nInstances = 0;
+
+			uint64_t nBufferBytes = 0; // written to vertex and index buffers, including their initial data
+			uint64_t nTextureBytes = 0; // written to textures and texture array layers
+			uint32_t nTextureBinds = 0;
+			uint32_t nShaderBinds = 0;
+			uint32_t nUniformsSet = 0;
+
+			uint32_t nBuffersCreated = 0;
+			uint32_t nTexturesCreated = 0;
+			uint32_t nShadersCreated = 0;
+			uint32_t nFrameBuffersCreated = 0;
+		};
+
+		struct Command
+		{
+			enum class Type
+			{
+				DrawIndexed,
+				DrawInstanced,
+			};
+
+			Type type;
+			const Graphics::VertexArray* vertex_array = nullptr;
+			uint32_t count = 0; // indices or vertices
+			uint32_t instance_count = 0;
+			uint32_t base = 0; // base vertex or base instance
+		};
+
+	public:
+		explicit VideoNull( const VideoNullDefinition& definition = {} );
+		~VideoNull();
+
+		virtual void BeginRender() override;
+		virtual void EndRender() override;
+
+		// Headless, there is never a window
+		virtual void SetWindow( Graphics::WindowDefinition&& definition ) override;
+		virtual const Graphics::Window& GetWindow() const override;
+		virtual bool HasWindow() const override { return false; }
+
+		virtual void SetViewport( Rect<uint32_t> ) override;
+		virtual Rect<uint32_t> GetViewport() const override { return viewport; }
+
+		virtual const Graphics::DeviceCapabilities& GetDeviceCapabilities() const override { return capabilities; }
+		void SetDeviceCapabilities( const Graphics::DeviceCapabilities& capabilities_ ) { capabilities = capabilities_; }
+
+		virtual void DrawIndexed( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t index_count = 0, uint32_t base_vertex = 0 ) override;
+		virtual void DrawInstanced( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t vertex_count, uint32_t instance_count, uint32_t base_instance = 0 ) override;
+
+		virtual std::shared_ptr<Graphics::VertexBuffer> CreateVertexBuffer( const Graphics::VertexBufferDefinition& definition ) const override;
+		virtual std::shared_ptr<Graphics::IndexBuffer> CreateIndexBuffer( const Graphics::IndexBufferDefinition& definition ) const override;
+		virtual std::shared_ptr<Graphics::FrameBuffer> CreateFrameBuffer( const Graphics::FrameBufferSpecification& definition ) const override;
+		virtual std::shared_ptr<Graphics::Shader> CreateShader( const Filepath& filepath ) const override;
+		virtual std::shared_ptr<Graphics::Shader> CreateShader( std::string_view name, std::string_view vertex_src, std::string_view fragment_src ) const override;
+		virtual std::shared_ptr<Graphics::Texture> CreateTexture( const Graphics::TextureDefinition& props ) const override;
+		virtual std::shared_ptr<Graphics::Texture> CreateTexture( const Filepath& filepath, const Graphics::TextureLoadProperties& props ) const override;
+		virtual std::shared_ptr<Graphics::TextureArray> CreateTextureArray( const Graphics::TextureArrayDefinition& definition ) const override;
+		virtual std::shared_ptr<Graphics::VertexArray> CreateVertexArray( const Graphics::VertexArrayDefinition& definition ) const override;
+
+		virtual std::string_view GetName() const noexcept override;
+		virtual std::string_view GetShaderLanguage() const override;
+
+		// Totals since construction or the last ResetStatistics()
+		const Statistics& GetStatistics() const noexcept { return *statistics; }
+		void ResetStatistics();
+
+		// Commands issued since the last BeginRender(), empty unless VideoNullDefinition::record_commands is set
+		const std::vector<Command>& GetCommands() const noexcept { return commands; }
+		void SetRecordCommands( bool enabled ) { record_commands = enabled; }
+
+	protected:
+		void Init() override;
+		void Shutdown() override;
+
+	private:
+		void RecordCommand( const Command& command );
+
+	private:
+		Graphics::DeviceCapabilities capabilities;
+		Rect<uint32_t> viewport;
+
+		// shared with the objects created by this plugin, which may outlive it
+		std::shared_ptr<Statistics> statistics;
+
+		bool record_commands;
+		std::vector<Command> commands;
+	};
+}
@@ -41,7 +41,7 @@ namespace
 
 namespace Avokii::Plugins
 {
-	VertexBufferOpenGL::VertexBufferOpenGL( const Graphics::VertexBufferDefinition& definition )
+	VertexBufferOpenGL::VertexBufferOpenGL( const Graphics::VertexBufferDefinition& definition, const bool allow_persistent_mapping )
 		: name( definition.name.value_or( "Unnamed vertex buffer" ) )
 		, layout( definition.layout )
 	{
@@ -49,7 +49,41 @@ namespace Avokii::Plugins
 
 		glCreateBuffers( 1, &vbo );
 		Bind();
-		glBufferData( GL_ARRAY_BUFFER, definition.data.size(), (void*)definition.data.data(), GL_DYNAMIC_DRAW );
+
+		switch (definition.usage)
+		{
+		case Graphics::BufferUsage::Static:
+			glBufferData( GL_ARRAY_BUFFER, definition.data.size(), (void*)definition.data.data(), GL_STATIC_DRAW );
+			segment_size = static_cast<uint32_t>(definition.data.size());
+			break;
+
+		case Graphics::BufferUsage::Dynamic:
+			glBufferData( GL_ARRAY_BUFFER, definition.data.size(), (void*)definition.data.data(), GL_DYNAMIC_DRAW );
+			segment_size = static_cast<uint32_t>(definition.data.size());
+			break;
+
+		case Graphics::BufferUsage::Stream:
+		{
+			AV_ASSERT( definition.stream_segment_size > 0, "Stream buffers require a segment size" );
+			segment_size = definition.stream_segment_size;
+			segment_count = std::max( 1u, definition.stream_segment_count );
+
+			const GLsizeiptr total_size = static_cast<GLsizeiptr>(segment_size) * segment_count;
+			if (allow_persistent_mapping)
+			{
+				constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				glNamedBufferStorage( vbo, total_size, nullptr, flags );
+				persistent_mapping = static_cast<std::byte*>(glMapNamedBufferRange( vbo, 0, total_size, flags ));
+				AV_ASSERT( persistent_mapping != nullptr, "Failed to persistently map stream buffer" );
+				segment_fences.resize( segment_count, nullptr );
+			}
+
+			// fallback: orphan-free ring written with glBufferSubData
+			if (!persistent_mapping)
+				glBufferData( GL_ARRAY_BUFFER, total_size, nullptr, GL_STREAM_DRAW );
+			break;
+		}
+		}
 
 		if (definition.name)
 			glObjectLabel( GL_BUFFER, vbo, -1, definition.name.value().c_str() );
@@ -60,6 +94,15 @@ namespace Avokii::Plugins
 
 	VertexBufferOpenGL::~VertexBufferOpenGL()
 	{
+		for (auto& fence : segment_fences)
+		{
+			if (fence)
+				glDeleteSync( fence );
+		}
+
+		if (persistent_mapping)
+			glUnmapNamedBuffer( vbo );
+
 		glDeleteBuffers( 1, &vbo );
 	}
 
@@ -75,6 +118,7 @@ namespace Avokii::Plugins
 
 	void VertexBufferOpenGL::SetData( const void* data, uint32_t size )
 	{
+		AV_ASSERT( !persistent_mapping, "Persistently mapped buffers must be written through BeginWrite()" );
 		PushBoundVbo();
 
 		Bind();
@@ -84,6 +128,67 @@ namespace Avokii::Plugins
 		PopBoundVbo();
 	}
 
+	void VertexBufferOpenGL::SetSubData( uint32_t offset, const void* data, uint32_t size )
+	{
+		AV_ASSERT( !persistent_mapping, "Persistently mapped buffers must be written through BeginWrite()" );
+		glNamedBufferSubData( vbo, offset, size, data );
+	}
+
+	void* VertexBufferOpenGL::BeginWrite()
+	{
+		AV_ASSERT( !writing, "BeginWrite() called twice without EndWrite()" );
+
+		// the draw reading the previous segment has been issued by now, fence it and move along the ring
+		if (segment_pending_fence)
+		{
+			if (persistent_mapping)
+				segment_fences[current_segment] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+
+			current_segment = (current_segment + 1) % segment_count;
+			segment_pending_fence = false;
+		}
+
+		writing = true;
+		if (persistent_mapping)
+		{
+			WaitForSegment( current_segment );
+			return persistent_mapping + static_cast<size_t>(current_segment) * segment_size;
+		}
+
+		staging.resize( segment_size );
+		return staging.data();
+	}
+
+	uint32_t VertexBufferOpenGL::EndWrite( uint32_t size )
+	{
+		AV_ASSERT( writing, "EndWrite() called without BeginWrite()" );
+		AV_ASSERT( size <= segment_size );
+		writing = false;
+		segment_pending_fence = true;
+
+		const uint32_t offset = current_segment * segment_size;
+		if (!persistent_mapping && size > 0)
+			glNamedBufferSubData( vbo, offset, size, staging.data() );
+
+		return offset;
+	}
+
+	void VertexBufferOpenGL::WaitForSegment( uint32_t segment )
+	{
+		auto& fence = segment_fences[segment];
+		if (!fence)
+			return;
+
+		// only flush on the second attempt, the fence has usually already been submitted by the time we wrap around
+		GLenum result = glClientWaitSync( fence, 0, 0 );
+		while (result == GL_TIMEOUT_EXPIRED)
+			result = glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000 ); // 1ms
+
+		AV_ASSERT( result != GL_WAIT_FAILED, "Waiting on stream buffer fence failed" );
+		glDeleteSync( fence );
+		fence = nullptr;
+	}
+
 	void VertexBufferOpenGL::SetLayout( const Graphics::BufferLayout & layout_ )
 	{
 		layout = layout_;
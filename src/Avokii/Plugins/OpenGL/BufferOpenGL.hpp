@@ -2,27 +2,46 @@
 
 #include "Avokii/Graphics/GraphicsBuffer.hpp"
 
+typedef struct __GLsync* GLsync;
+
 namespace Avokii::Plugins
 {
 	class VertexBufferOpenGL
 		: public Graphics::VertexBuffer
 	{
 	public:
-		VertexBufferOpenGL( const Graphics::VertexBufferDefinition& props );
+		VertexBufferOpenGL( const Graphics::VertexBufferDefinition& props, bool allow_persistent_mapping );
 		virtual ~VertexBufferOpenGL();
 
 		virtual void Bind() const override;
 		virtual void Unbind() const override;
 
 		virtual void SetData( const void* data, uint32_t size ) override;
+		virtual void SetSubData( uint32_t offset, const void* data, uint32_t size ) override;
+
+		virtual void* BeginWrite() override;
+		virtual uint32_t EndWrite( uint32_t size ) override;
 
 		virtual const Graphics::BufferLayout& GetLayout() const override { return layout; }
 		virtual void SetLayout( const Graphics::BufferLayout& layout ) override;
 
+	private:
+		void WaitForSegment( uint32_t segment );
+
 	private:
 		std::string name;
 		uint32_t vbo;
 		Graphics::BufferLayout layout;
+
+		// streaming
+		uint32_t segment_size = 0;
+		uint32_t segment_count = 1;
+		uint32_t current_segment = 0;
+		bool writing = false;
+		bool segment_pending_fence = false;
+		std::byte* persistent_mapping = nullptr; // null when not persistently mapped, writes go through staging instead
+		std::vector<GLsync> segment_fences;
+		std::vector<std::byte> staging;
 	};
 
 	class IndexBufferOpenGL
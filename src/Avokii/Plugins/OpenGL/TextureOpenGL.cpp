@@ -3,6 +3,8 @@
 
 #include "Avokii/Utility/Unreachable.hpp"
 
+#include <cstring>
+
 #include <stb_image/stb_image.h>
 
 namespace Avokii::Plugins
@@ -23,13 +25,36 @@ namespace Avokii::Plugins
 
 			unreachable();
 		}
+
+		void GetOpenGLFormats( Graphics::TextureFormat format, GLenum& internal_format, GLenum& data_format )
+		{
+			switch (format)
+			{
+			case Graphics::TextureFormat::RGBA8: internal_format = GL_RGBA8; data_format = GL_RGBA; return;
+			case Graphics::TextureFormat::RGB8: internal_format = GL_RGB8; data_format = GL_RGB; return;
+			case Graphics::TextureFormat::R8: internal_format = GL_R8; data_format = GL_RED; return;
+			}
+
+			unreachable();
+		}
+
+		// in place, stb_image's own flip is a global setting which would race with decodes on the load workers
+		void FlipRows( unsigned char* p_data, size_t row_bytes, size_t n_rows )
+		{
+			std::vector<unsigned char> row( row_bytes );
+			for (size_t top = 0, bottom = n_rows - 1; top < bottom; ++top, --bottom)
+			{
+				std::memcpy( row.data(), p_data + top * row_bytes, row_bytes );
+				std::memcpy( p_data + top * row_bytes, p_data + bottom * row_bytes, row_bytes );
+				std::memcpy( p_data + bottom * row_bytes, row.data(), row_bytes );
+			}
+		}
 	}
 
 	TextureOpenGL::TextureOpenGL( const Graphics::TextureDefinition& definition )
 		: mSize( definition.size )
 	{
-		mOpenGlInternalFormat = GL_RGBA8;
-		mOpenGlDataFormat = GL_RGBA;
+		GetOpenGLFormats( definition.format, mOpenGlInternalFormat, mOpenGlDataFormat );
 
 		glCreateTextures( GL_TEXTURE_2D, 1, &mOpenGlTextureId );
 		glTextureStorage2D( mOpenGlTextureId, 1, mOpenGlInternalFormat, static_cast<GLsizei>( mSize.width ), static_cast<GLsizei>( mSize.height ) );
@@ -47,10 +72,11 @@ namespace Avokii::Plugins
 		
 		const auto filepath_str = filepath.string();
 		int out_w, out_h, out_channels;
-		stbi_set_flip_vertically_on_load( props.y_flip ? 1 : 0 );
 		auto* p_data = stbi_load( filepath_str.c_str(), &out_w, &out_h, &out_channels, 0 );
 
 		AV_ASSERT( p_data, "Failed to load image" );
+		if (props.y_flip && p_data)
+			FlipRows( p_data, static_cast<size_t>( out_w ) * out_channels, static_cast<size_t>( out_h ) );
 
 		mSize = Size( (uint32_t)out_w, (uint32_t)out_h );
 
@@ -99,12 +125,27 @@ namespace Avokii::Plugins
 		glDeleteTextures( 1, &mOpenGlTextureId );
 	}
 
+	Graphics::TextureFormat TextureOpenGL::GetFormat() const noexcept
+	{
+		switch (mOpenGlInternalFormat)
+		{
+		case GL_RGBA8: return Graphics::TextureFormat::RGBA8;
+		case GL_RGB8: return Graphics::TextureFormat::RGB8;
+		case GL_R8: return Graphics::TextureFormat::R8;
+		}
+
+		unreachable();
+	}
+
 	void TextureOpenGL::SetData( void* p_data, uint32_t data_size )
 	{
 		(void)data_size;
-		uint32_t bpp = (mOpenGlDataFormat == GL_RGBA) ? 4 : 3; (void)bpp;
+		uint32_t bpp = (mOpenGlDataFormat == GL_RGBA) ? 4 : ((mOpenGlDataFormat == GL_RGB) ? 3 : 1); (void)bpp;
 		AV_ASSERT( data_size == mSize.width * mSize.height * bpp, "Data size must exactly match texture!" );
+		// RGB8 and R8 rows aren't 4 byte aligned
+		glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
 		glTextureSubImage2D( mOpenGlTextureId, 0, 0, 0, static_cast<GLsizei>( mSize.width ), static_cast<GLsizei>( mSize.height ), mOpenGlDataFormat, GL_UNSIGNED_BYTE, p_data );
+		glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
 	}
 
 	void TextureOpenGL::Bind( uint32_t slot ) const
@@ -117,4 +158,72 @@ namespace Avokii::Plugins
 		const auto& opengl_other = dynamic_cast<const TextureOpenGL&>(other);
 		return mOpenGlTextureId == opengl_other.mOpenGlTextureId;
 	}
+
+	bool TextureOpenGL::SwapContents( Texture& other ) noexcept
+	{
+		auto* const opengl_other = dynamic_cast<TextureOpenGL*>(&other);
+		if (!opengl_other)
+			return false;
+
+		std::swap( mFilepath, opengl_other->mFilepath );
+		std::swap( mSize, opengl_other->mSize );
+		std::swap( mOpenGlInternalFormat, opengl_other->mOpenGlInternalFormat );
+		std::swap( mOpenGlDataFormat, opengl_other->mOpenGlDataFormat );
+		std::swap( mOpenGlTextureId, opengl_other->mOpenGlTextureId );
+		return true;
+	}
+
+
+	///
+	/// TextureArrayOpenGL
+	/// 
+
+	TextureArrayOpenGL::TextureArrayOpenGL( const Graphics::TextureArrayDefinition& definition )
+		: mSize( definition.size )
+		, mLayers( definition.layers )
+	{
+		AV_ASSERT( mLayers > 0 );
+
+		glCreateTextures( GL_TEXTURE_2D_ARRAY, 1, &mOpenGlTextureId );
+		glTextureStorage3D( mOpenGlTextureId, 1, GL_RGBA8, static_cast<GLsizei>( mSize.width ), static_cast<GLsizei>( mSize.height ), static_cast<GLsizei>( mLayers ) );
+
+		glTextureParameteri( mOpenGlTextureId, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		glTextureParameteri( mOpenGlTextureId, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+
+		// layers are usually only partially filled, never sample past the edge
+		glTextureParameteri( mOpenGlTextureId, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+		glTextureParameteri( mOpenGlTextureId, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	}
+
+	TextureArrayOpenGL::~TextureArrayOpenGL()
+	{
+		glDeleteTextures( 1, &mOpenGlTextureId );
+	}
+
+	void TextureArrayOpenGL::CopyLayerFrom( uint32_t layer, const Graphics::Texture& source )
+	{
+		AV_ASSERT( layer < mLayers );
+		AV_ASSERT( source.GetFormat() == Graphics::TextureFormat::RGBA8, "Texture arrays only hold RGBA8 textures" );
+
+		const auto& source_size = source.GetSize();
+		AV_ASSERT( source_size.width <= mSize.width && source_size.height <= mSize.height, "Texture doesn't fit in the array" );
+
+		glCopyImageSubData(
+			source.GetNativeId(), GL_TEXTURE_2D, 0, 0, 0, 0,
+			mOpenGlTextureId, GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>( layer ),
+			static_cast<GLsizei>( source_size.width ), static_cast<GLsizei>( source_size.height ), 1 );
+	}
+
+	void TextureArrayOpenGL::ClearLayer( uint32_t layer )
+	{
+		AV_ASSERT( layer < mLayers );
+
+		constexpr uint32_t transparent = 0;
+		glClearTexSubImage( mOpenGlTextureId, 0, 0, 0, static_cast<GLint>( layer ), static_cast<GLsizei>( mSize.width ), static_cast<GLsizei>( mSize.height ), 1, GL_RGBA, GL_UNSIGNED_BYTE, &transparent );
+	}
+
+	void TextureArrayOpenGL::Bind( uint32_t slot ) const
+	{
+		glBindTextureUnit( static_cast<GLenum>( slot ), mOpenGlTextureId );
+	}
 }
@@ -14,6 +14,7 @@ namespace Avokii::Plugins
 		virtual ~TextureOpenGL() override;
 
 		virtual const Size<uint32_t>& GetSize() const noexcept override { return mSize; }
+		virtual Graphics::TextureFormat GetFormat() const noexcept override;
 
 		virtual void SetData( void* data, uint32_t size ) override;
 
@@ -23,6 +24,9 @@ namespace Avokii::Plugins
 
 		virtual uint32_t GetNativeId() const noexcept override { return mOpenGlTextureId; }
 
+	protected:
+		virtual bool SwapContents( Texture& other ) noexcept override;
+
 	private:
 		std::string mFilepath;
 		Size<uint32_t> mSize;
@@ -31,4 +35,28 @@ namespace Avokii::Plugins
 		unsigned int mOpenGlDataFormat;
 		unsigned int mOpenGlTextureId;
 	};
+
+	class TextureArrayOpenGL
+		: public Graphics::TextureArray
+	{
+	public:
+		TextureArrayOpenGL( const Graphics::TextureArrayDefinition& definition );
+		virtual ~TextureArrayOpenGL() override;
+
+		virtual const Size<uint32_t>& GetSize() const noexcept override { return mSize; }
+		virtual uint32_t GetLayerCount() const noexcept override { return mLayers; }
+
+		virtual void CopyLayerFrom( uint32_t layer, const Graphics::Texture& source ) override;
+		virtual void ClearLayer( uint32_t layer ) override;
+
+		virtual void Bind( uint32_t slot ) const override;
+
+		virtual uint32_t GetNativeId() const noexcept override { return mOpenGlTextureId; }
+
+	private:
+		Size<uint32_t> mSize;
+		uint32_t mLayers;
+
+		unsigned int mOpenGlTextureId;
+	};
 }
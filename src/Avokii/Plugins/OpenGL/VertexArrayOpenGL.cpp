@@ -134,6 +134,7 @@ namespace Avokii::Plugins
 										   , static_cast<GLsizei>( layout.GetStride() )
 										   , (const void*)element.offset
 					);
+					glVertexAttribDivisor( vbi, layout.GetInstanceDivisor() );
 					++vbi;
 					break;
 				}
@@ -155,6 +156,7 @@ namespace Avokii::Plugins
 						, static_cast<GLsizei>(layout.GetStride())
 						, (const void*)element.offset
 					);
+					glVertexAttribDivisor( vbi, layout.GetInstanceDivisor() );
 					++vbi;
 					break;
 				}
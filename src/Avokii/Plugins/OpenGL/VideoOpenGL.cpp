@@ -11,6 +11,8 @@
 #include "TextureOpenGL.hpp"
 #include "VertexArrayOpenGL.hpp"
 
+#include "Avokii/Profiling/Profiler.hpp"
+
 namespace Avokii::Plugins
 {
 	VideoOpenGL::VideoOpenGL( API::SystemAPI& system_ )
@@ -22,6 +24,8 @@ namespace Avokii::Plugins
 
 	void VideoOpenGL::BeginRender()
 	{
+		CollectGpuTimers();
+
 		// TODO: remove
 		glClearColor( 0, 0, 0, 1 );
 		glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT );
@@ -80,12 +84,80 @@ namespace Avokii::Plugins
 		return "glsl";
 	}
 
+	void VideoOpenGL::BeginGpuScope( const char* name )
+	{
+#if (AV_ENABLE_PROFILING == 1)
+		if (!Profiler::IsEnabled())
+			return;
+
+		AV_ASSERT( !gpu_timer_active, "GPU profiling scopes can't nest" );
+
+		GLuint query = 0;
+		if (!free_gpu_timer_queries.empty())
+		{
+			query = free_gpu_timer_queries.back();
+			free_gpu_timer_queries.pop_back();
+		}
+		else
+			glGenQueries( 1, &query );
+
+		glBeginQuery( GL_TIME_ELAPSED, query );
+		gpu_timer_frames[gpu_timer_frame].push_back( GpuTimer{ query, name } );
+		gpu_timer_active = true;
+#else
+		(void)name;
+#endif
+	}
+
+	void VideoOpenGL::EndGpuScope()
+	{
+		if (!gpu_timer_active)
+			return;
+
+		glEndQuery( GL_TIME_ELAPSED );
+		gpu_timer_active = false;
+	}
+
+	void VideoOpenGL::CollectGpuTimers()
+	{
+		AV_ASSERT( !gpu_timer_active, "GPU profiling scope left open over a frame" );
+
+		// the oldest slot becomes this frame's, its queries have had GpuTimerLatency frames to finish
+		gpu_timer_frame = (gpu_timer_frame + 1) % GpuTimerLatency;
+		auto& timers = gpu_timer_frames[gpu_timer_frame];
+		for (const auto& timer : timers)
+		{
+			GLuint64 elapsed_ns = 0;
+			glGetQueryObjectui64v( timer.query, GL_QUERY_RESULT, &elapsed_ns );
+#if (AV_ENABLE_PROFILING == 1)
+			Profiler::RecordGpuEvent( timer.name, static_cast<uint64_t>(elapsed_ns) );
+#endif
+			free_gpu_timer_queries.push_back( timer.query );
+		}
+		timers.clear();
+	}
+
+	void VideoOpenGL::ReleaseGpuTimers()
+	{
+		for (auto& timers : gpu_timer_frames)
+		{
+			for (const auto& timer : timers)
+				free_gpu_timer_queries.push_back( timer.query );
+			timers.clear();
+		}
+
+		if (!free_gpu_timer_queries.empty())
+			glDeleteQueries( static_cast<GLsizei>(free_gpu_timer_queries.size()), free_gpu_timer_queries.data() );
+		free_gpu_timer_queries.clear();
+	}
+
 	void VideoOpenGL::Init()
 	{
 	}
 
 	void VideoOpenGL::Shutdown()
 	{
+		ReleaseGpuTimers();
 		context.reset();
 		system.DestroyWindow( window );
 		window.reset();
@@ -136,6 +208,24 @@ namespace Avokii::Plugins
 				glGetIntegerv( GL_MAX_TEXTURE_COORDS, &value );
 				capabilities.max_texture_coordinates = value;
 			}
+
+			// persistently mapped buffers (core in 4.4)
+			{
+				capabilities.persistent_mapped_buffers = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+			}
+
+			// instanced draws starting part way through the instance buffer (core in 4.2)
+			{
+				capabilities.base_instance = GLEW_VERSION_4_2 || GLEW_ARB_base_instance;
+			}
+
+			// texture arrays filled with copies of existing textures (core in 4.4)
+			if (GLEW_VERSION_4_4 || (GLEW_ARB_copy_image && GLEW_ARB_clear_texture))
+			{
+				int value = 0;
+				glGetIntegerv( GL_MAX_ARRAY_TEXTURE_LAYERS, &value );
+				capabilities.max_texture_array_layers = static_cast<uint32_t>(std::max( value, 0 ));
+			}
 		}
 
 #ifdef _DEBUG
@@ -215,15 +305,30 @@ namespace Avokii::Plugins
 		return Rect( Point2D<uint32_t>( viewport[0], viewport[1] ), Size<uint32_t>( viewport[2], viewport[3] ) );
 	}
 
-	void VideoOpenGL::DrawIndexed( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t index_count )
+	void VideoOpenGL::DrawIndexed( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t index_count, uint32_t base_vertex )
 	{
 		GLsizei count = index_count ? index_count : vertex_array->GetIndexBuffer()->GetCount();
-		glDrawElements( GL_TRIANGLES, count, GL_UNSIGNED_INT, NULL );
+		if (base_vertex > 0)
+			glDrawElementsBaseVertex( GL_TRIANGLES, count, GL_UNSIGNED_INT, NULL, static_cast<GLint>(base_vertex) );
+		else
+			glDrawElements( GL_TRIANGLES, count, GL_UNSIGNED_INT, NULL );
+	}
+
+	void VideoOpenGL::DrawInstanced( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t vertex_count, uint32_t instance_count, uint32_t base_instance )
+	{
+		(void)vertex_array;
+		if (base_instance > 0)
+		{
+			AV_ASSERT( capabilities.base_instance );
+			glDrawArraysInstancedBaseInstance( GL_TRIANGLES, 0, static_cast<GLsizei>(vertex_count), static_cast<GLsizei>(instance_count), base_instance );
+		}
+		else
+			glDrawArraysInstanced( GL_TRIANGLES, 0, static_cast<GLsizei>(vertex_count), static_cast<GLsizei>(instance_count) );
 	}
 
 	std::shared_ptr<Graphics::VertexBuffer> VideoOpenGL::CreateVertexBuffer( const Graphics::VertexBufferDefinition& definition ) const
 	{
-		return std::make_shared<VertexBufferOpenGL>( definition );
+		return std::make_shared<VertexBufferOpenGL>( definition, capabilities.persistent_mapped_buffers );
 	}
 
 	std::shared_ptr<Graphics::IndexBuffer> VideoOpenGL::CreateIndexBuffer( const Graphics::IndexBufferDefinition& definition ) const
@@ -256,6 +361,11 @@ namespace Avokii::Plugins
 		return std::make_shared<TextureOpenGL>( filepath, props );
 	}
 
+	std::shared_ptr<Graphics::TextureArray> VideoOpenGL::CreateTextureArray( const Graphics::TextureArrayDefinition& definition ) const
+	{
+		return std::make_shared<TextureArrayOpenGL>( definition );
+	}
+
 	std::shared_ptr<Graphics::VertexArray> VideoOpenGL::CreateVertexArray( const Graphics::VertexArrayDefinition& definition ) const
 	{
 		return std::make_shared<VertexArrayOpenGL>( definition );
@@ -30,7 +30,8 @@ namespace Avokii
 
 			virtual const Graphics::DeviceCapabilities& GetDeviceCapabilities() const override { return capabilities; }
 
-			virtual void DrawIndexed( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t index_count = 0 ) override;
+			virtual void DrawIndexed( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t index_count = 0, uint32_t base_vertex = 0 ) override;
+			virtual void DrawInstanced( const std::shared_ptr<Graphics::VertexArray>& vertex_array, uint32_t vertex_count, uint32_t instance_count, uint32_t base_instance = 0 ) override;
 
 			virtual std::shared_ptr<Graphics::VertexBuffer> CreateVertexBuffer( const Graphics::VertexBufferDefinition& definition ) const override;
 			virtual std::shared_ptr<Graphics::IndexBuffer> CreateIndexBuffer( const Graphics::IndexBufferDefinition& definition ) const override;
@@ -39,11 +40,15 @@ namespace Avokii
 			virtual std::shared_ptr<Graphics::Shader> CreateShader( std::string_view name, std::string_view vertex_src, std::string_view fragment_src ) const override;
 			virtual std::shared_ptr<Graphics::Texture> CreateTexture( const Graphics::TextureDefinition& props ) const override;
 			virtual std::shared_ptr<Graphics::Texture> CreateTexture( const Filepath& filepath, const Graphics::TextureLoadProperties& props ) const override;
+			virtual std::shared_ptr<Graphics::TextureArray> CreateTextureArray( const Graphics::TextureArrayDefinition& definition ) const override;
 			virtual std::shared_ptr<Graphics::VertexArray> CreateVertexArray( const Graphics::VertexArrayDefinition& definition ) const override;
 
 			virtual std::string_view GetName() const noexcept override;
 			virtual std::string_view GetShaderLanguage() const override;
 
+			virtual void BeginGpuScope( const char* name ) override;
+			virtual void EndGpuScope() override;
+
 		protected:
 			void Init() override;
 			void Shutdown() override;
@@ -55,6 +60,10 @@ namespace Avokii
 			void ClearScreen();
 			void SwapFrameBuffers();
 
+			// reports the GPU timers issued GpuTimerLatency frames ago
+			void CollectGpuTimers();
+			void ReleaseGpuTimers();
+
 			void OnOpenGLDebugMessage( unsigned source, unsigned type, unsigned id, unsigned severity, int length, const char* message ) const;
 
 		private:
@@ -66,6 +75,18 @@ namespace Avokii
 
 			std::shared_ptr<Graphics::Window> window;
 			bool vsync_enabled = false;
+
+			// GL_TIME_ELAPSED queries, read back a few frames later so the CPU never waits on them
+			static constexpr uint32_t GpuTimerLatency = 4;
+			struct GpuTimer
+			{
+				unsigned int query;
+				const char* name;
+			};
+			std::array<std::vector<GpuTimer>, GpuTimerLatency> gpu_timer_frames;
+			std::vector<unsigned int> free_gpu_timer_queries;
+			uint32_t gpu_timer_frame = 0;
+			bool gpu_timer_active = false;
 		};
 	}
 }
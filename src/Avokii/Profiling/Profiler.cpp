@@ -0,0 +1,276 @@
+#include "Profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace Avokii
+{
+	namespace
+	{
+		using Clock_T = std::chrono::steady_clock;
+
+		// written with an atomic cursor, events past the end are dropped
+		struct EventBuffer
+		{
+			std::unique_ptr<Profiler::CpuEvent[]> events{ std::make_unique<Profiler::CpuEvent[]>( Profiler::MaxEventsPerFrame ) };
+			std::atomic<uint32_t> count{ 0 };
+			std::atomic<uint32_t> n_writers{ 0 }; // threads between claiming a slot and finishing writing it, NewFrame() waits for these
+		};
+
+		struct ProfilerData
+		{
+			const Clock_T::time_point start_time{ Clock_T::now() };
+			std::atomic<bool> enabled{ AV_ENABLE_PROFILING == 1 };
+			std::atomic<uint32_t> next_thread_idx{ 0 };
+
+			// recording, current_buffer is flipped by NewFrame()
+			std::array<EventBuffer, 2> buffers;
+			std::atomic<uint32_t> current_buffer{ 0 };
+			uint64_t frame_index = 0;
+			uint64_t frame_start_ns = 0;
+
+			std::mutex gpu_mutex;
+			std::vector<Profiler::GpuEvent> pending_gpu_events;
+
+			// finished frames, a ring of HistoryLength reused between frames
+			std::vector<Profiler::Frame> history{ Profiler::HistoryLength };
+			uint32_t history_head = 0; // next frame to overwrite
+			uint32_t history_count = 0;
+
+			bool capturing = false;
+			std::vector<Profiler::Frame> capture;
+		};
+
+		ProfilerData& GetData()
+		{
+			static ProfilerData data;
+			return data;
+		}
+
+		thread_local uint32_t tThreadIdx = std::numeric_limits<uint32_t>::max();
+		thread_local uint32_t tDepth = 0;
+
+		uint32_t GetThreadIdx( ProfilerData& data ) noexcept
+		{
+			if (tThreadIdx == std::numeric_limits<uint32_t>::max())
+				tThreadIdx = data.next_thread_idx.fetch_add( 1, std::memory_order_relaxed );
+			return tThreadIdx;
+		}
+
+		void WriteJsonString( std::ostream& out, std::string_view value )
+		{
+			out << '"';
+			for (const char c : value)
+			{
+				if ((c == '"') || (c == '\\'))
+					out << '\\';
+				out << c;
+			}
+			out << '"';
+		}
+	}
+
+	///
+	/// ScopedEvent
+	///
+
+	Profiler::ScopedEvent::ScopedEvent( const char* name ) noexcept
+		: mName( IsEnabled() ? name : nullptr )
+		, mStart( 0 )
+	{
+		if (mName)
+		{
+			++tDepth;
+			mStart = Now();
+		}
+	}
+
+	Profiler::ScopedEvent::~ScopedEvent()
+	{
+		if (mName)
+		{
+			const auto end = Now();
+			RecordCpuEvent( mName, mStart, end, --tDepth );
+		}
+	}
+
+	///
+	/// Profiler
+	///
+
+	void Profiler::SetEnabled( bool enabled ) noexcept
+	{
+		GetData().enabled.store( enabled, std::memory_order_relaxed );
+	}
+
+	bool Profiler::IsEnabled() noexcept
+	{
+		return GetData().enabled.load( std::memory_order_relaxed );
+	}
+
+	uint64_t Profiler::Now() noexcept
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock_T::now() - GetData().start_time).count());
+	}
+
+	void Profiler::RecordCpuEvent( const char* name, uint64_t start_ns, uint64_t end_ns, uint32_t depth ) noexcept
+	{
+		auto& data = GetData();
+
+		// register as a writer, then make sure the buffer didn't stop being the current one in the meantime
+		EventBuffer* buffer;
+		for (;;)
+		{
+			const uint32_t buffer_idx = data.current_buffer.load();
+			buffer = &data.buffers[buffer_idx];
+			buffer->n_writers.fetch_add( 1 );
+			if (data.current_buffer.load() == buffer_idx)
+				break;
+			buffer->n_writers.fetch_sub( 1 );
+		}
+
+		const uint32_t idx = buffer->count.fetch_add( 1, std::memory_order_relaxed );
+		if (idx < MaxEventsPerFrame)
+			buffer->events[idx] = CpuEvent{ name ? name : "(unnamed)", start_ns, end_ns, GetThreadIdx( data ), depth };
+
+		buffer->n_writers.fetch_sub( 1, std::memory_order_release );
+	}
+
+	void Profiler::RecordGpuEvent( const char* name, uint64_t duration_ns )
+	{
+		auto& data = GetData();
+		std::scoped_lock lock( data.gpu_mutex );
+		data.pending_gpu_events.push_back( GpuEvent{ name ? name : "(unnamed)", duration_ns } );
+	}
+
+	void Profiler::NewFrame()
+	{
+		auto& data = GetData();
+		const auto now = Now();
+
+		// switch recording to the other buffer, scopes still open on other threads will land in the next frame.
+		// Its last writers were waited for by the previous call, threads only just registering on it back off.
+		const uint32_t finished_idx = data.current_buffer.load( std::memory_order_relaxed );
+		const uint32_t next_idx = finished_idx ^ 1u;
+		data.buffers[next_idx].count.store( 0 );
+		data.current_buffer.store( next_idx );
+
+		// copy the finished buffer into the history once the events already claimed in it have been written
+		auto& buffer = data.buffers[finished_idx];
+		while (buffer.n_writers.load( std::memory_order_acquire ) != 0)
+			std::this_thread::yield();
+		const uint32_t n_recorded = buffer.count.load( std::memory_order_acquire );
+		const uint32_t n_events = std::min( n_recorded, MaxEventsPerFrame );
+
+		auto& frame = data.history[data.history_head];
+		frame.index = data.frame_index++;
+		frame.start_ns = data.frame_start_ns;
+		frame.end_ns = now;
+		frame.cpu_events.assign( buffer.events.get(), buffer.events.get() + n_events );
+		frame.n_dropped_events = n_recorded - n_events;
+		{
+			std::scoped_lock lock( data.gpu_mutex );
+			frame.gpu_events.swap( data.pending_gpu_events );
+			data.pending_gpu_events.clear();
+		}
+
+		data.history_head = (data.history_head + 1) % HistoryLength;
+		data.history_count = std::min( data.history_count + 1, HistoryLength );
+		data.frame_start_ns = now;
+
+		if (data.capturing)
+		{
+			if (data.capture.size() < MaxCaptureFrames)
+				data.capture.push_back( frame );
+			else
+				AV_LOG_WARN( LoggingChannels::Application, "Profiler capture is full, stopping at {} frames", MaxCaptureFrames );
+		}
+	}
+
+	const Profiler::Frame& Profiler::GetLastFrame()
+	{
+		auto& data = GetData();
+		return data.history[(data.history_head + HistoryLength - 1) % HistoryLength];
+	}
+
+	void Profiler::GetFrameTimes( std::vector<float>& ms_out )
+	{
+		auto& data = GetData();
+		ms_out.clear();
+		ms_out.reserve( data.history_count );
+
+		const uint32_t oldest = (data.history_head + HistoryLength - data.history_count) % HistoryLength;
+		for (uint32_t i = 0; i < data.history_count; ++i)
+			ms_out.push_back( data.history[(oldest + i) % HistoryLength].GetDurationMs() );
+	}
+
+	void Profiler::BeginCapture()
+	{
+		auto& data = GetData();
+		data.capture.clear();
+		data.capturing = true;
+	}
+
+	bool Profiler::IsCapturing() noexcept
+	{
+		return GetData().capturing;
+	}
+
+	bool Profiler::EndCapture( const Filepath& path )
+	{
+		auto& data = GetData();
+		AV_ASSERT( data.capturing );
+		data.capturing = false;
+
+		const bool written = WriteChromeTrace( path, data.capture );
+		data.capture.clear();
+		data.capture.shrink_to_fit();
+		return written;
+	}
+
+	bool Profiler::WriteChromeTrace( const Filepath& path, const std::vector<Frame>& frames )
+	{
+		std::ofstream out( path, std::ios::out | std::ios::trunc );
+		if (!out)
+		{
+			AV_LOG_ERROR( LoggingChannels::Application, "Failed to open '{}' for the profiler trace", path.generic_string() );
+			return false;
+		}
+
+		// GPU timings have no start time on the CPU clock, they're laid end to end from the start of the frame they were reported in
+		constexpr uint32_t GpuThreadId = 1000;
+
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GpuThreadId << ",\"args\":{\"name\":\"GPU\"}}";
+
+		out.setf( std::ios::fixed );
+		out.precision( 3 );
+		for (const auto& frame : frames)
+		{
+			for (const auto& event : frame.cpu_events)
+			{
+				out << ",\n{\"name\":";
+				WriteJsonString( out, event.name );
+				out << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread_idx
+					<< ",\"ts\":" << event.start_ns / 1000.0 << ",\"dur\":" << (event.end_ns - event.start_ns) / 1000.0 << "}";
+			}
+
+			uint64_t gpu_ts = frame.start_ns;
+			for (const auto& event : frame.gpu_events)
+			{
+				out << ",\n{\"name\":";
+				WriteJsonString( out, event.name );
+				out << ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << GpuThreadId
+					<< ",\"ts\":" << gpu_ts / 1000.0 << ",\"dur\":" << event.duration_ns / 1000.0 << "}";
+				gpu_ts += event.duration_ns;
+			}
+		}
+		out << "\n]}\n";
+
+		AV_LOG_INFO( LoggingChannels::Application, "Wrote profiler trace of {} frames to '{}'", frames.size(), path.generic_string() );
+		return static_cast<bool>(out);
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <source_location>
+
+#include "Avokii/File/Filepath.hpp"
+
+namespace Avokii
+{
+	// Frame profiler, collects nested CPU scopes from any thread and GPU timings reported by the video plugin
+	//
+	// Scopes are recorded with the AV_PROFILE_* macros below, which compile to nothing when AV_ENABLE_PROFILING is 0.
+	// Recording is lock-free: finished scopes are appended to the current frame's fixed size buffer with an atomic counter,
+	// Core swaps the buffer once per frame and copies the finished frame into the history.
+	class Profiler final
+	{
+	public:
+		struct CpuEvent
+		{
+			const char* name; // must outlive the profiler, string literals and function names
+			uint64_t start_ns; // since the profiler started
+			uint64_t end_ns;
+			uint32_t thread_idx; // small sequential id, 0 is the first thread to record anything
+			uint32_t depth; // nesting depth on its thread
+		};
+
+		struct GpuEvent
+		{
+			const char* name;
+			uint64_t duration_ns;
+		};
+
+		struct Frame
+		{
+			uint64_t index = 0;
+			uint64_t start_ns = 0;
+			uint64_t end_ns = 0;
+			std::vector<CpuEvent> cpu_events; // in the order scopes finished, children before their parents
+			std::vector<GpuEvent> gpu_events; // timings that became available this frame, usually measured a few frames earlier
+			uint32_t n_dropped_events = 0; // scopes that didn't fit in MaxEventsPerFrame
+
+			float GetDurationMs() const noexcept { return static_cast<float>(end_ns - start_ns) / 1'000'000.f; }
+		};
+
+		static constexpr uint32_t MaxEventsPerFrame = 8192;
+		static constexpr uint32_t HistoryLength = 240;
+		static constexpr uint32_t MaxCaptureFrames = 3600;
+
+		class ScopedEvent final
+		{
+		public:
+			explicit ScopedEvent( const char* name ) noexcept;
+			~ScopedEvent();
+
+			ScopedEvent( const ScopedEvent& ) = delete;
+			ScopedEvent& operator=( const ScopedEvent& ) = delete;
+
+		private:
+			const char* mName; // null if the profiler was disabled when the scope started
+			uint64_t mStart;
+		};
+
+	public:
+		static void SetEnabled( bool enabled ) noexcept;
+		static bool IsEnabled() noexcept;
+
+		// Finishes the current frame and starts the next, called by Core once per frame on the main thread
+		static void NewFrame();
+
+		// Nanoseconds since the profiler started
+		static uint64_t Now() noexcept;
+
+		static void RecordCpuEvent( const char* name, uint64_t start_ns, uint64_t end_ns, uint32_t depth ) noexcept;
+		// From the video plugin's thread
+		static void RecordGpuEvent( const char* name, uint64_t duration_ns );
+
+		// Most recently finished frame
+		static const Frame& GetLastFrame();
+		// Durations of the frames in the history, oldest first
+		static void GetFrameTimes( std::vector<float>& ms_out );
+
+		// Keeps every frame until EndCapture(), which writes them as a Chrome trace (chrome://tracing, Perfetto)
+		static void BeginCapture();
+		static bool IsCapturing() noexcept;
+		static bool EndCapture( const Filepath& path );
+
+		static bool WriteChromeTrace( const Filepath& path, const std::vector<Frame>& frames );
+	};
+}
+
+#if (AV_ENABLE_PROFILING == 1)
+#	define AV_INTERNAL_PROFILE_CONCAT_IMPL(a, b) a##b
+#	define AV_INTERNAL_PROFILE_CONCAT(a, b) AV_INTERNAL_PROFILE_CONCAT_IMPL(a, b)
+
+// Times the enclosing scope, `name` must outlive the profiler (e.g. a string literal)
+#	define AV_PROFILE_SCOPE(name) ::Avokii::Profiler::ScopedEvent AV_INTERNAL_PROFILE_CONCAT(av_profile_scope_, __LINE__){ name }
+#	define AV_PROFILE_FUNCTION() AV_PROFILE_SCOPE( std::source_location::current().function_name() )
+#	define AV_PROFILE_NEW_FRAME() ::Avokii::Profiler::NewFrame()
+
+// GPU timings through the video plugin, GPU scopes can't nest
+#	define AV_PROFILE_GPU_BEGIN(video, name) (video).BeginGpuScope( name )
+#	define AV_PROFILE_GPU_END(video) (video).EndGpuScope()
+#else
+#	define AV_PROFILE_SCOPE(name) do {} while(0)
+#	define AV_PROFILE_FUNCTION() do {} while(0)
+#	define AV_PROFILE_NEW_FRAME() do {} while(0)
+#	define AV_PROFILE_GPU_BEGIN(video, name) do {} while(0)
+#	define AV_PROFILE_GPU_END(video) do {} while(0)
+#endif
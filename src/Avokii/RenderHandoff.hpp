@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+
+namespace Avokii
+{
+	// Double buffered state handed from a game's updates to its rendering
+	//
+	// The updates write the back buffer, OnRender() reads the front one, and AbstractGame::OnRenderHandoff() calls Publish()
+	// to swap them. With pipelined rendering the updates of the next frame run while the current one renders,
+	// the buffers keep the two apart without locking. The back buffer holds the frame before last after a swap,
+	// so write it whole each frame.
+	template<class T>
+	class RenderHandoff final
+	{
+	public:
+		[[nodiscard]] T& rGetBack() noexcept { return mBuffers[mFront ^ 1]; }
+		[[nodiscard]] const T& GetFront() const noexcept { return mBuffers[mFront]; }
+
+		// Only while neither side is running, which is where Core calls OnRenderHandoff()
+		void Publish() noexcept { mFront ^= 1; }
+
+	private:
+		std::array<T, 2> mBuffers{};
+		unsigned mFront = 0;
+	};
+}
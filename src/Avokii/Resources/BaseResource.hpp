@@ -6,6 +6,22 @@ namespace Avokii
 {
 	enum class AssetType;
 
+	// Memory held by a resource, used by the caches to stay within their byte budgets
+	struct ResourceFootprint
+	{
+		size_t cpu_bytes = 0;
+		size_t gpu_bytes = 0;
+
+		constexpr size_t GetTotal() const noexcept { return cpu_bytes + gpu_bytes; }
+	};
+
+	// Resources in other caches that reference a resource and are only referenced by their own cache, see Concepts::CompositeResource
+	struct ResourceDependents
+	{
+		long n_references = 0;
+		size_t generation = 0; // latest generation any of them was looked up
+	};
+
 	class BaseResource
 	{
 	public:
@@ -13,6 +29,9 @@ namespace Avokii
 		
 		StringView GetAssetId() const noexcept { return mAssetId.has_value() ? *mAssetId : StringView{}; }
 		ResourceId GetResourceId() const noexcept { return mResourceId; }
+
+		// Approximate, measured once when the resource is added to its cache
+		virtual ResourceFootprint GetFootprint() const noexcept { return {}; }
 	
 	protected:
 		BaseResource() = default;
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <memory>
+
 namespace Avokii
 {
 	class BaseResource;
+	class ResourceLoader;
+	struct ResourceDependents;
 
 	namespace Concepts
 	{
@@ -17,5 +21,42 @@ namespace Avokii
 			//{ T::GetResourceType() } noexcept -> std::same_as<::Resources::AssetType>;
 			//{ T::LoadResource( std::declval<ResourceLoader>() ) } -> std::convertible_to<std::shared_ptr<const T>>;
 		};
+
+		// Resources that can be loaded off the main thread by ResourceManager::LoadAsync().
+		// DecodeResource() runs on a worker thread and must not touch the video API or the resource caches,
+		// FinaliseResource() runs on the main thread and creates the resource from the decoded data.
+		template<class T>
+		concept AsyncResource = Resource<T> && requires( ResourceLoader& loader, typename T::DecodedData&& data )
+		{
+			{ T::DecodeResource( loader ) } -> std::same_as<typename T::DecodedData>;
+			{ T::FinaliseResource( loader, std::move( data ) ) } -> std::same_as<std::shared_ptr<T>>;
+		};
+
+		// Resources that hot reloading can update in place, ReloadFrom() takes the data of a freshly loaded replacement.
+		// Called on the main thread between frames, existing handles to the resource see the new data.
+		template<class T>
+		concept ReloadableResource = Resource<T> && requires( T& existing, T& replacement )
+		{
+			{ existing.ReloadFrom( replacement ) } -> std::same_as<bool>;
+		};
+
+		// Resources whose cache keeps a T::CacheIndex up to date as they're cached and uncached.
+		// Both hooks are called with a cache shard locked, possibly from several threads at once.
+		template<class T>
+		concept IndexedResource = Resource<T> && requires( typename T::CacheIndex& index, const std::shared_ptr<const T>& resource )
+		{
+			index.OnAdded( resource );
+			index.OnErased( *resource );
+		};
+
+		// Resources cached along with resources in other caches that reference them, as a sprite sheet is with its sprites.
+		// The cache doesn't count references from dependents that nothing else references as uses of the resource,
+		// and UncacheDependents() is called to release them as the resource is evicted or purged.
+		template<class T>
+		concept CompositeResource = Resource<T> && requires( const T& resource )
+		{
+			{ resource.GetUnreferencedDependents() } -> std::same_as<ResourceDependents>;
+			resource.UncacheDependents();
+		};
 	}
 }
@@ -1,36 +1,44 @@
 #include "ResourceCache.hpp"
 
 #include <algorithm>
-#include <execution>
+#include <bit>
+#include <mutex>
 
-#include "Avokii/Containers/ContainerOperations.hpp"
 #include "BaseResource.hpp"
 #include "ResourceLoader.hpp"
 
-using namespace Avokii::ContainerOps;
-
 namespace Avokii
 {
-	BaseResourceCache::BaseResourceCache( ResourceManager& manager, const AssetType type )
+	BaseResourceCache::BaseResourceCache( ResourceManager& manager, const AssetType type, size_t n_shards )
 		: mManager{ manager }
 		, mAssetType{ type }
+		, mShardMask{ std::clamp<size_t>( std::bit_floor( n_shards ), 1, MaxShardCount ) - 1 }
 	{
+		AV_ASSERT( n_shards > 0 && n_shards <= MaxShardCount && std::has_single_bit( n_shards ), "Shard count must be a power of two up to MaxShardCount" );
 	}
 
 	BaseResourceCache::~BaseResourceCache()
 	{
-		mResources.clear();
+		for (auto& shard : mShards)
+			shard.resources.clear();
 	}
 
 	bool BaseResourceCache::Exists( ResourceId resource_id ) const noexcept
 	{
-		return mResources.find( resource_id ) != std::end( mResources );
+		const auto& shard = GetShard( resource_id );
+		std::shared_lock lock( shard.mutex );
+		return shard.resources.find( resource_id ) != std::end( shard.resources );
 	}
 
 	BaseResourceCache::UntypedResourcePtr BaseResourceCache::GetUntyped( ResourceId resource_id ) const noexcept
 	{
-		if (const auto found = mResources.find( resource_id ); found != std::end( mResources ))
+		const auto& shard = GetShard( resource_id );
+		std::shared_lock lock( shard.mutex );
+		if (const auto found = shard.resources.find( resource_id ); found != std::end( shard.resources ))
+		{
+			found->second.generation.store( mCurrentGeneration.load( std::memory_order_relaxed ), std::memory_order_relaxed );
 			return found->second.resource;
+		}
 		
 		return UntypedResourcePtr{};
 	}
@@ -45,42 +53,249 @@ namespace Avokii
 			loaded_resource->mResourceId = loader.GetResourceId();
 
 			AV_ASSERT( loaded_resource->GetResourceId() != ResourceId{} );
-			return AddResource( loaded_resource );
+			return AddOrGetExisting( std::move( loaded_resource ) );
 		}
 
 		AV_LOG_ERROR( LoggingChannels::Resource, "Failed to load asset with id '{}'", asset_id );
 		return UntypedResourcePtr{};
 	}
 
+	size_t BaseResourceCache::AddResources( std::span<NewResource> resources )
+	{
+		std::array<std::vector<size_t>, MaxShardCount> by_shard;
+		for (size_t i = 0; i < resources.size(); ++i)
+		{
+			auto& [asset_id, resource] = resources[i];
+			AV_ASSERT( resource );
+			if (!resource)
+				continue;
+
+			resource->mAssetId = String{ asset_id };
+			resource->mResourceId = ToResourceId( asset_id );
+			by_shard[GetShardIdx( resource->mResourceId )].push_back( i );
+		}
+
+		const size_t generation = mCurrentGeneration.load( std::memory_order_relaxed );
+		size_t n_added = 0;
+		for (size_t shard_idx = 0; shard_idx < GetShardCount(); ++shard_idx)
+		{
+			if (by_shard[shard_idx].empty())
+				continue;
+
+			auto& shard = mShards[shard_idx];
+			std::unique_lock lock( shard.mutex );
+			for (const size_t i : by_shard[shard_idx])
+			{
+				auto& resource = resources[i].resource;
+				const auto [it, success] = shard.resources.try_emplace( resource->GetResourceId(), std::move( resource ), generation );
+				if (success)
+				{
+					OnAdded( it->second );
+					++n_added;
+				}
+			}
+		}
+
+		return n_added;
+	}
+
+	BaseResourceCache::Finaliser_T BaseResourceCache::DecodeUntyped( StringView asset_id ) const
+	{
+		ResourceLoader loader{ mManager, asset_id };
+		return DecodeResource( loader );
+	}
+
+	BaseResourceCache::UntypedResourcePtr BaseResourceCache::FinaliseUntyped( StringView asset_id, const Finaliser_T& finaliser )
+	{
+		AV_ASSERT( finaliser );
+
+		ResourceLoader loader{ mManager, asset_id };
+		if (auto existing = GetUntyped( loader.GetResourceId() ))
+			return existing;
+
+		if (auto loaded_resource = finaliser( loader ))
+		{
+			loaded_resource->mAssetId = loader.GetAssetId();
+			loaded_resource->mResourceId = loader.GetResourceId();
+
+			AV_ASSERT( loaded_resource->GetResourceId() != ResourceId{} );
+			return AddOrGetExisting( std::move( loaded_resource ) );
+		}
+
+		AV_LOG_ERROR( LoggingChannels::Resource, "Failed to load asset with id '{}'", asset_id );
+		return UntypedResourcePtr{};
+	}
+
+	bool BaseResourceCache::ReloadUntyped( StringView asset_id, const Finaliser_T& finaliser )
+	{
+		AV_ASSERT( finaliser );
+
+		ResourceLoader loader{ mManager, asset_id };
+		const auto replacement = finaliser( loader );
+		if (!replacement)
+			return false;
+
+		auto& shard = GetShard( loader.GetResourceId() );
+		std::unique_lock lock( shard.mutex );
+		const auto found = shard.resources.find( loader.GetResourceId() );
+		if (found == std::end( shard.resources ))
+			return false;
+
+		// taken out and put back so the byte counts and the cache index see the new data
+		auto& entry = found->second;
+		OnErased( entry );
+		// every cached resource was created non-const by a loader
+		const bool reloaded = ReloadResource( const_cast<BaseResource&>(*entry.resource), *replacement );
+		entry.footprint = entry.resource->GetFootprint();
+		OnAdded( entry );
+
+		return reloaded;
+	}
+
 	void BaseResourceCache::Unload( ResourceId resource_id )
 	{
-		if (const auto found = mResources.find( resource_id ); found != std::end( mResources ))
-			mResources.erase( found );
+		auto& shard = GetShard( resource_id );
+		std::unique_lock lock( shard.mutex );
+		if (const auto found = shard.resources.find( resource_id ); found != std::end( shard.resources ))
+		{
+			OnErased( found->second );
+			shard.resources.erase( found );
+		}
 	}
 
 	void BaseResourceCache::Purge( size_t min_generations )
 	{
-		const auto generation_threshold = std::min( mCurrentGeneration, mCurrentGeneration - min_generations );
+		const size_t current_generation = mCurrentGeneration.load( std::memory_order_relaxed );
+		const auto generation_threshold = std::min( current_generation, current_generation - min_generations );
 
-		const auto old_size = mResources.size();
-		for (auto it = std::begin( mResources ), last = std::end( mResources ); it != last; )
+		size_t n_purged = 0;
+		for (auto& shard : mShards)
 		{
-			if (it->second.generation < generation_threshold)
-				it = mResources.erase( it );
-			else
-				++it;
+			std::unique_lock lock( shard.mutex );
+			for (auto it = std::begin( shard.resources ), last = std::end( shard.resources ); it != last; )
+			{
+				ResourceDependents dependents;
+				if (IsUnreferenced( it->second, dependents )
+					&& (std::max( it->second.generation.load( std::memory_order_relaxed ), dependents.generation ) < generation_threshold)
+					&& ReleaseForEviction( it->second ))
+				{
+					OnErased( it->second );
+					it = shard.resources.erase( it );
+					++n_purged;
+				}
+				else
+					++it;
+			}
 		}
 		
-		AV_LOG_INFO( LoggingChannels::Resource, "Purged '{}' old resources from {} cache", old_size - mResources.size(), GetAssetTypeName( mAssetType ) );
+		AV_LOG_INFO( LoggingChannels::Resource, "Purged '{}' old resources from {} cache", n_purged, GetAssetTypeName( mAssetType ) );
 	}
 
 	void BaseResourceCache::NextGeneration()
 	{
-		std::for_each( std::execution::par_unseq, std::begin( mResources ), std::end( mResources ), [ g=this->mCurrentGeneration ]( ResourceHashmap_T::value_type& entry )
+		// lookups stamp the generation, whether a resource is still referenced is only checked when something is evicted
+		mCurrentGeneration.fetch_add( 1, std::memory_order_relaxed );
+
+		if (const size_t budget = GetByteBudget(); (budget > 0) && (GetUsage().GetTotal() > budget))
+		{
+			const size_t freed = EvictTo( budget );
+			AV_LOG_TRACE( LoggingChannels::Resource, "Evicted {} bytes from {} cache to fit its budget of {} bytes", freed, GetAssetTypeName( mAssetType ), budget );
+		}
+	}
+
+	ResourceFootprint BaseResourceCache::GetUsage() const noexcept
+	{
+		return ResourceFootprint{ .cpu_bytes = mCpuBytes.load( std::memory_order_relaxed ), .gpu_bytes = mGpuBytes.load( std::memory_order_relaxed ) };
+	}
+
+	void BaseResourceCache::CollectEvictionCandidates( std::vector<EvictionCandidate>& out )
+	{
+		const size_t current_generation = mCurrentGeneration.load( std::memory_order_relaxed );
+		for (auto& shard : mShards)
+		{
+			std::shared_lock lock( shard.mutex );
+			for (const auto& [resource_id, entry] : shard.resources)
 			{
-				if (entry.second.resource.use_count() > 1)
-					entry.second.generation = g;
-			} );
+				// dependents' lookups count as the resource's
+				if (ResourceDependents dependents; IsUnreferenced( entry, dependents ))
+					out.push_back( EvictionCandidate{ std::max( entry.generation.load( std::memory_order_relaxed ), dependents.generation ), entry.footprint.GetTotal(), resource_id, this } );
+				else // still in use, so not released before the candidates that are
+					entry.generation.store( current_generation, std::memory_order_relaxed );
+			}
+		}
+	}
+
+	size_t BaseResourceCache::Evict( ResourceId resource_id )
+	{
+		auto& shard = GetShard( resource_id );
+		std::unique_lock lock( shard.mutex );
+
+		// may have been picked up again since it was collected
+		const auto found = shard.resources.find( resource_id );
+		if (found == std::end( shard.resources ))
+			return 0;
+
+		ResourceDependents dependents;
+		if (!IsUnreferenced( found->second, dependents ) || !ReleaseForEviction( found->second ))
+			return 0;
+
+		const size_t bytes = found->second.footprint.GetTotal();
+		OnErased( found->second );
+		shard.resources.erase( found );
+		return bytes;
+	}
+
+	size_t BaseResourceCache::EvictTo( size_t target_bytes )
+	{
+		std::vector<EvictionCandidate> candidates;
+		CollectEvictionCandidates( candidates );
+		std::sort( std::begin( candidates ), std::end( candidates ), []( const EvictionCandidate& a, const EvictionCandidate& b ) { return a.generation < b.generation; } );
+
+		size_t freed = 0;
+		for (const auto& candidate : candidates)
+		{
+			if (GetUsage().GetTotal() <= target_bytes)
+				break;
+
+			freed += Evict( candidate.resource_id );
+		}
+
+		return freed;
+	}
+
+	bool BaseResourceCache::IsUnreferenced( const ResourceEntry& entry, ResourceDependents& dependents ) const
+	{
+		const long use_count = entry.resource.use_count();
+		if (use_count == 1)
+			return true;
+
+		// only composite resources have dependents, and only dependents can hold the rest of the references
+		dependents = GetUnreferencedDependents( *entry.resource );
+		return (dependents.n_references > 0) && (use_count == 1 + dependents.n_references);
+	}
+
+	bool BaseResourceCache::ReleaseForEviction( const ResourceEntry& entry )
+	{
+		if (entry.resource.use_count() == 1)
+			return true;
+
+		UncacheDependents( *entry.resource );
+		// a dependent may have been picked up since it was counted, the resource stays cached for it
+		return entry.resource.use_count() == 1;
+	}
+
+	void BaseResourceCache::OnAdded( const ResourceEntry& entry ) noexcept
+	{
+		mCpuBytes.fetch_add( entry.footprint.cpu_bytes, std::memory_order_relaxed );
+		mGpuBytes.fetch_add( entry.footprint.gpu_bytes, std::memory_order_relaxed );
+		OnResourceAdded( entry.resource );
+	}
+
+	void BaseResourceCache::OnErased( const ResourceEntry& entry ) noexcept
+	{
+		mCpuBytes.fetch_sub( entry.footprint.cpu_bytes, std::memory_order_relaxed );
+		mGpuBytes.fetch_sub( entry.footprint.gpu_bytes, std::memory_order_relaxed );
+		OnResourceErased( *entry.resource );
 	}
 
 	BaseResourceCache::UntypedResourcePtr BaseResourceCache::AddResource( UntypedResourcePtr& new_resource )
@@ -94,9 +309,14 @@ namespace Avokii
 		if (resource_id == ResourceId{})
 			return nullptr;
 
-		auto [it, success] = mResources.try_emplace( resource_id, new_resource, mCurrentGeneration );
+		auto& shard = GetShard( resource_id );
+		std::unique_lock lock( shard.mutex );
+		auto [it, success] = shard.resources.try_emplace( resource_id, new_resource, mCurrentGeneration.load( std::memory_order_relaxed ) );
 		if (success)
+		{
+			OnAdded( it->second );
 			return it->second.resource;
+		}
 
 		AV_ASSERT( false, "Failed to add resource, does a resource with the given id already exist?" );
 		return nullptr;
@@ -113,24 +333,32 @@ namespace Avokii
 		if (resource_id == ResourceId{})
 			return nullptr;
 
-		auto [it, success] = mResources.try_emplace( resource_id, new_resource, mCurrentGeneration );
+		auto& shard = GetShard( resource_id );
+		std::unique_lock lock( shard.mutex );
+		auto [it, success] = shard.resources.try_emplace( resource_id, new_resource, mCurrentGeneration.load( std::memory_order_relaxed ) );
 		if (success)
+		{
+			OnAdded( it->second );
 			return it->second.resource;
+		}
 
 		AV_ASSERT( false, "Failed to add resource, does a resource with the given id already exist?" );
 		return nullptr;
 	}
 
-	BaseResourceCache::UntypedResourcePtr BaseResourceCache::FindIf( const std::function<bool( const BaseResource& )>& pred ) const
+	BaseResourceCache::UntypedResourcePtr BaseResourceCache::AddOrGetExisting( UntypedResourcePtr new_resource )
 	{
-		const auto pred_wrapper = [&]( const ResourceHashmap_T::value_type& entry ) -> bool
-		{
-			return pred( *entry.second.resource );
-		};
+		AV_ASSERT( new_resource );
+		const ResourceId resource_id{ new_resource->GetResourceId() };
 
-		if (const auto found = ContainerOps::FindIf( mResources, pred_wrapper ); found != std::end( mResources ))
-			return found->second.resource;
+		auto& shard = GetShard( resource_id );
+		std::unique_lock lock( shard.mutex );
+		auto [it, success] = shard.resources.try_emplace( resource_id, std::move( new_resource ), mCurrentGeneration.load( std::memory_order_relaxed ) );
+		if (success)
+			OnAdded( it->second );
+		else
+			AV_LOG_TRACE( LoggingChannels::Resource, "Resource '{}' was loaded by another thread first, keeping the existing one", it->second.resource->GetAssetId() );
 
-		return nullptr;
+		return it->second.resource;
 	}
 }
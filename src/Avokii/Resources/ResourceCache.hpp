@@ -1,19 +1,33 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
 #include <string>
-#include <unordered_map>
 
+#include "Avokii/Containers/FlatHashMap.hpp"
+
+#include "BaseResource.hpp"
 #include "Concepts.hpp"
 #include "ResourceId.hpp"
 #include "ResourceTypes.hpp"
 
 namespace Avokii
 {
-	class BaseResource;
 	class ResourceLoader;
 	class ResourceManager;
 
+	// Safe to use from any thread.
+	// Entries are split over shards by ResourceId, each with its own reader-writer lock,
+	// so lookups only contend with writers to the same shard. MaxShardCount unless constructed with fewer.
+	//
+	// Given a byte budget, NextGeneration() evicts unreferenced resources least recently used first
+	// until the cache fits again. Resources still referenced outside the cache are never evicted or purged,
+	// except that references from cached dependents only the cache references don't count (a sheet's cached sprites,
+	// see Concepts::CompositeResource), those are evicted along with it.
 	class BaseResourceCache
 	{
 	protected:
@@ -21,30 +35,143 @@ namespace Avokii
 		using UntypedNonConstResourcePtr = std::shared_ptr<BaseResource>;
 
 	public:
-		explicit BaseResourceCache( ResourceManager& manager, const AssetType type );
+		// The main thread half of an asynchronous load, returned by DecodeUntyped()
+		using Finaliser_T = std::function<UntypedNonConstResourcePtr( ResourceLoader& )>;
+
+	public:
+		static constexpr size_t MaxShardCount = 16;
+
+		// `n_shards` is a power of two up to MaxShardCount, fewer only for comparing against
+		explicit BaseResourceCache( ResourceManager& manager, const AssetType type, size_t n_shards = MaxShardCount );
 		virtual ~BaseResourceCache();
 
 		[[nodiscard]] AssetType GetResourceType() const noexcept { return mAssetType; }
+		[[nodiscard]] size_t GetShardCount() const noexcept { return mShardMask + 1; }
 
 		[[nodiscard]] bool Exists( ResourceId resource_id ) const noexcept;
 		[[nodiscard]] UntypedResourcePtr GetUntyped( ResourceId resource_id ) const noexcept;
 
 		UntypedResourcePtr LoadUntyped( StringView asset_id );
+
+		struct NewResource
+		{
+			StringView asset_id;
+			UntypedNonConstResourcePtr resource;
+		};
+		// Adds resources created outside the cache, such as the sprites of a sprite sheet, locking each shard once.
+		// Ids that are already cached keep the existing resource. Returns the number added.
+		size_t AddResources( std::span<NewResource> resources );
+		// Asynchronous loading in two halves, DecodeUntyped() is safe to call from any thread.
+		// FinaliseUntyped() runs the returned finaliser on the main thread and adds the resource,
+		// unless it was loaded synchronously in the meantime.
+		[[nodiscard]] Finaliser_T DecodeUntyped( StringView asset_id ) const;
+		UntypedResourcePtr FinaliseUntyped( StringView asset_id, const Finaliser_T& finaliser );
+
+		// Whether resources of this type can be reloaded in place, see Concepts::ReloadableResource
+		[[nodiscard]] virtual bool IsReloadable() const noexcept { return false; }
+		// Runs the finaliser and moves the result into the cached resource. Fails if the resource is no longer cached.
+		bool ReloadUntyped( StringView asset_id, const Finaliser_T& finaliser );
 		void Unload( ResourceId resource_id );
 		/// <summary>
 		/// Unload resources that currently aren't being used.
 		/// </summary>
-		/// <param name="min_generations">Minimum number of generations this resource hasn't been used</param>
+		/// <param name="min_generations">Minimum number of generations this resource hasn't been looked up</param>
 		void Purge( size_t min_generations = 3 );
 
+		// Starts the next generation and evicts down to the budget. Called once per frame by the ResourceManager,
+		// cheap unless over budget as only lookups mark resources used.
 		void NextGeneration();
 
+#pragma region Memory budget
+		[[nodiscard]] ResourceFootprint GetUsage() const noexcept;
+		// 0 for no budget
+		void SetByteBudget( size_t bytes ) noexcept { mByteBudget.store( bytes, std::memory_order_relaxed ); }
+		[[nodiscard]] size_t GetByteBudget() const noexcept { return mByteBudget.load( std::memory_order_relaxed ); }
+
+		struct EvictionCandidate
+		{
+			size_t generation;
+			size_t bytes;
+			ResourceId resource_id;
+			BaseResourceCache* cache;
+		};
+		// Appends every resource that isn't referenced outside the cache
+		void CollectEvictionCandidates( std::vector<EvictionCandidate>& out );
+		// Evicts the resource if it's still unreferenced, returns the bytes freed
+		size_t Evict( ResourceId resource_id );
+		// Evicts unreferenced resources least recently used first until at most `target_bytes` are held, returns the bytes freed
+		size_t EvictTo( size_t target_bytes );
+
+		// For CompositeResource::GetUnreferencedDependents(), counts the cached resources among `resource_ids` that nothing outside
+		// the cache references and `pred` accepts
+		template<std::predicate<const BaseResource&> Pred>
+		[[nodiscard]] ResourceDependents CountUnreferenced( std::span<const ResourceId> resource_ids, Pred&& pred ) const
+		{
+			ResourceDependents dependents;
+			for (const ResourceId resource_id : resource_ids)
+			{
+				const auto& shard = GetShard( resource_id );
+				std::shared_lock lock( shard.mutex );
+				const auto found = shard.resources.find( resource_id );
+				if ((found == std::end( shard.resources )) || (found->second.resource.use_count() != 1) || !pred( *found->second.resource ))
+					continue;
+
+				++dependents.n_references;
+				dependents.generation = std::max( dependents.generation, found->second.generation.load( std::memory_order_relaxed ) );
+			}
+			return dependents;
+		}
+		// For CompositeResource::UncacheDependents(), evicts the resources counted by CountUnreferenced()
+		template<std::predicate<const BaseResource&> Pred>
+		void EvictUnreferenced( std::span<const ResourceId> resource_ids, Pred&& pred )
+		{
+			for (const ResourceId resource_id : resource_ids)
+			{
+				auto& shard = GetShard( resource_id );
+				std::unique_lock lock( shard.mutex );
+				const auto found = shard.resources.find( resource_id );
+				if ((found == std::end( shard.resources )) || (found->second.resource.use_count() != 1) || !pred( *found->second.resource ))
+					continue;
+
+				OnErased( found->second );
+				shard.resources.erase( found );
+			}
+		}
+#pragma endregion
+
 	protected:
 		UntypedResourcePtr AddResource( UntypedResourcePtr& new_resource );
 		UntypedResourcePtr AddResource( UntypedNonConstResourcePtr& new_resource );
 		[[nodiscard]] virtual UntypedNonConstResourcePtr LoadResource( ResourceLoader& loader ) const = 0;
+		[[nodiscard]] virtual Finaliser_T DecodeResource( ResourceLoader& loader ) const = 0;
+
+		// Templated rather than a std::function so the predicate can be inlined into the scan
+		template<std::predicate<const BaseResource&> Pred>
+		[[nodiscard]] UntypedResourcePtr FindIf( Pred&& pred ) const
+		{
+			for (const auto& shard : mShards)
+			{
+				std::shared_lock lock( shard.mutex );
+				for (const auto& [resource_id, entry] : shard.resources)
+				{
+					if (pred( *entry.resource ))
+						return entry.resource;
+				}
+			}
+
+			return nullptr;
+		}
 
-		[[nodiscard]] UntypedResourcePtr FindIf( const std::function<bool( const BaseResource& )>& pred ) const;
+		// Moves `replacement`'s data into `existing`, called with the resource's shard exclusively locked
+		virtual bool ReloadResource( BaseResource& existing, BaseResource& replacement ) const { (void)existing; (void)replacement; return false; }
+
+		// Called with the resource's shard locked as it enters and leaves the cache
+		virtual void OnResourceAdded( const UntypedResourcePtr& resource ) { (void)resource; }
+		virtual void OnResourceErased( const BaseResource& resource ) { (void)resource; }
+
+		// See Concepts::CompositeResource, called with the resource's shard locked
+		virtual ResourceDependents GetUnreferencedDependents( const BaseResource& resource ) const { (void)resource; return {}; }
+		virtual void UncacheDependents( const BaseResource& resource ) { (void)resource; }
 
 	private:
 		ResourceManager& mManager;
@@ -52,19 +179,65 @@ namespace Avokii
 
 		struct ResourceEntry
 		{
-			size_t generation;
+			// last generation the resource was looked up or referenced, written under a shared lock by lookups
+			mutable std::atomic<size_t> generation;
 			UntypedResourcePtr resource;
+			ResourceFootprint footprint;
 
 			ResourceEntry( UntypedResourcePtr ptr, size_t generation )
-				: resource{ std::move( ptr ) }, generation{ generation }
+				: generation{ generation }, resource{ std::move( ptr ) }
+			{
+				footprint = resource->GetFootprint();
+			}
+
+			// moved when the shard's map grows, always under the shard's exclusive lock
+			ResourceEntry( ResourceEntry&& other ) noexcept
+				: generation{ other.generation.load( std::memory_order_relaxed ) }
+				, resource{ std::move( other.resource ) }
+				, footprint{ other.footprint }
 			{}
 		};
-		using ResourceHashmap_T = std::unordered_map<ResourceId, ResourceEntry>;
+		using ResourceHashmap_T = FlatHashMap<ResourceId, ResourceEntry>;
+
+		// Adds the resource, or returns the existing one if another thread added the same id first
+		UntypedResourcePtr AddOrGetExisting( UntypedResourcePtr new_resource );
+
+		// Whether only the cache and its unreferenced dependents reference the entry, `dependents` is filled in if so
+		bool IsUnreferenced( const ResourceEntry& entry, ResourceDependents& dependents ) const;
+		// Releases the entry's dependents, then whether it can be erased. Called with its shard exclusively locked.
+		bool ReleaseForEviction( const ResourceEntry& entry );
 
-		ResourceHashmap_T mResources;
-		size_t mCurrentGeneration{ 0 };
+		void OnAdded( const ResourceEntry& entry ) noexcept;
+		void OnErased( const ResourceEntry& entry ) noexcept;
+
+		struct alignas(64) Shard
+		{
+			mutable std::shared_mutex mutex;
+			ResourceHashmap_T resources;
+		};
+
+		size_t GetShardIdx( ResourceId resource_id ) const noexcept { return resource_id.value() & mShardMask; }
+		Shard& GetShard( ResourceId resource_id ) noexcept { return mShards[GetShardIdx( resource_id )]; }
+		const Shard& GetShard( ResourceId resource_id ) const noexcept { return mShards[GetShardIdx( resource_id )]; }
+
+		std::array<Shard, MaxShardCount> mShards;
+		const size_t mShardMask;
+		std::atomic<size_t> mCurrentGeneration{ 0 };
+
+		std::atomic<size_t> mByteBudget{ 0 };
+		std::atomic<size_t> mCpuBytes{ 0 };
+		std::atomic<size_t> mGpuBytes{ 0 };
 	};
 
+	namespace detail
+	{
+		template<class R>
+		struct CacheIndexOf { struct type {}; };
+
+		template<Concepts::IndexedResource R>
+		struct CacheIndexOf<R> { using type = typename R::CacheIndex; };
+	}
+
 	template<Concepts::Resource R>
 	class ResourceCache final
 		: public BaseResourceCache
@@ -73,32 +246,35 @@ namespace Avokii
 		using ResourcePtr = std::shared_ptr<const R>;
 
 	public:
-		ResourceCache( ResourceManager& manager )
-			: BaseResourceCache( manager, R::GetResourceType() )
+		ResourceCache( ResourceManager& manager, size_t n_shards = MaxShardCount )
+			: BaseResourceCache( manager, R::GetResourceType(), n_shards )
 		{}
 		virtual ~ResourceCache() {}
 
 		[[nodiscard]] ResourcePtr Get( ResourceId resource_id ) const
 		{
-			return std::dynamic_pointer_cast<const R>(GetUntyped( resource_id ));
+			// everything in this cache was created by R::LoadResource() or added as an R
+			return std::static_pointer_cast<const R>(GetUntyped( resource_id ));
 		}
 
 		[[nodiscard]] ResourcePtr Load( StringView asset_id )
 		{
-			return std::dynamic_pointer_cast<const R>(LoadUntyped( asset_id ));
+			return std::static_pointer_cast<const R>(LoadUntyped( asset_id ));
 		}
 
-		[[nodiscard]] ResourcePtr FindIf( const std::function<bool( const R& )>& pred ) const
+		[[nodiscard]] const typename detail::CacheIndexOf<R>::type& GetIndex() const noexcept requires Concepts::IndexedResource<R> { return mIndex; }
+
+		[[nodiscard]] virtual bool IsReloadable() const noexcept override { return Concepts::ReloadableResource<R>; }
+
+		template<std::predicate<const R&> Pred>
+		[[nodiscard]] ResourcePtr FindIf( Pred&& pred ) const
 		{
 			const auto predicate_wrapper = [&pred]( const BaseResource& entry ) -> bool
 			{
-				return pred( dynamic_cast<const R&>(entry) );
+				return pred( static_cast<const R&>(entry) );
 			};
 
-			if (const auto it = BaseResourceCache::FindIf( predicate_wrapper ))
-				return std::dynamic_pointer_cast<const R>(it);
-
-			return nullptr;
+			return std::static_pointer_cast<const R>(BaseResourceCache::FindIf( predicate_wrapper ));
 		}
 
 		[[nodiscard]] virtual UntypedNonConstResourcePtr LoadResource( ResourceLoader& loader ) const override
@@ -106,10 +282,83 @@ namespace Avokii
 			if (auto loaded_resource = R::LoadResource( loader ))
 			{
 				static_assert(std::is_same<decltype(loaded_resource), std::shared_ptr<R>>::value, "R::LoadResource() returns the wrong type, expected a std::shared_ptr<const R>");
-				return std::dynamic_pointer_cast<BaseResource>(loaded_resource);
+				return loaded_resource;
 			}
 
 			return UntypedNonConstResourcePtr{};
 		}
+
+		[[nodiscard]] virtual Finaliser_T DecodeResource( ResourceLoader& loader ) const override
+		{
+			if constexpr (Concepts::AsyncResource<R>)
+			{
+				// std::function needs a copyable callable
+				auto decoded = std::make_shared<typename R::DecodedData>( R::DecodeResource( loader ) );
+				return [decoded]( ResourceLoader& main_thread_loader ) -> UntypedNonConstResourcePtr
+				{
+					return R::FinaliseResource( main_thread_loader, std::move( *decoded ) );
+				};
+			}
+			else
+			{
+				// nothing can be done off the main thread
+				(void)loader;
+				return [this]( ResourceLoader& main_thread_loader ) -> UntypedNonConstResourcePtr
+				{
+					return LoadResource( main_thread_loader );
+				};
+			}
+		}
+
+	protected:
+		virtual bool ReloadResource( BaseResource& existing, BaseResource& replacement ) const override
+		{
+			if constexpr (Concepts::ReloadableResource<R>)
+				return static_cast<R&>(existing).ReloadFrom( static_cast<R&>(replacement) );
+			else
+			{
+				(void)existing;
+				(void)replacement;
+				return false;
+			}
+		}
+
+		virtual void OnResourceAdded( const UntypedResourcePtr& resource ) override
+		{
+			if constexpr (Concepts::IndexedResource<R>)
+				mIndex.OnAdded( std::static_pointer_cast<const R>(resource) );
+			else
+				(void)resource;
+		}
+
+		virtual void OnResourceErased( const BaseResource& resource ) override
+		{
+			if constexpr (Concepts::IndexedResource<R>)
+				mIndex.OnErased( static_cast<const R&>(resource) );
+			else
+				(void)resource;
+		}
+
+		virtual ResourceDependents GetUnreferencedDependents( const BaseResource& resource ) const override
+		{
+			if constexpr (Concepts::CompositeResource<R>)
+				return static_cast<const R&>(resource).GetUnreferencedDependents();
+			else
+			{
+				(void)resource;
+				return {};
+			}
+		}
+
+		virtual void UncacheDependents( const BaseResource& resource ) override
+		{
+			if constexpr (Concepts::CompositeResource<R>)
+				static_cast<const R&>(resource).UncacheDependents();
+			else
+				(void)resource;
+		}
+
+	private:
+		[[no_unique_address]] typename detail::CacheIndexOf<R>::type mIndex;
 	};
 }
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "Concepts.hpp"
+#include "ResourceHandle.hpp"
+#include "ResourceId.hpp"
+
+namespace Avokii
+{
+	class BaseResource;
+
+	// Shared between every ResourceFuture waiting on the same asset, written by the ResourceManager on the main thread
+	struct AsyncLoadState
+	{
+		enum class Status
+		{
+			Pending,
+			Loaded,
+			Failed,
+		};
+
+		std::atomic<Status> status{ Status::Pending };
+		std::shared_ptr<const BaseResource> resource; // set before status becomes Loaded
+		ResourceId resource_id;
+	};
+
+	// Handle to a resource being loaded by ResourceManager::LoadAsync()
+	//
+	// Becomes ready during ResourceManager::ProcessAsyncLoads(), which Core calls once per frame.
+	template<Concepts::Resource R>
+	class ResourceFuture final
+	{
+	public:
+		ResourceFuture() = default;
+		explicit ResourceFuture( std::shared_ptr<const AsyncLoadState> state )
+			: mpState{ std::move( state ) }
+		{}
+
+		[[nodiscard]] bool IsValid() const noexcept { return mpState != nullptr; }
+		[[nodiscard]] bool IsReady() const noexcept { return IsValid() && (mpState->status.load( std::memory_order_acquire ) != AsyncLoadState::Status::Pending); }
+		[[nodiscard]] bool HasFailed() const noexcept { return IsValid() && (mpState->status.load( std::memory_order_acquire ) == AsyncLoadState::Status::Failed); }
+
+		[[nodiscard]] ResourceId GetResourceId() const noexcept { return IsValid() ? mpState->resource_id : ResourceId{}; }
+
+		// Null until the resource has loaded
+		[[nodiscard]] ResourceHandle<R> Get() const
+		{
+			if (!IsValid() || (mpState->status.load( std::memory_order_acquire ) != AsyncLoadState::Status::Loaded))
+				return nullptr;
+
+			// the state was filled in by R's cache
+			return std::static_pointer_cast<const R>(mpState->resource);
+		}
+
+	private:
+		std::shared_ptr<const AsyncLoadState> mpState;
+	};
+}
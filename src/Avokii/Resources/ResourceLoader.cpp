@@ -1,5 +1,7 @@
 #include "ResourceLoader.hpp"
-#include "ResourceLoader.hpp"
+
+#include "Avokii/File/FileOps.hpp"
+#include "ResourceManager.hpp"
 
 namespace Avokii
 {
@@ -13,4 +15,21 @@ namespace Avokii
 	ResourceLoader::~ResourceLoader()
 	{
 	}
+
+	std::optional<std::span<const std::byte>> ResourceLoader::GetData()
+	{
+		if (mDataFetched)
+			return mData;
+		mDataFetched = true;
+
+		mData = mManager.FindArchivedAsset( mAssetId );
+		if (!mData)
+		{
+			// loose file fallback
+			if (FileOps::ReadFile( Filepath{ mAssetId }, mLooseData ))
+				mData = std::span<const std::byte>{ mLooseData };
+		}
+
+		return mData;
+	}
 }
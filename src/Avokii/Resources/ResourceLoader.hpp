@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+
 #include "Avokii/File/Filepath.hpp"
 #include "Avokii/Resources/ResourceId.hpp"
 
@@ -18,6 +20,10 @@ namespace Avokii
 
 		ResourceManager& GetManager() const noexcept { return mManager; }
 
+		// Contents of the asset, a view into a mounted archive or the loose file read into the loader.
+		// Valid for the lifetime of the loader, nullopt if the asset couldn't be found.
+		std::optional<std::span<const std::byte>> GetData();
+
 	private:
 		ResourceLoader( ResourceManager& manager, StringView asset_id );
 		virtual ~ResourceLoader();
@@ -25,5 +31,9 @@ namespace Avokii
 		String mAssetId;
 		ResourceId mResourceId;
 		ResourceManager& mManager;
+
+		bool mDataFetched{ false };
+		std::optional<std::span<const std::byte>> mData;
+		std::vector<std::byte> mLooseData;
 	};
 }
@@ -1,30 +1,505 @@
 #include "ResourceManager.hpp"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "Avokii/Containers/FlatHashMap.hpp"
+#include "Avokii/File/AssetArchive.hpp"
+#include "Avokii/File/FileWatcher.hpp"
+#include "Avokii/Profiling/Profiler.hpp"
+
 namespace Avokii
 {
+	namespace
+	{
+		uint32_t GetAsyncWorkerCount()
+		{
+			// leave a core for the main thread, decoding images is CPU bound but past a handful of workers the disk is the limit
+			const uint32_t hardware_threads = std::thread::hardware_concurrency();
+			return std::clamp( (hardware_threads > 1) ? hardware_threads - 1 : 1u, 1u, 8u );
+		}
+	}
+
+	struct ResourceManager::AsyncData
+	{
+		struct Request
+		{
+			BaseResourceCache* cache = nullptr;
+			String asset_id;
+			std::shared_ptr<AsyncLoadState> state;
+			BaseResourceCache::Finaliser_T finaliser; // set by the worker, empty if decoding failed
+			bool reload = false; // hot reload of a cached resource, has no state
+		};
+
+		std::vector<std::thread> workers;
+
+		std::mutex decode_mutex;
+		std::condition_variable decode_available;
+		std::deque<Request> to_decode;
+		bool stopping = false;
+
+		std::mutex finalise_mutex;
+		std::condition_variable finalise_available;
+		std::vector<Request> to_finalise;
+
+		struct Preload
+		{
+			using EntryIdx_T = ResourceManifest::EntryIdx_T;
+
+			std::shared_ptr<PreloadProgress> progress;
+			std::vector<ResourceManifest::Entry> entries;
+			std::vector<BaseResourceCache*> caches;
+			std::vector<size_t> n_waiting; // dependencies not loaded yet
+			std::vector<std::vector<EntryIdx_T>> dependents;
+			std::vector<bool> failed;
+
+			std::vector<EntryIdx_T> ready;
+			std::vector<std::pair<EntryIdx_T, std::shared_ptr<const AsyncLoadState>>> loading;
+		};
+
+		// main thread only
+		FlatHashMap<AssetType, FlatHashMap<ResourceId, std::shared_ptr<AsyncLoadState>>> in_flight;
+		size_t n_in_flight = 0;
+		std::vector<Preload> preloads;
+
+		AsyncData()
+		{
+			const uint32_t n_workers = GetAsyncWorkerCount();
+			workers.reserve( n_workers );
+			for (uint32_t i = 0; i < n_workers; ++i)
+				workers.emplace_back( [this]() { WorkerMain(); } );
+		}
+
+		~AsyncData()
+		{
+			{
+				std::scoped_lock lock( decode_mutex );
+				stopping = true;
+			}
+			decode_available.notify_all();
+
+			for (auto& worker : workers)
+				worker.join();
+		}
+
+		void WorkerMain()
+		{
+			while (true)
+			{
+				Request request;
+				{
+					std::unique_lock lock( decode_mutex );
+					decode_available.wait( lock, [this]() { return stopping || !to_decode.empty(); } );
+					if (stopping)
+						return;
+
+					request = std::move( to_decode.front() );
+					to_decode.pop_front();
+				}
+
+				try
+				{
+					AV_PROFILE_SCOPE( "Decode resource" );
+					request.finaliser = request.cache->DecodeUntyped( request.asset_id );
+				}
+				catch (const std::exception& e)
+				{
+					AV_LOG_ERROR( LoggingChannels::Resource, "Exception while decoding asset '{}': '{}'", request.asset_id, e.what() );
+				}
+
+				{
+					std::scoped_lock lock( finalise_mutex );
+					to_finalise.push_back( std::move( request ) );
+				}
+				finalise_available.notify_one();
+			}
+		}
+	};
+
 	ResourceManager::ResourceManager( Core& r_core )
 		: mCore{ r_core }
+		, mMainThreadId{ std::this_thread::get_id() }
 	{
 	}
 
 	ResourceManager::~ResourceManager()
 	{
-		mCaches.clear();
+		// workers hold pointers to the caches
+		DisableHotReload();
+		mpAsync.reset();
+		for (auto& cache : mCaches)
+			cache.reset();
+		UnmountArchives();
+	}
+
+	bool ResourceManager::IsMainThread() const noexcept
+	{
+		return std::this_thread::get_id() == mMainThreadId;
+	}
+
+	bool ResourceManager::MountArchive( const Filepath& filepath )
+	{
+		auto archive = std::make_unique<AssetArchive>();
+		if (!archive->Open( filepath ))
+			return false;
+
+		std::unique_lock lock( mArchivesMutex );
+		mArchives.push_back( std::move( archive ) );
+		return true;
 	}
 
-	BaseResourceCache* ResourceManager::GetCacheInternal( const AssetType type )
+	void ResourceManager::UnmountArchives()
 	{
-		if (const auto found = mCaches.find( type ); found != std::end( mCaches ))
-			return found->second.get();
+		AV_ASSERT( GetPendingAsyncLoadCount() == 0, "Unmounting archives while assets are still loading from them" );
 
-		return nullptr;
+		std::unique_lock lock( mArchivesMutex );
+		mArchives.clear();
 	}
 
-	const BaseResourceCache* ResourceManager::GetCacheInternal( const AssetType type ) const
+	std::optional<std::span<const std::byte>> ResourceManager::FindArchivedAsset( StringView asset_id ) const
 	{
-		if (const auto found = mCaches.find( type ); found != std::end( mCaches ))
-			return found->second.get();
+		std::shared_lock lock( mArchivesMutex );
+		for (auto it = std::rbegin( mArchives ), last = std::rend( mArchives ); it != last; ++it)
+		{
+			if (auto found = (*it)->Find( asset_id ))
+				return found;
+		}
 
-		return nullptr;
+		return std::nullopt;
+	}
+
+	void ResourceManager::NextGeneration()
+	{
+		AV_PROFILE_SCOPE( "Resource generations" );
+
+		++mGeneration;
+		ForEachCache( []( BaseResourceCache& cache ) { cache.NextGeneration(); } );
+
+		if (mByteBudget == 0)
+			return;
+
+		size_t usage = GetUsage().GetTotal();
+		if (usage <= mByteBudget)
+			return;
+
+		std::vector<BaseResourceCache::EvictionCandidate> candidates;
+		ForEachCache( [&candidates]( BaseResourceCache& cache ) { cache.CollectEvictionCandidates( candidates ); } );
+
+		std::sort( std::begin( candidates ), std::end( candidates ), []( const auto& a, const auto& b ) { return a.generation < b.generation; } );
+
+		const size_t old_usage = usage;
+		for (const auto& candidate : candidates)
+		{
+			if (usage <= mByteBudget)
+				break;
+
+			// re-measured rather than subtracted, evicting a resource can evict its dependents from other caches
+			if (candidate.cache->Evict( candidate.resource_id ) > 0)
+				usage = GetUsage().GetTotal();
+		}
+
+		// still over when everything left is referenced, logged at trace as it repeats every frame
+		AV_LOG_TRACE( LoggingChannels::Resource, "Evicted {} bytes of resources to fit the budget of {} bytes, {} bytes remain", old_usage - usage, mByteBudget, usage );
+	}
+
+	ResourceFootprint ResourceManager::GetUsage() const noexcept
+	{
+		ResourceFootprint total;
+		ForEachCache( [&total]( const BaseResourceCache& cache )
+			{
+				const auto usage = cache.GetUsage();
+				total.cpu_bytes += usage.cpu_bytes;
+				total.gpu_bytes += usage.gpu_bytes;
+			} );
+
+		return total;
+	}
+
+	std::shared_ptr<const AsyncLoadState> ResourceManager::LoadAsyncInternal( BaseResourceCache& cache, StringView asset_id )
+	{
+		AV_ASSERT( IsMainThread(), "Resources are loaded on the main thread" );
+		const ResourceId resource_id{ ToResourceId( asset_id ) };
+
+		if (auto existing = cache.GetUntyped( resource_id ))
+		{
+			auto state = std::make_shared<AsyncLoadState>();
+			state->resource_id = resource_id;
+			state->resource = std::move( existing );
+			state->status.store( AsyncLoadState::Status::Loaded, std::memory_order_release );
+			return state;
+		}
+
+		// workers are only started once something is loaded asynchronously
+		if (!mpAsync)
+			mpAsync = std::make_unique<AsyncData>();
+
+		auto& pending = mpAsync->in_flight[cache.GetResourceType()];
+		if (const auto found = pending.find( resource_id ); found != std::end( pending ))
+			return found->second;
+
+		auto state = std::make_shared<AsyncLoadState>();
+		state->resource_id = resource_id;
+		pending.try_emplace( resource_id, state );
+		++mpAsync->n_in_flight;
+
+		{
+			std::scoped_lock lock( mpAsync->decode_mutex );
+			mpAsync->to_decode.push_back( AsyncData::Request{ &cache, String{ asset_id }, state, {} } );
+		}
+		mpAsync->decode_available.notify_one();
+
+		return state;
+	}
+
+	void ResourceManager::ProcessAsyncLoads()
+	{
+		AV_ASSERT( IsMainThread() );
+		if (!mpAsync || (mpAsync->n_in_flight == 0))
+			return;
+
+		AV_PROFILE_SCOPE( "Finalise async loads" );
+
+		std::vector<AsyncData::Request> finished;
+		{
+			std::scoped_lock lock( mpAsync->finalise_mutex );
+			finished.swap( mpAsync->to_finalise );
+		}
+
+		for (auto& request : finished)
+		{
+			if (request.reload)
+			{
+				bool reloaded = false;
+				try
+				{
+					reloaded = request.finaliser && request.cache->ReloadUntyped( request.asset_id, request.finaliser );
+				}
+				catch (const std::exception& e)
+				{
+					AV_LOG_ERROR( LoggingChannels::Resource, "Exception while reloading asset '{}': '{}'", request.asset_id, e.what() );
+				}
+
+				if (reloaded)
+					AV_LOG_INFO( LoggingChannels::Resource, "Reloaded '{}'", request.asset_id );
+				else
+					AV_LOG_WARN( LoggingChannels::Resource, "Failed to reload '{}', keeping the old version", request.asset_id );
+
+				--mpAsync->n_in_flight;
+				continue;
+			}
+
+			std::shared_ptr<const BaseResource> resource;
+			if (request.finaliser)
+			{
+				try
+				{
+					resource = request.cache->FinaliseUntyped( request.asset_id, request.finaliser );
+				}
+				catch (const std::exception& e)
+				{
+					AV_LOG_ERROR( LoggingChannels::Resource, "Exception while finalising asset '{}': '{}'", request.asset_id, e.what() );
+				}
+			}
+
+			auto& state = *request.state;
+			state.resource = resource;
+			state.status.store( resource ? AsyncLoadState::Status::Loaded : AsyncLoadState::Status::Failed, std::memory_order_release );
+
+			mpAsync->in_flight[request.cache->GetResourceType()].erase( state.resource_id );
+			--mpAsync->n_in_flight;
+		}
+
+		UpdatePreloads();
+	}
+
+	std::shared_ptr<const PreloadProgress> ResourceManager::Preload( const ResourceManifest& manifest )
+	{
+		AV_ASSERT( IsMainThread(), "Resources are loaded on the main thread" );
+		const auto& entries = manifest.GetEntries();
+
+		AsyncData::Preload preload;
+		preload.progress = std::make_shared<PreloadProgress>();
+		preload.progress->mTotal = entries.size();
+		preload.entries = entries;
+		preload.caches.reserve( entries.size() );
+		preload.n_waiting.resize( entries.size() );
+		preload.dependents.resize( entries.size() );
+		preload.failed.resize( entries.size() );
+
+		for (AsyncData::Preload::EntryIdx_T idx = 0; idx < entries.size(); ++idx)
+		{
+			const auto& entry = entries[idx];
+			auto* const cache = GetCacheInternal( entry.type );
+			if (!cache)
+				throw std::runtime_error( "Given resource type is not initialised for this ResourceManager" );
+
+			preload.caches.push_back( cache );
+			preload.n_waiting[idx] = entry.dependencies.size();
+			for (const auto dependency : entry.dependencies)
+				preload.dependents[dependency].push_back( idx );
+
+			if (entry.dependencies.empty())
+				preload.ready.push_back( idx );
+		}
+
+		if (!mpAsync)
+			mpAsync = std::make_unique<AsyncData>();
+
+		auto progress = preload.progress;
+		mpAsync->preloads.push_back( std::move( preload ) );
+		UpdatePreloads();
+
+		return progress;
+	}
+
+	void ResourceManager::UpdatePreloads()
+	{
+		if (!mpAsync || mpAsync->preloads.empty())
+			return;
+
+		for (auto& preload : mpAsync->preloads)
+		{
+			auto& progress = *preload.progress;
+
+			// resources that were already loaded finish immediately and can free up their dependents straight away
+			bool progressed = true;
+			while (progressed)
+			{
+				progressed = false;
+
+				for (const auto idx : std::exchange( preload.ready, {} ))
+					preload.loading.emplace_back( idx, LoadAsyncInternal( *preload.caches[idx], preload.entries[idx].asset_id ) );
+
+				for (size_t i = 0; i < preload.loading.size();)
+				{
+					const auto [idx, state] = preload.loading[i];
+					const auto status = state->status.load( std::memory_order_acquire );
+					if (status == AsyncLoadState::Status::Pending)
+					{
+						++i;
+						continue;
+					}
+
+					preload.loading[i] = std::move( preload.loading.back() );
+					preload.loading.pop_back();
+					progressed = true;
+
+					if (status == AsyncLoadState::Status::Loaded)
+					{
+						++progress.mLoaded;
+						for (const auto dependent : preload.dependents[idx])
+						{
+							if ((--preload.n_waiting[dependent] == 0) && !preload.failed[dependent])
+								preload.ready.push_back( dependent );
+						}
+						continue;
+					}
+
+					// everything depending on a failed resource is skipped
+					std::vector<AsyncData::Preload::EntryIdx_T> to_fail{ idx };
+					preload.failed[idx] = true;
+					while (!to_fail.empty())
+					{
+						const auto failed_idx = to_fail.back();
+						to_fail.pop_back();
+						++progress.mFailed;
+
+						for (const auto dependent : preload.dependents[failed_idx])
+						{
+							if (!preload.failed[dependent])
+							{
+								AV_LOG_WARN( LoggingChannels::Resource, "Skipping preloading '{}' as '{}' failed to load", preload.entries[dependent].asset_id, preload.entries[failed_idx].asset_id );
+								preload.failed[dependent] = true;
+								to_fail.push_back( dependent );
+							}
+						}
+					}
+				}
+			}
+
+			if (progress.IsDone())
+				AV_LOG_INFO( LoggingChannels::Resource, "Preloaded {} resources, {} failed", progress.GetLoaded(), progress.GetFailed() );
+		}
+
+		std::erase_if( mpAsync->preloads, []( const auto& preload ) { return preload.progress->IsDone(); } );
+	}
+
+	bool ResourceManager::EnableHotReload( const Filepath& directory )
+	{
+		auto watcher = std::make_unique<FileWatcher>( directory );
+		if (!watcher->IsWatching())
+			return false;
+
+		AV_LOG_INFO( LoggingChannels::Resource, "Hot reloading resources under '{}'", directory.generic_string() );
+		mFileWatchers.push_back( std::move( watcher ) );
+		return true;
+	}
+
+	void ResourceManager::DisableHotReload()
+	{
+		mFileWatchers.clear();
+	}
+
+	void ResourceManager::ProcessHotReloads()
+	{
+		if (mFileWatchers.empty())
+			return;
+
+		AV_PROFILE_SCOPE( "Hot reload" );
+
+		std::vector<AsyncData::Request> reloads;
+		for (auto& watcher : mFileWatchers)
+		{
+			for (const auto& path : watcher->PollChanges())
+			{
+				// asset ids are relative to the working directory, the watched directory may not be
+				std::error_code error;
+				Filepath relative_path = std::filesystem::proximate( path, error );
+				if (error)
+					relative_path = path;
+				const String asset_id = relative_path.lexically_normal().generic_string();
+				const ResourceId resource_id = ToResourceId( asset_id );
+				ForEachCache( [&]( BaseResourceCache& cache )
+					{
+						if (cache.IsReloadable() && cache.Exists( resource_id ))
+							reloads.push_back( AsyncData::Request{ &cache, asset_id, nullptr, {}, true } );
+					} );
+			}
+		}
+
+		if (reloads.empty())
+			return;
+
+		if (!mpAsync)
+			mpAsync = std::make_unique<AsyncData>();
+
+		// a whole batch is queued at once so the reloads land in the same frame where possible
+		mpAsync->n_in_flight += reloads.size();
+		{
+			std::scoped_lock lock( mpAsync->decode_mutex );
+			for (auto& request : reloads)
+				mpAsync->to_decode.push_back( std::move( request ) );
+		}
+		mpAsync->decode_available.notify_all();
+	}
+
+	void ResourceManager::WaitForAsyncLoads()
+	{
+		while (GetPendingAsyncLoadCount() > 0)
+		{
+			{
+				std::unique_lock lock( mpAsync->finalise_mutex );
+				mpAsync->finalise_available.wait( lock, [this]() { return !mpAsync->to_finalise.empty(); } );
+			}
+
+			ProcessAsyncLoads();
+		}
+	}
+
+	size_t ResourceManager::GetPendingAsyncLoadCount() const noexcept
+	{
+		return mpAsync ? mpAsync->n_in_flight : 0;
 	}
 }
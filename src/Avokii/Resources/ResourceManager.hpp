@@ -1,12 +1,24 @@
 #pragma once
 
+#include <array>
+#include <shared_mutex>
+#include <span>
+#include <thread>
+
+#include "Avokii/File/Filepath.hpp"
+
 #include "Concepts.hpp"
 #include "ResourceId.hpp"
 #include "ResourceHandle.hpp"
 #include "ResourceCache.hpp"
+#include "ResourceFuture.hpp"
+#include "ResourceManifest.hpp"
+#include "ResourceTypes.hpp"
 
 namespace Avokii
 {
+	class AssetArchive;
+	class FileWatcher;
 	class Core;
 	enum class AssetType;
 	class BaseResource;
@@ -14,7 +26,8 @@ namespace Avokii
 
 	class ResourceManager final
 	{
-		using CacheCollection_T = std::unordered_map<AssetType, std::unique_ptr<BaseResourceCache>>;
+		// indexed by AssetType, the cache at an index is always a ResourceCache of the resource with that type
+		using CacheCollection_T = std::array<std::unique_ptr<BaseResourceCache>, AssetTypeCount>;
 
 	public:
 		explicit ResourceManager( Core& core );
@@ -25,14 +38,17 @@ namespace Avokii
 		{
 			constexpr AssetType type{ R::GetResourceType() };
 
+			static_assert(static_cast<size_t>( type ) < AssetTypeCount);
+
 			if (const auto* existing_cache = GetCacheInternal( type ))
 				throw std::runtime_error( "ResourceCache already initialised for this type of resource" );
 
-			auto [it, success] = mCaches.try_emplace( type, std::make_unique<ResourceCache<R>>( *this ) );
-			if (!success)
-				throw std::runtime_error( "Failed to store ResourceCache of given type" );
+			mCaches[static_cast<size_t>( type )] = std::make_unique<ResourceCache<R>>( *this );
 		}
 
+		template<Concepts::Resource R>
+		[[nodiscard]] bool IsInitialised() const noexcept { return GetCacheInternal( R::GetResourceType() ) != nullptr; }
+
 		template<Concepts::Resource R>
 		[[nodiscard]] bool Exists( ResourceId resource_id ) const noexcept { return GetCache<R>().Exists( resource_id ); }
 
@@ -45,20 +61,65 @@ namespace Avokii
 		template<Concepts::Resource R>
 		[[nodiscard]] ResourceHandle<const R> GetOrLoad( StringView asset_id )
 		{
+			AV_ASSERT( IsMainThread(), "Resources are loaded on the main thread" );
 			if (auto found = Get<R>( ToResourceId( asset_id ) ))
 				return found;
 
 			return Load<R>( asset_id );
 		}
 
+		// Loading and finishing loads is main thread only, with pipelined rendering that excludes the game's updates
+		template<Concepts::Resource R>
+		ResourceHandle<const R> Load( StringView asset_id )
+		{
+			AV_ASSERT( IsMainThread(), "Resources are loaded on the main thread" );
+			return rGetCache<R>().Load( asset_id );
+		}
+
+		// Loads on a worker thread, finished on the main thread by ProcessAsyncLoads().
+		// Requests for an asset that is already loading share the same load, already loaded assets are ready immediately.
+		template<Concepts::Resource R>
+		ResourceFuture<R> LoadAsync( StringView asset_id ) { return ResourceFuture<R>( LoadAsyncInternal( rGetCache<R>(), asset_id ) ); }
+
+		// Loads every resource in the manifest asynchronously, each once its dependencies have loaded.
+		// Progresses in ProcessAsyncLoads(), WaitForAsyncLoads() blocks until it's done. Throws if a resource type isn't initialised.
+		std::shared_ptr<const PreloadProgress> Preload( const ResourceManifest& manifest );
+
+		// Finishes the asynchronous loads whose worker half is done, main thread only
+		void ProcessAsyncLoads();
+		// Blocks until every asynchronous load has finished
+		void WaitForAsyncLoads();
+		[[nodiscard]] size_t GetPendingAsyncLoadCount() const noexcept;
+
+		// Adds resources that were created rather than loaded, each must be an R
+		template<Concepts::Resource R>
+		size_t AddResources( std::span<BaseResourceCache::NewResource> resources ) { return rGetCache<R>().AddResources( resources ); }
+
+		template<Concepts::Resource R>
+		void Unload( ResourceId resource_id ) { rGetCache<R>().Unload( resource_id ); }
+
 		template<Concepts::Resource R>
-		ResourceHandle<const R> Load( StringView asset_id ) { return rGetCache<R>().Load( asset_id ); }
+		void Purge( size_t minGenerations = 3 ) { rGetCache<R>().Purge( minGenerations ); }
 
+		// Evicts those of `resource_ids` that nothing outside the cache references and `pred` accepts, see Concepts::CompositeResource
+		template<Concepts::Resource R, std::predicate<const BaseResource&> Pred>
+		void EvictUnreferenced( std::span<const ResourceId> resource_ids, Pred&& pred ) { rGetCache<R>().EvictUnreferenced( resource_ids, std::forward<Pred>( pred ) ); }
+
+		// Advances every cache's generation and evicts down to the byte budgets, called by Core once per frame
+		void NextGeneration();
+		// Incremented by NextGeneration()
+		[[nodiscard]] size_t GetGeneration() const noexcept { return mGeneration; }
+
+		// Budget over every cache, 0 for no budget. Evicts across caches least recently used first.
+		void SetByteBudget( size_t bytes ) noexcept { mByteBudget = bytes; }
+		[[nodiscard]] size_t GetByteBudget() const noexcept { return mByteBudget; }
+		// Budget for a single cache, 0 for no budget
 		template<Concepts::Resource R>
-		void Unload( ResourceId resource_id ) { GetCache<R>().Unload( resource_id ); }
+		void SetByteBudget( size_t bytes ) { rGetCache<R>().SetByteBudget( bytes ); }
 
+		[[nodiscard]] ResourceFootprint GetUsage() const noexcept;
 		template<Concepts::Resource R>
-		void Purge( size_t minGenerations = 3 ) { GetCache<R>().Purge( minGenerations ); }
+		[[nodiscard]] ResourceFootprint GetUsage() const { return GetCache<R>().GetUsage(); }
 
 		template<Concepts::Resource R>
 		[[nodiscard]] const ResourceCache<R>& GetCache() const
@@ -66,11 +127,29 @@ namespace Avokii
 			constexpr AssetType type{ R::GetResourceType() };
 
 			if (const auto* cache = GetCacheInternal( type ))
-				return *dynamic_cast<const ResourceCache<R>*>(cache);
+			{
+				AV_ASSERT( dynamic_cast<const ResourceCache<R>*>(cache), "Another resource was initialised with this resource's type" );
+				return static_cast<const ResourceCache<R>&>(*cache);
+			}
 
 			throw std::runtime_error( "Given resource type is not initialised for this ResourceManager" );
 		}
 
+		// Archives are searched newest first, assets not in any archive are read from loose files.
+		// Mount before loading starts, views into an archive are invalidated when it's unmounted.
+		bool MountArchive( const Filepath& filepath );
+		void UnmountArchives();
+		// Safe to call from any thread
+		[[nodiscard]] std::optional<std::span<const std::byte>> FindArchivedAsset( StringView asset_id ) const;
+
+		// Watches `directory` and reloads cached resources in place when their files change, so existing handles see the new data.
+		// Only types with a ReloadFrom() are reloaded (Concepts::ReloadableResource), and only loose files as archives take precedence.
+		bool EnableHotReload( const Filepath& directory );
+		void DisableHotReload();
+		// Queues reloads for the files that changed, main thread only. They're decoded on the asynchronous load workers
+		// and swapped in by ProcessAsyncLoads().
+		void ProcessHotReloads();
+
 		Core& rGetCore() noexcept { return mCore; }
 		const Core& GetCore() const noexcept { return mCore; }
 
@@ -81,16 +160,63 @@ namespace Avokii
 			constexpr AssetType type{ R::GetResourceType() };
 
 			if (auto* cache = GetCacheInternal( type ))
-				return *dynamic_cast<ResourceCache<R>*>(cache);
+			{
+				AV_ASSERT( dynamic_cast<ResourceCache<R>*>(cache), "Another resource was initialised with this resource's type" );
+				return static_cast<ResourceCache<R>&>(*cache);
+			}
 
 			throw std::runtime_error( "Given resource type is not initialised for this ResourceManager" );
 		}
 
-		BaseResourceCache* GetCacheInternal( const AssetType type );
-		const BaseResourceCache* GetCacheInternal( const AssetType type ) const;
+		BaseResourceCache* GetCacheInternal( const AssetType type ) noexcept
+		{
+			const auto idx = static_cast<size_t>( type );
+			return (idx < mCaches.size()) ? mCaches[idx].get() : nullptr;
+		}
+		const BaseResourceCache* GetCacheInternal( const AssetType type ) const noexcept
+		{
+			const auto idx = static_cast<size_t>( type );
+			return (idx < mCaches.size()) ? mCaches[idx].get() : nullptr;
+		}
+
+		template<class Func>
+		void ForEachCache( Func&& func )
+		{
+			for (auto& cache : mCaches)
+			{
+				if (cache)
+					func( *cache );
+			}
+		}
+		template<class Func>
+		void ForEachCache( Func&& func ) const
+		{
+			for (const auto& cache : mCaches)
+			{
+				if (cache)
+					func( static_cast<const BaseResourceCache&>(*cache) );
+			}
+		}
+
+		std::shared_ptr<const AsyncLoadState> LoadAsyncInternal( BaseResourceCache& cache, StringView asset_id );
+		[[nodiscard]] bool IsMainThread() const noexcept;
+		// Starts the preload entries whose dependencies have finished, until no more can start this frame
+		void UpdatePreloads();
 
 	private:
 		CacheCollection_T mCaches;
 		Core& mCore;
+		const std::thread::id mMainThreadId; // whichever thread constructs the manager
+
+		size_t mByteBudget = 0;
+		size_t mGeneration = 0;
+
+		std::vector<std::unique_ptr<AssetArchive>> mArchives;
+		mutable std::shared_mutex mArchivesMutex;
+
+		struct AsyncData;
+		std::unique_ptr<AsyncData> mpAsync;
+
+		std::vector<std::unique_ptr<FileWatcher>> mFileWatchers;
 	};
 }
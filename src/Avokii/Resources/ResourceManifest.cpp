@@ -0,0 +1,95 @@
+#include "ResourceManifest.hpp"
+
+#include "Avokii/File/FileOps.hpp"
+#include "Avokii/Utility/Yaml.hpp"
+
+namespace Avokii
+{
+	ResourceManifest::EntryIdx_T ResourceManifest::Add( AssetType type, StringView asset_id, std::span<const EntryIdx_T> dependencies )
+	{
+		const auto idx = static_cast<EntryIdx_T>( mEntries.size() );
+		for (const auto dependency : dependencies)
+		{
+			AV_ASSERT( dependency < idx, "Dependencies have to be added before the resources that need them" );
+			if (dependency >= idx)
+				throw std::out_of_range( "Resource manifest dependency isn't an earlier entry" );
+		}
+
+		mEntries.push_back( Entry{ type, String{ asset_id }, { std::begin( dependencies ), std::end( dependencies ) } } );
+		return idx;
+	}
+
+	bool ResourceManifest::LoadFromYaml( StringView yaml_string )
+	{
+		// parsed into a copy so a bad manifest adds nothing
+		auto entries = mEntries;
+		const auto find_earlier = [&entries]( StringView asset_id ) -> std::optional<EntryIdx_T>
+		{
+			for (size_t i = entries.size(); i > 0; --i)
+			{
+				if (entries[i - 1].asset_id == asset_id)
+					return static_cast<EntryIdx_T>( i - 1 );
+			}
+			return std::nullopt;
+		};
+
+		try
+		{
+			const auto root = YAML::Load( String{ yaml_string } );
+			if (!root.IsSequence())
+			{
+				AV_LOG_ERROR( LoggingChannels::Resource, "Resource manifest isn't a list of resources" );
+				return false;
+			}
+
+			for (const auto& node : root)
+			{
+				const auto type_name = node["type"].as<String>();
+				const auto type = magic_enum::enum_cast<AssetType>( type_name );
+				if (!type)
+				{
+					AV_LOG_ERROR( LoggingChannels::Resource, "Unknown resource type '{}' in resource manifest", type_name );
+					return false;
+				}
+
+				Entry entry{ *type, node["id"].as<String>(), {} };
+				if (const auto depends = node["depends"])
+				{
+					for (const auto& dependency : depends)
+					{
+						const auto dependency_id = dependency.as<String>();
+						const auto found = find_earlier( dependency_id );
+						if (!found)
+						{
+							AV_LOG_ERROR( LoggingChannels::Resource, "'{}' depends on '{}' which isn't listed before it in the resource manifest", entry.asset_id, dependency_id );
+							return false;
+						}
+						entry.dependencies.push_back( *found );
+					}
+				}
+
+				entries.push_back( std::move( entry ) );
+			}
+		}
+		catch (const YAML::Exception& e)
+		{
+			AV_LOG_ERROR( LoggingChannels::Resource, "Failed to parse resource manifest: '{}'", e.what() );
+			return false;
+		}
+
+		mEntries = std::move( entries );
+		return true;
+	}
+
+	bool ResourceManifest::LoadFromFile( const Filepath& filepath )
+	{
+		String yaml_string;
+		if (!FileOps::ReadFile( filepath, yaml_string ))
+		{
+			AV_LOG_ERROR( LoggingChannels::Resource, "Failed to read resource manifest '{}'", filepath.generic_string() );
+			return false;
+		}
+
+		return LoadFromYaml( yaml_string );
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <span>
+
+#include "Avokii/File/Filepath.hpp"
+
+#include "Concepts.hpp"
+#include "ResourceTypes.hpp"
+
+namespace Avokii
+{
+	// Resources to load up front along with what each needs loaded first, run by ResourceManager::Preload().
+	//
+	// Resources whose dependencies have loaded are decoded in parallel on the asynchronous load workers,
+	// so a manifest loads in roughly as many steps as its longest chain of dependencies.
+	// Dependencies have to be added before the resources that need them, which also rules out cycles.
+	//
+	// YAML format, a list of resources:
+	//   - { type: Texture, id: assets/tiles.png }
+	//   - { type: SpriteSheet, id: assets/tiles.json, depends: [ assets/tiles.png ] }
+	class ResourceManifest final
+	{
+	public:
+		using EntryIdx_T = uint32_t;
+
+		struct Entry
+		{
+			AssetType type;
+			String asset_id;
+			std::vector<EntryIdx_T> dependencies; // all before this entry
+		};
+
+		EntryIdx_T Add( AssetType type, StringView asset_id, std::span<const EntryIdx_T> dependencies = {} );
+		template<Concepts::Resource R>
+		EntryIdx_T Add( StringView asset_id, std::span<const EntryIdx_T> dependencies = {} ) { return Add( R::GetResourceType(), asset_id, dependencies ); }
+
+		// Appends the resources listed, dependencies are looked up by asset id among the entries before them
+		bool LoadFromYaml( StringView yaml_string );
+		bool LoadFromFile( const Filepath& filepath );
+
+		[[nodiscard]] const std::vector<Entry>& GetEntries() const noexcept { return mEntries; }
+		[[nodiscard]] size_t GetSize() const noexcept { return mEntries.size(); }
+		[[nodiscard]] bool IsEmpty() const noexcept { return mEntries.empty(); }
+
+	private:
+		std::vector<Entry> mEntries;
+	};
+
+	// How far through a ResourceManager::Preload() is, updated on the main thread by ResourceManager::ProcessAsyncLoads()
+	class PreloadProgress final
+	{
+	public:
+		[[nodiscard]] size_t GetTotal() const noexcept { return mTotal; }
+		[[nodiscard]] size_t GetLoaded() const noexcept { return mLoaded; }
+		// Includes resources skipped because a dependency failed
+		[[nodiscard]] size_t GetFailed() const noexcept { return mFailed; }
+
+		[[nodiscard]] bool IsDone() const noexcept { return (mLoaded + mFailed) == mTotal; }
+		[[nodiscard]] float GetFraction() const noexcept { return (mTotal > 0) ? static_cast<float>(mLoaded + mFailed) / static_cast<float>(mTotal) : 1.f; }
+
+	private:
+		friend class ResourceManager;
+
+		size_t mTotal = 0;
+		size_t mLoaded = 0;
+		size_t mFailed = 0;
+	};
+}
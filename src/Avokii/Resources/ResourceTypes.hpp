@@ -15,5 +15,7 @@ namespace Avokii
 		Sprite,
 	};
 
+	inline constexpr size_t AssetTypeCount = magic_enum::enum_count<AssetType>();
+
 	constexpr std::string_view GetAssetTypeName( const AssetType type ) noexcept { return magic_enum::enum_name( type ); }
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace Avokii
 {
 	struct Timestep
@@ -15,12 +17,16 @@ namespace Avokii
 
 	struct PreciseTimestep
 	{
-		double time;
+		double time; // fixed updates: simulated time, step * delta. Otherwise seconds since Core::Dispatch() started.
 		double delta;
+		uint64_t step; // fixed updates: the step's index. Otherwise the number of fixed steps run so far.
+		double alpha; // how far real time has got from the last fixed step towards the next, 0-1, for interpolating between them
 
-		PreciseTimestep( double time = 0.f, double delta_time = 0.f )
+		PreciseTimestep( double time = 0.f, double delta_time = 0.f, uint64_t step = 0, double alpha = 0.0 )
 			: time( time )
 			, delta( delta_time )
+			, step( step )
+			, alpha( alpha )
 		{}
 
 		operator Timestep() const { return Timestep( (float)time, (float)delta ); }